@@ -38,7 +38,88 @@ DEFINE_uint64(max_nodes,
 
 DEFINE_string(out_dir, ".", "The location the csv will be saved at");
 
+DEFINE_string(ordering,
+              "median",
+              "The vertex ordering heuristic, `median` (median + transpose) "
+              "or `sifting`");
+
+DEFINE_string(coordinates,
+              "priority",
+              "The x coordinate assignment, `priority` or `brandes-kopf`");
+
+DEFINE_uint64(concentrate,
+              0,
+              "Merges the incoming edges of nodes with at least `concentrate` "
+              "predecessors, 0 disables edge concentration");
+
+DEFINE_uint64(threads,
+              0,
+              "The number of threads laying out the SESE regions, 0 and 1 "
+              "lay them out on the main thread");
+
+DEFINE_bool(cache,
+            false,
+            "Reuses the layout of structurally identical regions across the "
+            "functions of the module");
+
+DEFINE_bool(batch,
+            false,
+            "Lays the functions of the module out concurrently with "
+            "`layout_batch`, on a thread per core");
+
+DEFINE_bool(context,
+            false,
+            "Reuses the memory of the transient buffers across the functions "
+            "laid out on a thread, with a `LayoutContext`");
+
+DEFINE_string(cache_dir,
+              "",
+              "Reads the layouts from this directory and stores them in it, "
+              "across runs of the bench. Empty disables the disk cache");
+
+DEFINE_uint64(budget_ms,
+              0,
+              "The time each function may take to lay out, the layout stops "
+              "early and keeps its best result once it is over. 0 for no "
+              "limit");
+
 namespace {
+/// @brief Reads the layout options from the command line flags
+auto parse_layout_options() -> std::optional<triskel::LayoutOptions> {
+    auto options = triskel::LayoutOptions{};
+
+    if (FLAGS_ordering == "median") {
+        options.ordering = triskel::LayoutOptions::Ordering::MedianTranspose;
+    } else if (FLAGS_ordering == "sifting") {
+        options.ordering = triskel::LayoutOptions::Ordering::Sifting;
+    } else {
+        fmt::print("Unknown vertex ordering: {}\n", FLAGS_ordering);
+        return {};
+    }
+
+    if (FLAGS_coordinates == "priority") {
+        options.coordinates = triskel::LayoutOptions::Coordinates::Priority;
+    } else if (FLAGS_coordinates == "brandes-kopf") {
+        options.coordinates = triskel::LayoutOptions::Coordinates::BrandesKopf;
+    } else {
+        fmt::print("Unknown coordinate assignment: {}\n", FLAGS_coordinates);
+        return {};
+    }
+
+    options.concentration_threshold = FLAGS_concentrate;
+    options.threads                 = FLAGS_threads;
+    options.cache_regions           = FLAGS_cache;
+
+    options.budget = std::chrono::milliseconds{FLAGS_budget_ms};
+
+    return options;
+}
+
+triskel::LayoutOptions layout_options;
+
+/// @brief Set by `--cache_dir`
+std::unique_ptr<triskel::DiskCache> disk_cache;
+
 struct ProgressBar {
     explicit ProgressBar(size_t size) : size_{size} {}
 
@@ -205,7 +286,7 @@ auto count_overlaps(const std::vector<Segment>& verticals,
     return overlaps;
 }
 
-auto measure_segments(triskel::CFGLayout& layout) -> SegmentMetrics {
+auto measure_segments(const triskel::CFGLayout& layout) -> SegmentMetrics {
     auto verticals   = std::vector<Segment>{};
     auto horizontals = std::vector<Segment>{};
 
@@ -213,8 +294,12 @@ auto measure_segments(triskel::CFGLayout& layout) -> SegmentMetrics {
     verticals.reserve(2 * layout.edge_count());
     horizontals.reserve(layout.edge_count());
 
+    const auto offsets       = layout.waypoint_offsets();
+    const auto all_waypoints = layout.waypoints();
+
     for (size_t edge_id = 0; edge_id < layout.edge_count(); ++edge_id) {
-        const auto& waypoints = layout.get_waypoints(edge_id);
+        const auto waypoints = all_waypoints.subspan(
+            offsets[edge_id], offsets[edge_id + 1] - offsets[edge_id]);
 
         if (waypoints.empty()) {
             throw std::invalid_argument("Edge was not laid out");
@@ -280,6 +365,14 @@ struct Stats {
     size_t nb_intersections;
     size_t nb_overlaps;
     size_t nb_segments;
+    size_t nb_dummies;
+    size_t ordering_time;  // in us
+    size_t cache_hits;
+    size_t cache_misses;
+    bool truncated;
+    size_t scratch_allocations;
+    size_t scratch_heap_allocations;
+    bool from_disk_cache;
 };
 
 auto stats_to_csv(const std::vector<Stats>& stats) {
@@ -287,14 +380,20 @@ auto stats_to_csv(const std::vector<Stats>& stats) {
 
     // header
     s = "function_name,nb_nodes,nb_edges,height,width,layout_time,nb_"
-        "intersections,nb_overlaps,nb_segments\n";
+        "intersections,nb_overlaps,nb_segments,nb_dummies,ordering_time,"
+        "cache_hits,cache_misses,truncated,scratch_allocations,scratch_"
+        "heap_allocations,from_disk_cache\n";
 
     // body
     for (const auto& stat : stats) {
-        s += fmt::format("{},{},{},{},{},{},{},{},{}\n", stat.function_name,
-                         stat.nb_nodes, stat.nb_edges, stat.height, stat.width,
-                         stat.layout_time, stat.nb_intersections,
-                         stat.nb_overlaps, stat.nb_segments);
+        s += fmt::format("{},{},{},{},{},{},{},{},{},{},{},{},{},{},{},{},{}\n",
+                         stat.function_name, stat.nb_nodes, stat.nb_edges,
+                         stat.height, stat.width, stat.layout_time,
+                         stat.nb_intersections, stat.nb_overlaps,
+                         stat.nb_segments, stat.nb_dummies, stat.ordering_time,
+                         stat.cache_hits, stat.cache_misses, stat.truncated,
+                         stat.scratch_allocations,
+                         stat.scratch_heap_allocations, stat.from_disk_cache);
     }
 
     return s;
@@ -314,52 +413,118 @@ auto write_str_to_file(const std::string& path, const std::string& data) {
     return 0;
 }
 
-auto run_on_function(llvm::Function& function,
-                     size_t& errors,
-                     size_t& skipped,
-                     llvm::ModuleSlotTracker& MST) -> std::optional<Stats> {
+/// @brief Whether the function is left out of the benchmark
+auto is_skipped(const llvm::Function& function, size_t& skipped) -> bool {
     if (function.isDeclaration()) {
-        return {};
+        return true;
     }
 
     // Ignore functions with less then 3 blocks
     if (function.size() <= 2) {
-        return {};
+        return true;
     }
 
     // Skip long functions
     if (FLAGS_max_nodes != 0 && function.size() > FLAGS_max_nodes) {
         skipped += 1;
-        return {};
+        return true;
     }
 
-    std::unique_ptr<triskel::CFGLayout> layout;
+    return false;
+}
 
+/// @brief Measures the layout of a function laid out in `elapsed`
+auto measure_layout(const llvm::Function& function,
+                    const triskel::CFGLayout& layout,
+                    std::chrono::nanoseconds elapsed) -> Stats {
     // NOLINTNEXTLINE(google-build-using-namespace)
     using namespace std::chrono;
 
-    const auto start = high_resolution_clock::now();
-
-    layout = triskel::make_layout(&function, nullptr, &MST);
-
-    const auto elapsed    = high_resolution_clock::now() - start;
     const auto elapsed_ms = duration_cast<milliseconds>(elapsed).count();
 
-    const auto segment_stats = measure_segments(*layout);
+    const auto segment_stats = measure_segments(layout);
+    const auto& layout_stats = layout.get_stats();
 
     return Stats{
-        .function_name    = function.getName().str(),
-        .nb_nodes         = layout->node_count(),
-        .nb_edges         = layout->edge_count(),
-        .height           = layout->get_height(),
-        .width            = layout->get_width(),
-        .layout_time      = static_cast<size_t>(elapsed_ms),
-        .nb_intersections = segment_stats.intersections,
-        .nb_overlaps      = segment_stats.overlaps,
-        .nb_segments      = segment_stats.count,
+        .function_name            = function.getName().str(),
+        .nb_nodes                 = layout.node_count(),
+        .nb_edges                 = layout.edge_count(),
+        .height                   = layout.get_height(),
+        .width                    = layout.get_width(),
+        .layout_time              = static_cast<size_t>(elapsed_ms),
+        .nb_intersections         = segment_stats.intersections,
+        .nb_overlaps              = segment_stats.overlaps,
+        .nb_segments              = segment_stats.count,
+        .nb_dummies               = layout_stats.dummy_count,
+        .ordering_time            = static_cast<size_t>(
+            duration_cast<microseconds>(layout_stats.ordering_time).count()),
+        .cache_hits               = layout_stats.cache_hits,
+        .cache_misses             = layout_stats.cache_misses,
+        .truncated                = layout_stats.truncated,
+        .scratch_allocations      = layout_stats.scratch_allocations,
+        .scratch_heap_allocations = layout_stats.scratch_heap_allocations,
+        .from_disk_cache          = layout_stats.from_disk_cache,
     };
 }
 
+auto run_on_function(llvm::Function& function,
+                     size_t& errors,
+                     size_t& skipped,
+                     llvm::ModuleSlotTracker& MST) -> std::optional<Stats> {
+    if (is_skipped(function, skipped)) {
+        return {};
+    }
+
+    // Shared by the functions, laid out one after the other
+    static auto context = triskel::LayoutContext{};
+
+    const auto start = std::chrono::high_resolution_clock::now();
+
+    auto builder =
+        triskel::make_layout_builder(&function, nullptr, &MST, layout_options);
+    auto layout = FLAGS_context ? builder->build(context) : builder->build();
+
+    const auto elapsed = std::chrono::high_resolution_clock::now() - start;
+
+    return measure_layout(function, *layout, elapsed);
+}
+
+/// @brief Lays the functions out with `layout_batch`. The builders are made
+/// on the calling thread, printing the instructions isn't thread safe
+auto run_batch(llvm::Module& module,
+               size_t& errors,
+               size_t& skipped,
+               llvm::ModuleSlotTracker& MST) -> std::vector<Stats> {
+    auto functions = std::vector<llvm::Function*>{};
+    auto builders  = std::vector<std::unique_ptr<triskel::LayoutBuilder>>{};
+
+    for (auto& function : module) {
+        if (is_skipped(function, skipped)) {
+            continue;
+        }
+
+        functions.push_back(&function);
+        builders.push_back(triskel::make_layout_builder(
+            &function, nullptr, &MST, layout_options));
+    }
+
+    const auto results = triskel::layout_batch(builders);
+
+    auto stats = std::vector<Stats>{};
+    stats.reserve(results.size());
+    for (size_t i = 0; i < results.size(); ++i) {
+        if (!results[i].ok()) {
+            errors += 1;
+            continue;
+        }
+
+        stats.push_back(
+            measure_layout(*functions[i], *results[i].layout, results[i].time));
+    }
+
+    return stats;
+}
+
 auto run_on_module(llvm::Module& module,
                    llvm::ModuleSlotTracker& MST) -> std::vector<Stats> {
     fmt::print("Running on module: {}\n", module.getName().str());
@@ -373,26 +538,50 @@ auto run_on_module(llvm::Module& module,
     size_t overlaps      = 0;
     size_t segments      = 0;
     size_t heights       = 0;
+    size_t dummies       = 0;
+    size_t ordering_time = 0;
+    size_t cache_hits    = 0;
+    size_t cache_misses  = 0;
+    size_t truncated     = 0;
+    size_t scratch       = 0;
+    size_t heap          = 0;
 
     auto start = std::chrono::high_resolution_clock::now();
 
-    auto bar = ProgressBar(module.size());
-    bar.start();
-    for (auto& function : module) {
-        bar.draw();
-        auto stat = run_on_function(function, errors, skipped, MST);
-        if (stat.has_value()) {
-            intersections += stat->nb_intersections;
-            overlaps += stat->nb_overlaps;
-            segments += stat->nb_segments;
-            heights += stat->height;
-            stats.push_back(*stat);
-        };
+    if (FLAGS_batch) {
+        stats = run_batch(module, errors, skipped, MST);
+    } else {
+        auto bar = ProgressBar(module.size());
+        bar.start();
+        for (auto& function : module) {
+            bar.draw();
+            auto stat = run_on_function(function, errors, skipped, MST);
+            if (stat.has_value()) {
+                stats.push_back(*stat);
+            };
+        }
+        bar.end();
+    }
+
+    for (const auto& stat : stats) {
+        intersections += stat.nb_intersections;
+        overlaps += stat.nb_overlaps;
+        segments += stat.nb_segments;
+        heights += stat.height;
+        dummies += stat.nb_dummies;
+        ordering_time += stat.ordering_time;
+        cache_hits += stat.cache_hits;
+        cache_misses += stat.cache_misses;
+        truncated += stat.truncated ? 1 : 0;
+        scratch += stat.scratch_allocations;
+        heap += stat.scratch_heap_allocations;
     }
-    bar.end();
 
     auto elapsed = std::chrono::high_resolution_clock::now() - start;
 
+    const auto disk_hits   = disk_cache != nullptr ? disk_cache->hits() : 0;
+    const auto disk_misses = disk_cache != nullptr ? disk_cache->misses() : 0;
+
     std::locale::global(std::locale("en_US.UTF-8"));
 
     fmt::print("\n\nSummary:\n\n");
@@ -403,7 +592,16 @@ auto run_on_module(llvm::Module& module,
                 Entry("Segments", segments, "{:L}"),             //
                 Entry("Intersections", intersections, "{:L}"),   //
                 Entry("Overlaps", overlaps, "{:L}"),             //
-                Entry("Height", heights / stats.size(), "{:L}")  //
+                Entry("Height", heights / stats.size(), "{:L}"),  //
+                Entry("Dummies", dummies, "{:L}"),                //
+                Entry("Ordering (ms)", ordering_time / 1000, "{:L}"),  //
+                Entry("Cache hits", cache_hits, "{:L}"),                //
+                Entry("Cache misses", cache_misses, "{:L}"),            //
+                Entry("Truncated", truncated, "{:L}"),                  //
+                Entry("Scratch allocations", scratch, "{:L}"),          //
+                Entry("Scratch heap allocs", heap, "{:L}"),             //
+                Entry("Disk cache hits", disk_hits, "{:L}"),            //
+                Entry("Disk cache misses", disk_misses, "{:L}")         //
     );
 
     return stats;
@@ -422,6 +620,17 @@ auto main(int argc, char** argv) -> int {
         return 1;
     }
 
+    auto options = parse_layout_options();
+    if (!options.has_value()) {
+        return 1;
+    }
+    layout_options = *options;
+
+    if (!FLAGS_cache_dir.empty()) {
+        disk_cache = std::make_unique<triskel::DiskCache>(FLAGS_cache_dir);
+        layout_options.disk_cache = disk_cache.get();
+    }
+
     llvm::LLVMContext ctx;
 
     auto module = load_module_from_path(ctx, argv[1]);
@@ -19,7 +19,11 @@ EMSCRIPTEN_BINDINGS(my_module) {
         .function("get_height", &triskel::CFGLayout::get_height)
         .function("get_width", &triskel::CFGLayout::get_width)
         .function("get_coords", &triskel::CFGLayout::get_coords)
-        .function("get_waypoints", &triskel::CFGLayout::get_waypoints);
+        .function("get_waypoints",
+                  emscripten::optional_override(
+                      [](const triskel::CFGLayout& layout, size_t edge) {
+                          return layout.get_waypoints(edge).to_vector();
+                      }));
 
     emscripten::class_<triskel::LayoutBuilder>("LayoutBuilder")
         .function("build", &triskel::LayoutBuilder::build)
@@ -33,5 +37,8 @@ EMSCRIPTEN_BINDINGS(my_module) {
                   emscripten::select_overload<size_t(size_t, size_t)>(
                       &triskel::LayoutBuilder::make_edge));
 
-    emscripten::function("make_layout_builder", &triskel::make_layout_builder);
+    emscripten::function(
+        "make_layout_builder",
+        emscripten::select_overload<std::unique_ptr<triskel::LayoutBuilder>()>(
+            &triskel::make_layout_builder));
 }
\ No newline at end of file
@@ -1,4 +1,5 @@
 #include <pybind11/pybind11.h>
+#include <pybind11/stl.h>
 #include <cstddef>
 #include "triskel/triskel.hpp"
 #include "triskel/utils/point.hpp"
@@ -30,12 +31,32 @@ PYBIND11_MODULE(pytriskel, m) {
     py::class_<triskel::CFGLayout>(m, "CFGLayout")
         .def("get_coords", &triskel::CFGLayout::get_coords,
              "Gets the x and y coordinate of a node")
-        .def("get_waypoints", &triskel::CFGLayout::get_waypoints,
-             "Gets the waypoints of an edge")
+        .def(
+            "get_waypoints",
+            [](const triskel::CFGLayout& layout, size_t edge) {
+                return layout.get_waypoints(edge).to_vector();
+            },
+            "Gets the waypoints of an edge")
         .def("get_height", &triskel::CFGLayout::get_height,
              "Gets height of the graph")
         .def("get_height", &triskel::CFGLayout::get_width,
              "Gets width of the graph")
+        .def("update_node_size", &triskel::CFGLayout::update_node_size,
+             "Resizes a node and updates the layout")
+        .def("measure_nodes", &triskel::CFGLayout::measure_nodes,
+             "Calculates the dimension of each node using the renderer and "
+             "updates the layout")
+        .def("add_edge",
+             py::overload_cast<size_t, size_t>(&triskel::CFGLayout::add_edge),
+             "Adds an edge and updates the layout")
+        .def("add_edge",
+             py::overload_cast<size_t, size_t, EdgeType>(
+                 &triskel::CFGLayout::add_edge),
+             "Adds an edge and updates the layout")
+        .def("remove_edge", &triskel::CFGLayout::remove_edge,
+             "Removes an edge and updates the layout")
+        .def("split_node", &triskel::CFGLayout::split_node,
+             "Splits a node in two and updates the layout")
         .def(
             "save",
             [](triskel::CFGLayout& layout, triskel::ExportingRenderer& renderer,
@@ -71,9 +92,13 @@ PYBIND11_MODULE(pytriskel, m) {
              "Creates a new edge", "from", "to", "type")
         .def("measure_nodes", &triskel::LayoutBuilder::measure_nodes,
              "Calculates the dimension of each node using the renderer")
-        .def("build", &triskel::LayoutBuilder::build, "Builds the layout");
+        .def("build", py::overload_cast<>(&triskel::LayoutBuilder::build),
+             "Builds the layout")
+        .def("warm_start", &triskel::LayoutBuilder::warm_start,
+             "Starts the layout from a previous layout of a similar graph");
 
-    m.def("make_layout_builder", &triskel::make_layout_builder);
+    m.def("make_layout_builder",
+          py::overload_cast<>(&triskel::make_layout_builder));
 
     m.def("make_png_renderer", &triskel::make_png_renderer);
 
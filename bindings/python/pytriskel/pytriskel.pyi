@@ -5,6 +5,16 @@ class CFGLayout:
     @staticmethod
     def _pybind11_conduit_v1_(*args, **kwargs):
         ...
+    @typing.overload
+    def add_edge(self, arg0: int, arg1: int) -> int:
+        """
+        Adds an edge and updates the layout
+        """
+    @typing.overload
+    def add_edge(self, arg0: int, arg1: int, arg2: EdgeType) -> int:
+        """
+        Adds an edge and updates the layout
+        """
     def get_coords(self, arg0: int) -> Point:
         """
         Gets the x and y coordinate of a node
@@ -23,10 +33,26 @@ class CFGLayout:
         """
         Gets the waypoints of an edge
         """
+    def measure_nodes(self, arg0: Renderer) -> None:
+        """
+        Calculates the dimension of each node using the renderer and updates the layout
+        """
+    def remove_edge(self, arg0: int) -> None:
+        """
+        Removes an edge and updates the layout
+        """
     def save(self, arg0: ExportingRenderer, arg1: str) -> None:
         """
         Generate an image of the graph
         """
+    def split_node(self, arg0: int) -> int:
+        """
+        Splits a node in two and updates the layout
+        """
+    def update_node_size(self, arg0: int, arg1: float, arg2: float) -> None:
+        """
+        Resizes a node and updates the layout
+        """
 class EdgeType:
     """
     Members:
@@ -116,6 +142,10 @@ class LayoutBuilder:
         """
         Calculates the dimension of each node using the renderer
         """
+    def warm_start(self, arg0: CFGLayout, arg1: list[int]) -> None:
+        """
+        Starts the layout from a previous layout of a similar graph
+        """
 class Point:
     x: float
     y: float
@@ -7,6 +7,7 @@
 #include "triskel/analysis/udfs.hpp"
 #include "triskel/graph/graph.hpp"
 #include "triskel/graph/igraph.hpp"
+#include "triskel/layout/progress.hpp"
 #include "triskel/utils/attribute.hpp"
 #include "triskel/utils/tree.hpp"
 
@@ -16,7 +17,8 @@ void cycle_equiv(IGraph& g);
 
 // Single entry single exit
 struct SESE {
-    explicit SESE(Graph& g);
+    /// @param cancellation checked while the graph is traversed
+    explicit SESE(Graph& g, const CancellationToken* cancellation = nullptr);
 
     struct SESERegionData {
         SESERegionData() = default;
@@ -34,15 +36,25 @@ struct SESE {
     /// @brief The program structure tree
     Tree<SESERegionData> regions;
 
-    NodeAttribute<SESERegion*> node_regions;
+    /// @brief The id of the region of each node
+    NodeAttribute<size_t> node_regions;
 
     // index of edge's cycle equivalence set
     EdgeAttribute<size_t> classes_;
 
-    [[nodiscard]] auto get_region(const Node& node) const -> SESERegion& {
-        return *node_regions.get(node);
+    [[nodiscard]] auto get_region(const Node& node) -> SESERegion& {
+        return regions.nodes[node_regions.get(node)];
     }
 
+    [[nodiscard]] auto get_region(const Node& node) const
+        -> const SESERegion& {
+        return regions.nodes[node_regions.get(node)];
+    }
+
+    /// @brief Drops the regions removed from the tree, updating the regions
+    /// of the nodes
+    void compact_regions();
+
    private:
     using Bracket     = EdgeId;
     using BracketList = std::vector<Bracket>;
@@ -87,7 +99,7 @@ struct SESE {
     /// @brief Build the program structure tree using DFS once we know the entry
     /// and exit edges of each region
     void construct_program_structure_tree(const Node& node,
-                                          SESERegion* current_region,
+                                          size_t current_region,
                                           NodeAttribute<bool>& visited);
 
     /// @brief The graph for which we are identifying SESE regions
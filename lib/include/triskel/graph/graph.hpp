@@ -1,5 +1,6 @@
 #pragma once
 
+#include <span>
 #include <stack>
 #include "triskel/graph/igraph.hpp"
 
@@ -23,18 +24,43 @@ struct GraphEditor : public IGraphEditor {
     void pop() override;
     void commit() override;
 
+    /// @brief Adds `count` nodes to the graph
+    /// @return The id of the first node, the others follow
+    auto make_nodes(size_t count) -> NodeId;
+
+    /// @brief Creates an edge from each `from[i]` to `to[i]`. The ids are not
+    /// checked
+    /// @return The id of the first edge, the others follow
+    auto make_edges(std::span<const size_t> from, std::span<const size_t> to)
+        -> EdgeId;
+
+    /// @brief Creates the edges of a graph in compressed sparse row form: the
+    /// edges of node `i` go to `targets[offsets[i]]` up to
+    /// `targets[offsets[i + 1] - 1]`. The ids and offsets are not checked
+    /// @return The id of the first edge, the others follow
+    auto make_csr_edges(std::span<const size_t> offsets,
+                        std::span<const size_t> targets) -> EdgeId;
+
    private:
     struct Frame {
         size_t created_nodes_count;
         std::stack<NodeId> deleted_nodes;
 
-        std::stack<EdgeId> created_edges;
+        /// @brief The edges created in the frame are the last ones of the
+        /// graph
+        size_t created_edges_count;
         std::stack<EdgeId> deleted_edges;
         std::stack<EdgeData> modified_edges;
     };
 
     auto frame() -> Frame&;
 
+    /// @brief Appends `count` edges, `for_each_edge(add)` calls `add(from, to)`
+    /// for each of them in order
+    template <typename ForEachEdge>
+    auto append_edges(size_t count, const ForEachEdge& for_each_edge)
+        -> EdgeId;
+
     Graph& g_;
 
     std::stack<Frame> frames;
@@ -229,4 +229,32 @@ struct IGraphEditor {
     /// @brief Writes all changes to the graph, erasing the modification frames
     virtual void commit() = 0;
 };
+
+/// @brief An edit frame that is popped when it goes out of scope, so that an
+/// exception doesn't leave it open
+struct EditFrame {
+    /// @brief Creates a new edit frame in `editor`
+    explicit EditFrame(IGraphEditor& editor) : editor_{&editor} {
+        editor.push();
+    }
+
+    EditFrame(const EditFrame&)                    = delete;
+    auto operator=(const EditFrame&) -> EditFrame& = delete;
+
+    ~EditFrame() {
+        if (editor_ != nullptr) {
+            editor_->pop();
+        }
+    }
+
+    /// @brief Removes all changes from the frame before it goes out of scope
+    void pop() {
+        assert(editor_ != nullptr);
+        editor_->pop();
+        editor_ = nullptr;
+    }
+
+   private:
+    IGraphEditor* editor_;
+};
 }  // namespace triskel
\ No newline at end of file
@@ -4,6 +4,7 @@
 #include <string>
 
 #include "triskel/graph/graph.hpp"
+#include "triskel/layout/options.hpp"
 #include "triskel/triskel.hpp"
 #include "triskel/utils/attribute.hpp"
 
@@ -13,5 +14,7 @@ namespace triskel {
                                const NodeAttribute<float>& height,
                                const NodeAttribute<std::string>& label,
                                const EdgeAttribute<LayoutBuilder::EdgeType>&
-                                   edge_types) -> std::unique_ptr<CFGLayout>;
+                                   edge_types,
+                               const LayoutOptions& options = {})
+    -> std::unique_ptr<CFGLayout>;
 }
\ No newline at end of file
@@ -0,0 +1,124 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <memory_resource>
+#include <optional>
+
+namespace triskel {
+
+/// @brief Counts the allocations it passes on to another resource.
+/// Thread safe if the other resource is
+struct CountingResource : std::pmr::memory_resource {
+    explicit CountingResource(std::pmr::memory_resource* upstream =
+                                  std::pmr::new_delete_resource());
+
+    [[nodiscard]] auto upstream() const -> std::pmr::memory_resource* {
+        return upstream_;
+    }
+
+    /// @brief The number of allocations made so far
+    [[nodiscard]] auto allocations() const -> size_t {
+        return allocations_.load(std::memory_order_relaxed);
+    }
+
+    /// @brief The number of bytes allocated so far, freeing them does not
+    /// lower it
+    [[nodiscard]] auto bytes() const -> size_t {
+        return bytes_.load(std::memory_order_relaxed);
+    }
+
+   private:
+    auto do_allocate(size_t bytes, size_t alignment) -> void* override;
+
+    void do_deallocate(void* p, size_t bytes, size_t alignment) override;
+
+    [[nodiscard]] auto do_is_equal(
+        const std::pmr::memory_resource& other) const noexcept
+        -> bool override;
+
+    std::pmr::memory_resource* upstream_;
+
+    std::atomic<size_t> allocations_{0};
+    std::atomic<size_t> bytes_{0};
+};
+
+/// @brief Memory reused by the layouts built one after the other on a thread.
+/// The transient buffers of a layout are drawn from an arena and freed all at
+/// once when the layout is built. The arena keeps enough memory for the
+/// largest layout so far, the next layouts don't allocate from the heap
+struct LayoutContext {
+    LayoutContext();
+
+    /// @param capacity the number of bytes kept from the start
+    explicit LayoutContext(size_t capacity);
+
+    ~LayoutContext();
+
+    LayoutContext(const LayoutContext&)                    = delete;
+    LayoutContext(LayoutContext&&)                         = delete;
+    auto operator=(const LayoutContext&) -> LayoutContext& = delete;
+    auto operator=(LayoutContext&&) -> LayoutContext&      = delete;
+
+    /// @brief Starts a layout, which draws its buffers from the returned
+    /// resource. Only one layout can use the context at a time
+    [[nodiscard]] auto begin() -> std::pmr::memory_resource*;
+
+    /// @brief Ends the layout and frees its buffers. The memory is kept, grown
+    /// to what the layout used
+    void end();
+
+    /// @brief Frees the memory kept between the layouts
+    void release();
+
+    /// @brief Whether a layout is using the context
+    [[nodiscard]] auto in_use() const -> bool { return in_use_; }
+
+    /// @brief The number of bytes kept between the layouts
+    [[nodiscard]] auto capacity() const -> size_t { return capacity_; }
+
+    /// @brief The number of blocks the context took from the heap so far
+    [[nodiscard]] auto heap_allocations() const -> size_t {
+        return heap_.allocations();
+    }
+
+   private:
+    /// @brief Creates the arena over the kept memory
+    void make_arena();
+
+    CountingResource heap_;
+
+    std::byte* buffer_ = nullptr;
+    size_t capacity_   = 0;
+
+    /// @brief The bytes taken from the heap before the layout began
+    size_t heap_bytes_ = 0;
+
+    std::optional<std::pmr::monotonic_buffer_resource> arena_;
+
+    /// @brief Reuses the buffers freed during a layout
+    std::optional<std::pmr::unsynchronized_pool_resource> pool_;
+
+    bool in_use_ = false;
+};
+
+/// @brief The resource the transient buffers of the layout running on this
+/// thread are drawn from. The heap when no layout is running
+[[nodiscard]] auto scratch_resource() -> std::pmr::memory_resource*;
+
+/// @brief Sets the scratch resource of this thread until destroyed
+struct ScratchScope {
+    explicit ScratchScope(std::pmr::memory_resource* resource);
+
+    ~ScratchScope();
+
+    ScratchScope(const ScratchScope&)                    = delete;
+    ScratchScope(ScratchScope&&)                         = delete;
+    auto operator=(const ScratchScope&) -> ScratchScope& = delete;
+    auto operator=(ScratchScope&&) -> ScratchScope&      = delete;
+
+   private:
+    std::pmr::memory_resource* previous_;
+};
+
+}  // namespace triskel
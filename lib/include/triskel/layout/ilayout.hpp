@@ -2,6 +2,7 @@
 
 #include "triskel/graph/igraph.hpp"
 #include "triskel/utils/point.hpp"
+#include "triskel/utils/waypoints.hpp"
 
 namespace triskel {
 
@@ -14,7 +15,7 @@ struct ILayout {
     [[nodiscard]] virtual auto get_xy(NodeId node) const -> Point;
 
     [[nodiscard]] virtual auto get_waypoints(EdgeId edge) const
-        -> const std::vector<Point>& = 0;
+        -> WaypointsView = 0;
 
     [[nodiscard]] virtual auto get_width(NodeId node) const -> float  = 0;
     [[nodiscard]] virtual auto get_height(NodeId node) const -> float = 0;
@@ -1,30 +1,58 @@
 #pragma once
 
+#include <chrono>
 #include <cmath>
 #include <cstddef>
 #include <map>
 #include <memory>
+#include <mutex>
+#include <optional>
+#include <span>
 #include <vector>
 
 #include "triskel/analysis/sese.hpp"
 #include "triskel/graph/igraph.hpp"
 #include "triskel/graph/subgraph.hpp"
+#include "triskel/layout/context.hpp"
 #include "triskel/layout/ilayout.hpp"
+#include "triskel/layout/layout_cache.hpp"
+#include "triskel/layout/options.hpp"
+#include "triskel/layout/phantom_nodes.hpp"
+#include "triskel/layout/progress.hpp"
+#include "triskel/layout/stats.hpp"
 #include "triskel/layout/sugiyama/sugiyama.hpp"
+#include "triskel/layout/waypoint_buffer.hpp"
 #include "triskel/utils/attribute.hpp"
 
 namespace triskel {
 
+/// @brief What a layout reuses from an earlier layout of the same or of a
+/// similar graph
+struct WarmStart {
+    /// @brief The layouts of the earlier regions. The regions that did not
+    /// change are not laid out again
+    LayoutCache* regions = nullptr;
+
+    /// @brief The earlier x coordinate of the nodes, NaN for the new nodes.
+    /// The regions that changed start from the earlier order of their nodes
+    const NodeAttribute<float>* xs = nullptr;
+};
+
 struct Layout : public ILayout {
+    /// @param context the transient buffers of the layout are drawn from it.
+    /// They come from the heap if `nullptr`
     Layout(Graph& g,
            const NodeAttribute<float>& heights,
-           const NodeAttribute<float>& widths);
+           const NodeAttribute<float>& widths,
+           const LayoutOptions& options = {},
+           const WarmStart& warm_start  = {},
+           LayoutContext* context       = nullptr);
     explicit Layout(Graph& g);
 
     [[nodiscard]] auto get_x(NodeId node) const -> float override;
     [[nodiscard]] auto get_y(NodeId node) const -> float override;
     [[nodiscard]] auto get_waypoints(EdgeId edge) const
-        -> const std::vector<Point>& override;
+        -> WaypointsView override;
 
     [[nodiscard]] auto get_width(NodeId node) const -> float override;
     [[nodiscard]] auto get_height(NodeId node) const -> float override;
@@ -33,6 +61,21 @@ struct Layout : public ILayout {
         return sese_->regions.nodes.size();
     }
 
+    [[nodiscard]] auto stats() const -> const LayoutStats& { return stats_; }
+
+    /// @brief Resizes a node and updates the layout. Only the regions
+    /// containing the node are laid out again
+    void update_node_size(NodeId node, float width, float height);
+
+    /// @brief Resizes every node and updates the layout. The regions, and the
+    /// layers and orders that don't depend on the sizes, are reused
+    void update_node_sizes(const NodeAttribute<float>& heights,
+                           const NodeAttribute<float>& widths);
+
+    /// @brief The layouts of the regions, to lay the graph out again once it
+    /// has been edited
+    [[nodiscard]] auto saved_regions() const -> std::unique_ptr<LayoutCache>;
+
    private:
     NodeAttribute<float> xs_;
     NodeAttribute<float> ys_;
@@ -40,7 +83,7 @@ struct Layout : public ILayout {
     NodeAttribute<float> heights_;
     NodeAttribute<float> widths_;
 
-    EdgeAttribute<std::vector<Point>> waypoints_;
+    WaypointBuffer waypoints_;
 
     EdgeAttribute<float> start_x_offset_;
     EdgeAttribute<float> end_x_offset_;
@@ -56,17 +99,82 @@ struct Layout : public ILayout {
 
         std::map<Pair, std::vector<Point>> io_waypoints;
 
+        /// @brief The nodes of the region in the order of a depth first search
+        /// from its entry, then the nodes it doesn't reach by id. Regions of
+        /// the same shape list their nodes in the same order, whatever their
+        /// ids. The region layouts follow this order
+        std::vector<NodeId> dfs_nodes;
+
+        /// @brief The edges of the region, grouped by source in the order of
+        /// `dfs_nodes`
+        std::vector<EdgeId> dfs_edges;
+
+        /// @brief The range of the waypoint buffer holding the waypoints of
+        /// the region's edges
+        size_t waypoints_begin = 0;
+        size_t waypoints_end   = 0;
+
+        /// @brief Where the region's content sits relative to the region node.
+        /// Regions are laid out in their own frame, the coordinates are only
+        /// made absolute by `resolve_coordinates`
+        Point offset = {.x = 0, .y = 0};
+
         bool was_layout = false;
 
         float width;
         float height;
     };
 
+    /// @brief Merges edges into trunks before the layout
+    void concentrate_edges();
+
+    /// @brief Gives the concentrated edges the waypoints of their path
+    void draw_concentrated_edges();
+
+    EdgeConcentration concentration_;
+
     /// @brief Remove SESE regions with a single node
     void remove_small_regions();
 
     std::vector<RegionData> regions_data_;
 
+    /// @brief What is kept of a region between two layouts of the graph
+    struct RegionResult {
+        /// @brief Describes everything the layout depends on
+        LayoutCache::Key key;
+
+        std::shared_ptr<const RegionLayout> layout;
+
+        /// @brief The steps of the region's layout that don't depend on
+        /// the sizes of its nodes
+        SugiyamaHints hints;
+
+        /// @brief Whether the region has to be laid out again
+        bool dirty = true;
+    };
+
+    std::vector<RegionResult> results_;
+
+    /// @brief The regions of the previous layout, only set in the constructor
+    LayoutCache* previous_;
+
+    /// @brief The x coordinates seeding the vertex ordering
+    std::optional<NodeAttribute<float>> seed_xs_;
+
+    /// @brief The earliest of the deadline and the end of the budget, set at
+    /// the start of the layout and of each update
+    LayoutOptions::Clock::time_point deadline_;
+
+    /// @brief Starts the budget of a layout or of an update
+    void start_budget();
+
+    /// @brief Lays the graph out again, only the dirty regions are laid out
+    void relayout();
+
+    /// @brief Lays out the regions and draws the edges.
+    /// Pops `concentrated`, the frame opened before the edges were concentrated
+    void layout_regions(EditFrame& concentrated);
+
     /// @brief Edits the region subgraphs so that each region's subgraph
     /// contains its children region phony nodes
     /// Edges also need to be stitched accordingly
@@ -84,9 +192,63 @@ struct Layout : public ILayout {
 
     void compute_layout(const SESE::SESERegion& r);
 
+    /// @brief Lays the regions out on a thread pool, starting from the leaves
+    void compute_layout_parallel();
+
+    /// @brief A copy of a region's subgraph
+    struct ScratchGraph;
+
+    /// @brief Orders the nodes and edges of a region, see
+    /// `RegionData::dfs_nodes`
+    void init_region_order(RegionData& region) const;
+
+    /// @brief The key of a region in the layout caches
+    [[nodiscard]] auto region_key(const RegionData& region) const
+        -> LayoutCache::Key;
+
+    /// @brief Lays out a region whose children are laid out
+    void layout_region(const SESE::SESERegion& r);
+
+    void add_ordering_time(std::chrono::nanoseconds time);
+
+    /// @brief Counts a region as laid out and reports the progress
+    void finish_region();
+
+    /// @brief Calls the progress callback, if any
+    void report(LayoutPhase phase, float fraction) const;
+
+    /// @brief The number of regions laid out in the current layout
+    size_t laid_out_regions_ = 0;
+
+    /// @brief Where the transient buffers are drawn from while the graph is
+    /// laid out
+    struct Scratch;
+
+    /// @brief Set while the graph is laid out
+    Scratch* scratch_ = nullptr;
+
+    /// @brief Records that the deadline stopped the layout of a region early.
+    /// The region is not reused by later layouts
+    void mark_truncated(RegionResult& result);
+
+    /// @brief Reads the layout of `nodes` and `edges` from the analysis, in
+    /// that order
+    [[nodiscard]] static auto read_region_layout(
+        const SugiyamaAnalysis& sugiyama,
+        std::span<const NodeId> nodes,
+        std::span<const EdgeId> edges,
+        const std::vector<IOPair>& entries,
+        const std::vector<IOPair>& exits) -> RegionLayout;
+
+    /// @brief Saves the layout of a region
+    void store_region_layout(const SESE::SESERegion& r,
+                             const RegionLayout& layout);
+
     void translate_region(const SESE::SESERegion& r, const Point& v);
 
-    void translate_region(const SESE::SESERegion& r);
+    /// @brief Moves every region from its local frame to absolute coordinates.
+    /// Each node and waypoint is moved exactly once
+    void resolve_coordinates();
 
     /// @brief Initiates the regions
     void init_regions();
@@ -98,6 +260,12 @@ struct Layout : public ILayout {
     void create_region_nodes();
 
     std::unique_ptr<SESE> sese_;
+    LayoutOptions options_;
+    LayoutStats stats_;
     Graph& g_;
+
+    /// @brief Guards the waypoints and the stats when regions are laid out
+    /// in parallel
+    std::mutex mutex_;
 };
 }  // namespace triskel
\ No newline at end of file
@@ -0,0 +1,94 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+#include "triskel/utils/point.hpp"
+
+namespace triskel {
+
+/// @brief The layout of a SESE region, indexed by the position of the nodes
+/// and edges in the region's subgraph
+struct RegionLayout {
+    /// @brief The coordinates of each node
+    std::vector<Point> coords;
+
+    /// @brief The waypoints of each edge
+    std::vector<std::vector<Point>> waypoints;
+
+    /// @brief The waypoints of the entries, then of the exits, of the region
+    std::vector<std::vector<Point>> io_waypoints;
+
+    float width  = 0.0F;
+    float height = 0.0F;
+
+    bool has_top_loop = false;
+
+    size_t dummy_count = 0;
+};
+
+/// @brief A bounded cache of region layouts, shared by the layouts of
+/// structurally identical regions.
+/// The key of a region describes its shape, the sizes of its nodes, its
+/// entries and exits and the layout options. The nodes and edges are listed in
+/// the order of a depth first search from the entry of the region, so regions
+/// of the same shape share their layout whatever the order of their ids.
+struct LayoutCache {
+    using Key = std::vector<uint64_t>;
+
+    /// @brief The number of regions kept by default
+    static constexpr size_t DEFAULT_CAPACITY = 4096;
+
+    explicit LayoutCache(size_t capacity = DEFAULT_CAPACITY);
+
+    /// @brief The cache shared by the whole process
+    [[nodiscard]] static auto global() -> LayoutCache&;
+
+    /// @brief Finds the layout of a region, `nullptr` if it isn't cached
+    [[nodiscard]] auto find(const Key& key)
+        -> std::shared_ptr<const RegionLayout>;
+
+    /// @brief Adds the layout of a region, evicting the least recently used
+    /// regions if the cache is full
+    void insert(Key key, std::shared_ptr<const RegionLayout> layout);
+
+    /// @brief Changes the maximum number of regions, `0` disables the cache
+    void set_capacity(size_t capacity);
+
+    [[nodiscard]] auto capacity() const -> size_t;
+
+    /// @brief The number of cached regions
+    [[nodiscard]] auto size() const -> size_t;
+
+    void clear();
+
+   private:
+    struct KeyHash {
+        auto operator()(const Key& key) const -> size_t;
+    };
+
+    struct Entry {
+        std::shared_ptr<const RegionLayout> layout;
+
+        /// @brief The position of the key in `lru_`
+        std::list<const Key*>::iterator position;
+    };
+
+    void evict();
+
+    mutable std::mutex mutex_;
+
+    size_t capacity_;
+
+    std::unordered_map<Key, Entry, KeyHash> entries_;
+
+    /// @brief The keys, from the most to the least recently used
+    std::list<const Key*> lru_;
+};
+
+}  // namespace triskel
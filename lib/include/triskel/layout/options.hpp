@@ -0,0 +1,97 @@
+#pragma once
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+
+#include "triskel/layout/progress.hpp"
+
+namespace triskel {
+
+struct DiskCache;
+struct Executor;
+
+/// @brief Settings controlling how a CFG is laid out
+struct LayoutOptions {
+    /// @brief The heuristic used to reduce crossings when ordering the nodes of
+    /// each layer
+    enum class Ordering : uint8_t {
+        /// @brief Alternates median and transpose passes
+        MedianTranspose,
+
+        /// @brief Layer by layer sifting, seeded with a few median passes.
+        /// Faster than `MedianTranspose` but may leave more crossings
+        Sifting
+    };
+
+    /// @brief The algorithm assigning the x coordinates of the nodes
+    enum class Coordinates : uint8_t {
+        /// @brief Sweeps the layers, moving nodes by decreasing priority
+        Priority,
+
+        /// @brief Brandes and Koepf's vertical alignment and horizontal
+        /// compaction, in linear time
+        BrandesKopf
+    };
+
+    Ordering ordering = Ordering::MedianTranspose;
+
+    Coordinates coordinates = Coordinates::Priority;
+
+    /// @brief Nodes with at least this many predecessors get their incoming
+    /// edges merged into shared trunks, and parallel edges are merged.
+    /// `0` disables edge concentration
+    size_t concentration_threshold = 0;
+
+    /// @brief The number of threads laying out the SESE regions, the calling
+    /// thread included. A region is laid out once all of its children are, on
+    /// a copy of its subgraph.
+    /// `0` and `1` lay the regions out one after another
+    size_t threads = 0;
+
+    /// @brief Runs the parallel steps, no other threads are created.
+    /// `nullptr` uses `default_executor()`. It must outlive the layout
+    Executor* executor = nullptr;
+
+    /// @brief Reuses the layout of structurally identical regions, within and
+    /// across layouts, through `LayoutCache::global()`
+    bool cache_regions = false;
+
+    /// @brief Reads the whole layout from this cache if it was stored by an
+    /// earlier build, and stores it otherwise. Not used by the layouts starting
+    /// from a previous layout. `nullptr` disables it, it must outlive the
+    /// builds
+    DiskCache* disk_cache = nullptr;
+
+    /// @brief When the layout starts from a previous layout, the number of
+    /// positions a node may move on its layer away from its previous order
+    size_t warm_start_max_shift = std::numeric_limits<size_t>::max();
+
+    using Clock = std::chrono::steady_clock;
+
+    /// @brief The time by which the layout should be done. The iterative
+    /// steps stop early once it has passed and keep their best result, see
+    /// `LayoutStats::truncated`
+    Clock::time_point deadline = Clock::time_point::max();
+
+    /// @brief The time the layout may take from the start of `build` or of an
+    /// update, `0` for no limit. Each update gets a fresh budget. Ends the
+    /// layout at the earliest of `deadline` and the budget
+    std::chrono::nanoseconds budget{0};
+
+    /// @brief Whether the iterative steps should stop
+    [[nodiscard]] auto is_past_deadline() const -> bool {
+        return deadline != Clock::time_point::max() && Clock::now() >= deadline;
+    }
+
+    /// @brief Stops the layout once cancelled, the layout throws
+    /// `LayoutCancelled`. Checked between the steps and in their loops
+    CancellationToken cancellation{};
+
+    /// @brief Follows the layout. With several threads, the calls are made by
+    /// the threads laying out the regions, one at a time
+    ProgressCallback progress{};
+};
+
+}  // namespace triskel
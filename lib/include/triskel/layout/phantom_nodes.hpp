@@ -1,7 +1,36 @@
 #pragma once
 
+#include <cstddef>
+#include <vector>
+
 #include "triskel/graph/igraph.hpp"
 
 namespace triskel {
-void create_phantom_nodes(IGraph& g);
-}
\ No newline at end of file
+
+/// @brief The edges merged by `create_phantom_nodes`
+struct EdgeConcentration {
+    /// @brief An edge of the original graph replaced by a path
+    struct Path {
+        /// @brief The removed edge
+        EdgeId edge;
+
+        /// @brief The edges the removed edge follows, from its source to its
+        /// target. Edges sharing a trunk share the end of their path
+        std::vector<EdgeId> edges;
+    };
+
+    std::vector<Path> paths;
+
+    /// @brief The nodes created to merge the edges
+    std::vector<NodeId> phantoms;
+};
+
+/// @brief Concentrates the edges of the graph before the layout.
+///
+/// Parallel edges are merged into a single edge. The forward edges of nodes
+/// with at least `threshold` predecessors are merged into trunks: predecessors
+/// sharing a dominator path share a phantom node.
+///
+/// The graph editor needs a frame, popping it restores the original edges.
+auto create_phantom_nodes(IGraph& g, size_t threshold) -> EdgeConcentration;
+}  // namespace triskel
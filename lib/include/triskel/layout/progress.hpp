@@ -0,0 +1,49 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <stdexcept>
+
+namespace triskel {
+
+/// @brief The steps of a layout, in order
+enum class LayoutPhase : uint8_t {
+    /// @brief Finding the SESE regions of the graph
+    Regions,
+
+    /// @brief Laying out each region
+    Nodes,
+
+    /// @brief Joining the edges that cross regions
+    Edges
+};
+
+/// @brief Called with the current phase and the fraction of it that is done,
+/// between `0` and `1`
+using ProgressCallback = std::function<void(LayoutPhase phase, float fraction)>;
+
+/// @brief Thrown out of a layout whose `CancellationToken` was cancelled
+struct LayoutCancelled : std::runtime_error {
+    LayoutCancelled();
+};
+
+/// @brief Cancels a running layout from another thread. The copies of a token
+/// share their state
+struct CancellationToken {
+    CancellationToken();
+
+    /// @brief Asks the layouts using this token to stop
+    void cancel() const;
+
+    [[nodiscard]] auto is_cancelled() const -> bool;
+
+    /// @brief Throws `LayoutCancelled` if the token was cancelled
+    void throw_if_cancelled() const;
+
+   private:
+    std::shared_ptr<std::atomic<bool>> cancelled_;
+};
+
+}  // namespace triskel
@@ -0,0 +1,51 @@
+#pragma once
+
+#include <chrono>
+#include <cstddef>
+
+namespace triskel {
+
+/// @brief Measurements made while laying out a CFG
+struct LayoutStats {
+    /// @brief The number of nodes created to route the edges through the
+    /// layers
+    size_t dummy_count = 0;
+
+    /// @brief The number of phantom nodes created by edge concentration
+    size_t phantom_count = 0;
+
+    /// @brief The number of edges drawn along another edge or a trunk
+    size_t concentrated_edges = 0;
+
+    /// @brief The time spent ordering the nodes of the layers
+    std::chrono::nanoseconds ordering_time{0};
+
+    /// @brief The number of regions laid out, the others kept the layout they
+    /// had before the graph was updated
+    size_t region_layouts = 0;
+
+    /// @brief The number of regions whose layout was found in the layout cache
+    size_t cache_hits = 0;
+
+    /// @brief The number of regions laid out while the layout cache was used
+    size_t cache_misses = 0;
+
+    /// @brief Whether the layout was read from `LayoutOptions::disk_cache`.
+    /// Only the dummy, phantom and concentrated edge counts are then kept
+    bool from_disk_cache = false;
+
+    /// @brief Whether the deadline stopped some steps early. The layout is
+    /// valid but may have more crossings or longer edges
+    bool truncated = false;
+
+    /// @brief The number of transient buffers allocated by the layout
+    size_t scratch_allocations = 0;
+
+    /// @brief The number of allocations the layout made from the heap for its
+    /// scratch buffers, the ones counted by `scratch_allocations`. The other
+    /// allocations of the layout aren't counted. Without a `LayoutContext`,
+    /// every scratch buffer is one
+    size_t scratch_heap_allocations = 0;
+};
+
+}  // namespace triskel
@@ -0,0 +1,57 @@
+#pragma once
+
+#include <cstddef>
+#include <vector>
+
+namespace triskel {
+
+/// @brief A proper layered graph: every edge connects two consecutive layers
+struct BKGraph {
+    struct Node {
+        float width;
+
+        /// @brief The space to keep on the left of the node
+        float left_gutter;
+
+        /// @brief The space to keep on the right of the node
+        float right_gutter;
+
+        /// @brief Waypoints of long edges. Segments between two dummy nodes
+        /// are kept straight over the other segments
+        bool is_dummy;
+    };
+
+    /// @brief An edge between two consecutive layers
+    struct Segment {
+        /// @brief The index of the node on the upper layer
+        size_t upper;
+
+        /// @brief The index of the node on the lower layer
+        size_t lower;
+
+        /// @brief Where the segment is attached, relative to the left of the
+        /// upper node
+        float upper_port;
+
+        /// @brief Where the segment is attached, relative to the left of the
+        /// lower node
+        float lower_port;
+
+        /// @brief Whether the segment can be drawn straight
+        bool is_alignable;
+    };
+
+    std::vector<Node> nodes;
+    std::vector<Segment> segments;
+
+    /// @brief The node indexes of each layer from top to bottom, each layer
+    /// being ordered from left to right
+    std::vector<std::vector<size_t>> layers;
+};
+
+/// @brief Calculates the x coordinate of the left side of each node using
+/// Brandes and Koepf's vertical alignment and horizontal compaction.
+/// The leftmost gutter is placed at 0
+auto brandes_kopf(const BKGraph& graph) -> std::vector<float>;
+
+}  // namespace triskel
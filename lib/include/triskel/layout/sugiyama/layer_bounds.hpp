@@ -0,0 +1,86 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <vector>
+
+namespace triskel {
+
+/// @brief The space each item of a layer can move in without passing over the
+/// items of higher priority, in O(1) per item.
+///
+/// The bounds are the same, to the bit, as walking the layer from the item to
+/// the closest item of higher priority and summing the widths on the way. The
+/// prefix sums are only used when every sum of widths is exact in single
+/// precision, which holds for integer and dyadic widths (multiples of a power
+/// of two such as 0.5 or 0.25) of a reasonable magnitude. Other widths, such as
+/// 0.1, make the result depend on the order of the additions and fall back to
+/// the walk
+class LayerBounds {
+   public:
+    struct Item {
+        float width;
+
+        /// @brief The space to keep on the left of the item
+        float left_gutter;
+
+        /// @brief The space to keep on the right of the item
+        float right_gutter;
+
+        /// @brief Items can't pass over the items of higher priority
+        uint8_t priority;
+    };
+
+    /// @brief There is no item of higher priority on this side, the item is
+    /// bounded by the side of the graph
+    static constexpr size_t NO_BLOCKER = std::numeric_limits<size_t>::max();
+
+    /// @brief An item is bounded by `x(blocker) + offset` on the left and by
+    /// `x(blocker) - offset` on the right, the sides of the graph being `0`
+    /// and the width of the graph
+    struct Bound {
+        size_t blocker;
+        float offset;
+    };
+
+    LayerBounds() = default;
+
+    /// @param items the items of the layer, from left to right
+    explicit LayerBounds(const std::vector<Item>& items);
+
+    /// @brief The left bound of the left side of the `id`th item
+    [[nodiscard]] auto left(size_t id) const -> Bound;
+
+    /// @brief The right bound of the left side of the `id`th item
+    [[nodiscard]] auto right(size_t id) const -> Bound;
+
+    /// @brief Whether the bounds come from the prefix sums rather than from
+    /// walking the layer
+    [[nodiscard]] auto is_exact() const -> bool { return is_exact_; }
+
+   private:
+    /// @brief The width of each item with its gutters
+    std::vector<float> widths_;
+
+    /// @brief The width of each item with its right gutter
+    std::vector<float> rights_;
+
+    std::vector<float> left_gutters_;
+
+    std::vector<uint8_t> priorities_;
+
+    /// @brief The sum of the widths of the items on the left of each item
+    std::vector<double> prefix_widths_;
+
+    /// @brief The closest item on the left with a higher or equal priority
+    std::vector<size_t> left_blockers_;
+
+    /// @brief The closest item on the right with a higher priority
+    std::vector<size_t> right_blockers_;
+
+    /// @brief Whether every sum of widths is exact in single precision
+    bool is_exact_ = true;
+};
+
+}  // namespace triskel
@@ -1,14 +1,20 @@
 #pragma once
 
+#include <chrono>
 #include <cstddef>
 #include <cstdint>
+#include <limits>
 #include <map>
+#include <optional>
 #include <random>
 #include <utility>
 #include <vector>
 
 #include "triskel/graph/igraph.hpp"
 #include "triskel/layout/ilayout.hpp"
+#include "triskel/layout/options.hpp"
+#include "triskel/layout/sugiyama/layer_bounds.hpp"
+#include "triskel/layout/sugiyama/vertex_ordering.hpp"
 #include "triskel/utils/attribute.hpp"
 
 namespace triskel {
@@ -34,6 +40,20 @@ struct IOPair {
 };
 static_assert(std::is_trivially_copyable_v<IOPair>);
 
+/// @brief The steps of an analysis that do not depend on the sizes of the
+/// nodes. A later analysis of the same graph reuses them
+struct SugiyamaHints {
+    /// @brief The layers found by the network simplex
+    std::optional<NodeAttribute<size_t>> ranks;
+    size_t rank_count = 0;
+
+    /// @brief The layer of each node when the vertices were ordered. The
+    /// ordering is only reused if the final layers are the same
+    std::vector<size_t> ordered_layers;
+    std::optional<NodeAttribute<size_t>> orders;
+    std::vector<std::vector<VertexOrdering::Slot>> layer_slots;
+};
+
 struct SugiyamaAnalysis : public ILayout {
     explicit SugiyamaAnalysis(IGraph& g);
 
@@ -47,14 +67,17 @@ struct SugiyamaAnalysis : public ILayout {
                               const EdgeAttribute<float>& start_x_offset,
                               const EdgeAttribute<float>& end_x_offset,
                               const std::vector<IOPair>& entries = {},
-                              const std::vector<IOPair>& exits   = {});
+                              const std::vector<IOPair>& exits   = {},
+                              const LayoutOptions& options       = {},
+                              SugiyamaHints* hints               = nullptr,
+                              const NodeAttribute<float>* order_seed = nullptr);
 
     ~SugiyamaAnalysis() override = default;
 
     [[nodiscard]] auto get_x(NodeId node) const -> float override;
     [[nodiscard]] auto get_y(NodeId node) const -> float override;
     [[nodiscard]] auto get_waypoints(EdgeId edge) const
-        -> const std::vector<Point>& override;
+        -> WaypointsView override;
 
     [[nodiscard]] auto get_graph_width() const -> float;
     [[nodiscard]] auto get_graph_height() const -> float;
@@ -133,9 +156,28 @@ struct SugiyamaAnalysis : public ILayout {
 
     void vertex_ordering();
 
+    /// @brief The layer of each node, used to know if an ordering still
+    /// applies
+    [[nodiscard]] auto layer_snapshot() const -> std::vector<size_t>;
+
+    /// @brief Sorts the layers and prepares the layer items from the slots of
+    /// an ordering
+    void apply_ordering(
+        const std::vector<std::vector<VertexOrdering::Slot>>& layer_slots);
+
+    SugiyamaHints* hints_;
+
+    /// @brief The x coordinates of the nodes in a previous layout, seeding
+    /// the vertex ordering
+    const NodeAttribute<float>* order_seed_;
+
     /// @brief Computes the x coordinate of each node
     void x_coordinate_assignment();
 
+    /// @brief Computes the x coordinate of each node using Brandes and Koepf's
+    /// method
+    void brandes_kopf_assignment();
+
     /// @brief Compute the y coordinate of each node
     void y_coordinate_assignment();
 
@@ -145,9 +187,88 @@ struct SugiyamaAnalysis : public ILayout {
 
     auto get_priority(const Node& node, size_t layer) -> size_t;
 
-    auto min_x(std::vector<Node>& nodes, size_t id) -> float;
+    // ----- Segments -----
+    static constexpr size_t NO_SEGMENT = std::numeric_limits<size_t>::max();
+
+    /// @brief The smallest number of layers between the ends of an edge drawn
+    /// with a segment. Shorter edges get a waypoint on each layer they cross
+    static constexpr size_t MIN_SEGMENT_SPAN = 4;
+
+    /// @brief A long edge drawn as a straight vertical line. Only its two ends
+    /// are nodes of the graph, they are linked by a single edge crossing the
+    /// layers in between.
+    /// The vertex ordering and the coordinate assignment still give it a slot
+    /// on each layer it crosses: their cost grows with the span of the edges,
+    /// only the graph doesn't
+    struct Segment {
+        /// @brief The edge from one end to the other
+        EdgeId edge;
 
-    auto max_x(std::vector<Node>& nodes, size_t id, float graph_width) -> float;
+        /// @brief The end on the highest layer
+        NodeId upper;
+
+        /// @brief The end on the lowest layer
+        NodeId lower;
+
+        float x;
+    };
+
+    std::vector<Segment> segments_;
+
+    /// @brief The segment of the ends of the segments
+    NodeAttribute<size_t> node_segments_;
+
+    /// @brief The segment of the edges linking the ends of the segments
+    EdgeAttribute<size_t> edge_segments_;
+
+    /// @brief An element of a layer during the coordinate assignment
+    struct LayerItem {
+        /// @brief `NodeId::InvalidID` if a segment crosses the layer
+        NodeId node;
+
+        /// @brief `NO_SEGMENT` if the node is not the end of a segment
+        size_t segment;
+    };
+
+    /// @brief The nodes and segments on each layer, from left to right
+    std::vector<std::vector<LayerItem>> layer_items_;
+
+    /// @brief The index of each segment on the layers it crosses, from its
+    /// lowest layer up (CSR)
+    std::vector<size_t> segment_offsets_;
+    std::vector<size_t> segment_indexes_;
+
+    [[nodiscard]] auto item_x(const LayerItem& item) -> float;
+    [[nodiscard]] auto item_width(const LayerItem& item) -> float;
+    [[nodiscard]] auto item_padding(const LayerItem& item) -> Padding;
+    [[nodiscard]] auto item_priority(const LayerItem& item) -> uint8_t;
+
+    void set_segment_x(size_t segment, float x);
+
+    /// @brief Places the nodes and segments as far left as possible, in order
+    /// @returns the width of the graph
+    auto init_x_coordinates() -> float;
+
+    /// @brief Moves each segment towards its ends within the space left free
+    /// by its neighbors on every layer it crosses
+    void place_segments(float graph_width);
+
+    // -----
+
+    auto min_x(size_t layer, std::vector<LayerItem>& items, size_t id)
+        -> float;
+
+    auto max_x(size_t layer,
+               std::vector<LayerItem>& items,
+               size_t id,
+               float graph_width) -> float;
+
+    /// @brief The bounds of the items of each layer, in O(1)
+    std::vector<LayerBounds> layer_bounds_;
+
+    /// @brief Prepares the bounds of each layer. The priorities, widths and
+    /// paddings do not change during the coordinate assignment
+    void init_layer_bounds();
 
     auto average_position(const Node& node,
                           size_t layer,
@@ -180,9 +301,16 @@ struct SugiyamaAnalysis : public ILayout {
     float width_;
     [[nodiscard]] auto compute_graph_width() -> float;
 
+    /// @brief The width spanned by the nodes once they have been placed
+    [[nodiscard]] auto compute_graph_extent() -> float;
+
     float height_;
     [[nodiscard]] auto compute_graph_height() -> float;
 
+    /// @brief The number of edges leaving the node that have a horizontal
+    /// part below its layer
+    [[nodiscard]] auto gap_edge_count(const Node& node) -> size_t;
+
     // ----- Entry and exits -----
     /// @brief Ensures the entry/exit nodes are connected to the top/bottom
     /// layers
@@ -219,6 +347,13 @@ struct SugiyamaAnalysis : public ILayout {
 
     std::vector<NodeId> dummy_nodes_;
 
+    /// @brief The time spent in `vertex_ordering`
+    std::chrono::nanoseconds ordering_time_{0};
+
+    /// @brief Whether the deadline stopped the ordering or the coordinate
+    /// assignment early
+    bool truncated_ = false;
+
     /// @brief The nodes on a given layer
     std::vector<std::vector<Node>> node_layers_;
     void init_node_layers();
@@ -227,6 +362,8 @@ struct SugiyamaAnalysis : public ILayout {
 
     size_t layer_count_;
 
+    LayoutOptions options_;
+
     IGraph& g;
 
     friend struct Layout;
@@ -1,39 +1,120 @@
 #pragma once
 
 #include <cstddef>
+#include <limits>
 #include <random>
+#include <span>
 #include <vector>
 
-#include "triskel/graph/graph_view.hpp"
 #include "triskel/graph/igraph.hpp"
+#include "triskel/layout/options.hpp"
+#include "triskel/layout/progress.hpp"
 #include "triskel/utils/attribute.hpp"
 
 namespace triskel {
 struct VertexOrdering {
-    using NodeView = GraphView::Node;
-    using EdgeView = GraphView::Node;
-
+    /// @param seed the x coordinates of the nodes in a previous layout, NaN
+    /// for the nodes without one. The ordering starts from the previous order
+    /// and runs fewer iterations
+    /// @param max_shift the number of positions a node may move away from its
+    /// previous order, only used with a seed
+    /// @param deadline the iterations stop once it has passed, keeping the
+    /// best order found
+    /// @param cancellation checked between the iterations
     VertexOrdering(const IGraph& g,
                    const NodeAttribute<size_t>& layers,
-                   size_t layer_count_);
+                   size_t layer_count_,
+                   LayoutOptions::Ordering strategy =
+                       LayoutOptions::Ordering::MedianTranspose,
+                   const NodeAttribute<float>* seed = nullptr,
+                   size_t max_shift = std::numeric_limits<size_t>::max(),
+                   LayoutOptions::Clock::time_point deadline =
+                       LayoutOptions::Clock::time_point::max(),
+                   const CancellationToken* cancellation = nullptr);
+
+    /// @brief An element of a layer
+    struct Slot {
+        /// @brief The node in this slot, `NodeId::InvalidID` when the slot is
+        /// an edge crossing the layer
+        NodeId node;
+
+        /// @brief The edge crossing the layer, `EdgeId::InvalidID` for nodes
+        EdgeId edge;
+    };
 
     NodeAttribute<size_t> orders_;
 
+    /// @brief The slots of each layer from left to right.
+    /// Edges spanning several layers are segments: they get a slot on each
+    /// layer they cross and are ordered as a single object, two segments never
+    /// cross each other. The ordering still grows with the span of the edges
+    std::vector<std::vector<Slot>> layer_slots_;
+
+    /// @brief Whether the deadline stopped the iterations
+    bool truncated_ = false;
+
    private:
-    GraphView g_;
+    static constexpr size_t NO_SEGMENT = std::numeric_limits<size_t>::max();
+
+    // The slots are the nodes of the graph followed by the edge crossings
+    std::vector<NodeId> slot_nodes_;
+    std::vector<EdgeId> slot_edges_;
+    std::vector<size_t> slot_layers_;
+    std::vector<size_t> slot_orders_;
+
+    /// @brief The segment each slot belongs to
+    std::vector<size_t> slot_segments_;
+
+    // The neighbors of each slot (CSR)
+    std::vector<size_t> parent_offsets_;
+    std::vector<size_t> parents_;
+    std::vector<size_t> child_offsets_;
+    std::vector<size_t> children_;
+
+    [[nodiscard]] auto parents(size_t slot) const -> std::span<const size_t>;
+    [[nodiscard]] auto children(size_t slot) const -> std::span<const size_t>;
+
+    /// @brief The number of segments
+    size_t segment_count_ = 0;
+
+    /// @brief Creates the slots and their links
+    void make_slots(const IGraph& g, const NodeAttribute<size_t>& layers);
+
+    /// @brief Whether the slot is part of a segment
+    [[nodiscard]] auto is_segment(size_t slot) const -> bool;
 
-    const NodeAttribute<size_t>& layers_;
+    std::vector<std::vector<size_t>> node_layers_;
 
-    std::vector<std::vector<const NodeView*>> node_layers_;
+    /// @brief The position of each slot in the previous order, empty without
+    /// a seed
+    std::vector<size_t> seed_orders_;
+
+    size_t max_shift_;
+
+    LayoutOptions::Clock::time_point deadline_;
+
+    const CancellationToken* cancellation_;
+
+    /// @brief Whether the iterations should stop, records the truncation.
+    /// Throws `LayoutCancelled` if the layout was cancelled
+    [[nodiscard]] auto should_stop() -> bool;
+
+    /// @brief Orders the slots of each layer by their previous x coordinate.
+    /// The slots without one take the average position of their neighbors
+    void seed_order(const NodeAttribute<float>& xs);
+
+    /// @brief Whether no slot moved more than `max_shift_` positions away from
+    /// the previous order
+    [[nodiscard]] auto is_within_shift() const -> bool;
 
     std::default_random_engine rng_;
 
-    void get_neighbor_orders(const NodeView& n,
+    void get_neighbor_orders(size_t slot,
                              std::vector<size_t>& orders_top,
                              std::vector<size_t>& orders_bottom) const;
 
-    [[nodiscard]] auto count_crossings(const NodeView& node1,
-                                       const NodeView& node2) const -> size_t;
+    [[nodiscard]] auto count_crossings(size_t slot1, size_t slot2) const
+        -> size_t;
 
     [[nodiscard]] auto count_crossings_with_layer(size_t l1,
                                                   size_t l2) -> size_t;
@@ -48,7 +129,28 @@ struct VertexOrdering {
     /// @brief transform the order to the index in the layer
     void normalize_order();
 
+    /// @brief Sorts the slots of the segments on every layer by the average
+    /// order of the segments, so that segments do not cross each other.
+    /// Expects the layers to be sorted
+    void order_segments();
+
     void median(size_t iter);
     void transpose();
+
+    /// @brief Alternates median and transpose passes, keeping the best order
+    /// @param iterations the number of median passes
+    void median_transpose(size_t iterations);
+
+    /// @brief Refines a short median order by sifting the nodes of every
+    /// layer, sweeping down then up, until the number of crossings stops
+    /// decreasing
+    void sifting();
+
+    /// @brief Moves each node of the layer to the position minimizing the
+    /// crossings with its neighboring layers
+    void sift_layer(size_t layer);
+
+    /// @brief Fills the orders and the slots of each layer
+    void save_layers();
 };
-}  // namespace triskel
\ No newline at end of file
+}  // namespace triskel
@@ -0,0 +1,72 @@
+#pragma once
+
+#include <cstddef>
+#include <span>
+#include <vector>
+
+#include "triskel/graph/igraph.hpp"
+#include "triskel/utils/point.hpp"
+#include "triskel/utils/waypoints.hpp"
+
+namespace triskel {
+
+/// @brief The waypoints of all the edges of a graph in a single pool.
+/// The coordinates are stored as two arrays (x and y), each edge owns a range
+/// of the pool.
+///
+/// Assigning the waypoints of an edge appends them to the pool, the previous
+/// range of the edge is reclaimed by `pack`.
+struct WaypointBuffer {
+    /// @brief A rectangle containing waypoints
+    struct BoundingBox {
+        Point min;
+        Point max;
+    };
+
+    /// @brief Sets the waypoints of `edge`
+    void assign(EdgeId edge, std::span<const Point> points);
+
+    /// @brief Gets the waypoints of `edge`
+    [[nodiscard]] auto get(EdgeId edge) const -> WaypointsView;
+
+    /// @brief The size of the pool, waypoints assigned after this call are
+    /// after this mark
+    [[nodiscard]] auto mark() const -> size_t;
+
+    /// @brief Moves the waypoints in [begin, end) of the pool by `v`
+    void translate(size_t begin, size_t end, Point v);
+
+    /// @brief Moves every waypoint by `v`
+    void translate(Point v);
+
+    /// @brief Multiplies the coordinates of every waypoint by `s`
+    void scale(float s);
+
+    /// @brief The smallest rectangle containing every waypoint.
+    /// Expects the buffer to be packed
+    [[nodiscard]] auto bounding_box() const -> BoundingBox;
+
+    /// @brief Removes the unused ranges, keeping the edges of `g` in the order
+    /// of their ids.
+    /// The waypoints in the middle of a straight line are removed
+    void pack(const IGraph& g);
+
+    /// @brief The number of waypoints in the pool
+    [[nodiscard]] auto size() const -> size_t;
+
+   private:
+    struct Range {
+        size_t offset = 0;
+        size_t length = 0;
+    };
+
+    [[nodiscard]] auto range(EdgeId edge) const -> Range;
+
+    std::vector<float> xs_;
+    std::vector<float> ys_;
+
+    /// @brief The range of each edge, by id
+    std::vector<Range> ranges_;
+};
+
+}  // namespace triskel
@@ -1,13 +1,31 @@
 #pragma once
 
+#include <array>
+#include <atomic>
+#include <chrono>
 #include <cstddef>
 #include <cstdint>
+#include <exception>
 #include <filesystem>
+#include <future>
+#include <iosfwd>
+#include <limits>
 #include <memory>
+#include <mutex>
+#include <optional>
+#include <span>
 #include <string>
+#include <string_view>
 #include <vector>
 
+#include "triskel/layout/context.hpp"
+#include "triskel/layout/layout_cache.hpp"
+#include "triskel/layout/options.hpp"
+#include "triskel/layout/progress.hpp"
+#include "triskel/layout/stats.hpp"
+#include "triskel/utils/executor.hpp"
 #include "triskel/utils/point.hpp"
+#include "triskel/utils/waypoints.hpp"
 
 namespace triskel {
 
@@ -109,43 +127,14 @@ struct ExportingRenderer : Renderer {
     virtual void save(const std::filesystem::path& path) = 0;
 };
 
-struct CFGLayout {
-    CFGLayout() = default;
-
-    virtual ~CFGLayout() = default;
-
-    /// @brief Return the x coordinate of the top left of the `node` basic
-    /// block
-    [[nodiscard]] virtual auto get_coords(size_t node) const -> Point = 0;
-
-    /// @brief Returns the waypoints that the edge `edge` should follow
-    [[nodiscard]] virtual auto get_waypoints(size_t edge) const
-        -> const std::vector<Point>& = 0;
-
-    /// @brief Returns the height of the graph
-    [[nodiscard]] virtual auto get_height() const -> float = 0;
-
-    /// @brief Returns the width of the graph
-    [[nodiscard]] virtual auto get_width() const -> float = 0;
-
-    /// @brief Returns the number of nodes
-    [[nodiscard]] virtual auto node_count() const -> size_t = 0;
-
-    /// @brief Returns the number of edges
-    [[nodiscard]] virtual auto edge_count() const -> size_t = 0;
-
-    /// @brief Renders the cfg
-    virtual void render(Renderer& renderer) const = 0;
-
-    /// @brief Save the cfg
-    /// @param path the path where the render will be saved
-    virtual void render_and_save(ExportingRenderer& renderer,
-                                 const std::filesystem::path& path) const = 0;
-};
+struct CFGLayout;
 
 struct LayoutBuilder {
     enum class EdgeType : uint8_t { Default, True, False };
 
+    /// @brief A node without a match in `warm_start`
+    static constexpr size_t NO_MATCH = std::numeric_limits<size_t>::max();
+
     LayoutBuilder() = default;
 
     virtual ~LayoutBuilder() = default;
@@ -183,15 +172,465 @@ struct LayoutBuilder {
     /// @return The id of the edge in the graph
     virtual auto make_edge(size_t from, size_t to, EdgeType type) -> size_t = 0;
 
+    /// @brief Makes room for `nodes` nodes and `edges` edges in all
+    virtual void reserve(size_t nodes, size_t edges) = 0;
+
+    /// @brief Adds `count` nodes to the graph
+    /// @return The id of the first node, the others follow
+    virtual auto make_nodes(size_t count) -> size_t = 0;
+
+    /// @brief Adds `count` nodes to the graph.
+    /// Node `i` is `widths[i]` wide and `heights[i]` high
+    /// @return The id of the first node, the others follow
+    virtual auto make_nodes(size_t count,
+                            std::span<const float> widths,
+                            std::span<const float> heights) -> size_t = 0;
+
+    /// @brief Adds an edge from each `from[i]` to `to[i]`.
+    /// The ids are checked once for all the edges
+    /// @return The id of the first edge, the others follow
+    virtual auto make_edges(std::span<const size_t> from,
+                            std::span<const size_t> to) -> size_t = 0;
+
+    /// @brief Adds an edge of type `types[i]` from each `from[i]` to `to[i]`.
+    /// The ids are checked once for all the edges
+    /// @return The id of the first edge, the others follow
+    virtual auto make_edges(std::span<const size_t> from,
+                            std::span<const size_t> to,
+                            std::span<const EdgeType> types) -> size_t = 0;
+
+    /// @brief Returns the number of nodes added so far
+    [[nodiscard]] virtual auto node_count() const -> size_t = 0;
+
+    /// @brief Returns the number of edges added so far
+    [[nodiscard]] virtual auto edge_count() const -> size_t = 0;
+
     /// @brief Returns a graphviz representation of the graph
     [[nodiscard]] virtual auto graphviz() const -> std::string = 0;
 
     /// @brief Lays out the CFG
     [[nodiscard]] virtual auto build() -> std::unique_ptr<CFGLayout> = 0;
+
+    /// @brief Lays out the CFG, drawing the transient buffers from `context`.
+    /// Pass the same context to the builds made one after the other on a
+    /// thread to reuse their memory
+    [[nodiscard]] virtual auto build(LayoutContext& context)
+        -> std::unique_ptr<CFGLayout> = 0;
+
+    /// @brief Lays out the CFG in a task submitted to `executor`. Like
+    /// `build`, this ends the edits of the builder
+    /// @param cancellation stops the layout, the future then throws
+    /// `LayoutCancelled`
+    /// @param progress called by the task with the phase of the layout and the
+    /// fraction done. Can be empty
+    [[nodiscard]] virtual auto build_async(
+        Executor& executor,
+        CancellationToken cancellation,
+        ProgressCallback progress)
+        -> std::future<std::unique_ptr<CFGLayout>> = 0;
+
+    /// @brief Starts the layout from `previous`, a layout of a similar CFG.
+    /// The regions that are identical in both CFGs keep their layout. The
+    /// nodes of the other regions start from their order in `previous`, see
+    /// `LayoutOptions::warm_start_max_shift`
+    /// @param node_map the node of `previous` matching each node, or
+    /// `NO_MATCH`. Can be empty
+    virtual void warm_start(const CFGLayout& previous,
+                            const std::vector<size_t>& node_map) = 0;
+};
+
+/// @brief The box of a node, `x` and `y` are its top left
+struct Rect {
+    float x;
+    float y;
+    float width;
+    float height;
+};
+
+/// @brief A built layout reduced to what is needed to draw it: the boxes of
+/// the nodes, the waypoints of the edges, their types and the labels, in flat
+/// arrays.
+/// It can't be edited and is safe to read from several threads. The copies of
+/// a frozen layout share their arrays
+struct FrozenLayout {
+    /// @brief The arrays of a frozen layout
+    struct Data {
+        /// @brief The box of each node
+        std::vector<Rect> rects;
+
+        /// @brief The waypoints of edge `i` are in
+        /// `[waypoint_offsets[i], waypoint_offsets[i + 1])`
+        std::vector<size_t> waypoint_offsets;
+        std::vector<Point> waypoints;
+
+        /// @brief The type of each edge
+        std::vector<LayoutBuilder::EdgeType> edge_types;
+
+        /// @brief The label of node `i` is in
+        /// `[label_offsets[i], label_offsets[i + 1])`
+        std::vector<size_t> label_offsets;
+        std::string labels;
+
+        float width  = 0;
+        float height = 0;
+
+        LayoutStats stats;
+    };
+
+    /// @brief The version of the files written by `save`
+    static constexpr uint32_t FORMAT_VERSION = 1;
+
+    /// @brief Checks that the offsets match the arrays
+    explicit FrozenLayout(Data data);
+
+    /// @brief Maps a file written by `save` in memory. The arrays are read
+    /// from the file as they are used, only its header is read here.
+    /// The offsets are checked as they are used, a damaged file makes the
+    /// accessors throw
+    [[nodiscard]] static auto load(const std::filesystem::path& path)
+        -> FrozenLayout;
+
+    /// @brief Writes the layout in a single pass. The file is versioned and
+    /// little endian: a header, the boxes of the nodes, the waypoint offsets,
+    /// the waypoints, the edge types and, if `labels` is set, the label
+    /// offsets and the labels. Only the dummy, phantom and concentrated edge
+    /// counts of the stats are kept
+    void save(std::ostream& out, bool labels = true) const;
+
+    /// @brief Writes the layout to `path`, see `save(std::ostream&, bool)`
+    void save(const std::filesystem::path& path, bool labels = true) const;
+
+    /// @brief Return the top left of the `node` basic block
+    [[nodiscard]] auto get_coords(size_t node) const -> Point;
+
+    /// @brief Returns the box of the `node` basic block
+    [[nodiscard]] auto get_rect(size_t node) const -> Rect;
+
+    /// @brief Returns the waypoints that the edge `edge` should follow.
+    /// Removed edges have none
+    [[nodiscard]] auto get_waypoints(size_t edge) const -> WaypointsView;
+
+    /// @brief Returns the type of the edge `edge`
+    [[nodiscard]] auto get_edge_type(size_t edge) const
+        -> LayoutBuilder::EdgeType;
+
+    /// @brief Returns the label of the `node` basic block, empty if the
+    /// layout was saved without its labels
+    [[nodiscard]] auto get_label(size_t node) const -> std::string_view;
+
+    /// @brief Returns the height of the graph
+    [[nodiscard]] auto get_height() const -> float { return height_; }
+
+    /// @brief Returns the width of the graph
+    [[nodiscard]] auto get_width() const -> float { return width_; }
+
+    /// @brief Returns the number of nodes
+    [[nodiscard]] auto node_count() const -> size_t { return rects_.size(); }
+
+    /// @brief Returns the number of edge ids, the removed edges included
+    [[nodiscard]] auto edge_count() const -> size_t {
+        return edge_types_.size();
+    }
+
+    /// @brief Returns the measurements made while laying out the graph
+    [[nodiscard]] auto get_stats() const -> const LayoutStats& {
+        return stats_;
+    }
+
+    /// @brief The box of each node, by id
+    [[nodiscard]] auto node_rects() const -> std::span<const Rect> {
+        return rects_;
+    }
+
+    /// @brief The waypoints of edge `i` are in
+    /// `waypoints()[waypoint_offsets()[i], waypoint_offsets()[i + 1])`
+    [[nodiscard]] auto waypoint_offsets() const -> std::span<const size_t> {
+        return waypoint_offsets_;
+    }
+
+    /// @brief The waypoints of every edge, in the order of their ids
+    [[nodiscard]] auto waypoints() const -> std::span<const Point> {
+        return waypoints_;
+    }
+
+    /// @brief The type of each edge, by id
+    [[nodiscard]] auto edge_types() const
+        -> std::span<const LayoutBuilder::EdgeType> {
+        return edge_types_;
+    }
+
+    /// @brief The label of node `i` is in
+    /// `labels()[label_offsets()[i], label_offsets()[i + 1])`.
+    /// Empty if the layout was saved without its labels
+    [[nodiscard]] auto label_offsets() const -> std::span<const size_t> {
+        return label_offsets_;
+    }
+
+    /// @brief The labels of the nodes, one after the other
+    [[nodiscard]] auto labels() const -> std::string_view { return labels_; }
+
+    /// @brief The number of bytes used by the layout and its arrays
+    [[nodiscard]] auto footprint() const -> size_t;
+
+    /// @brief Whether all the offsets match the arrays. A loaded layout for
+    /// which this holds never throws from its accessors
+    [[nodiscard]] auto is_valid() const -> bool;
+
+    /// @brief Renders the cfg
+    void render(Renderer& renderer) const;
+
+    /// @brief Save the cfg
+    /// @param path the path where the render will be saved
+    void render_and_save(ExportingRenderer& renderer,
+                         const std::filesystem::path& path) const;
+
+   private:
+    friend struct DiskCache;
+
+    FrozenLayout() = default;
+
+    /// @brief Keeps the arrays alive, a `Data` or a mapped file
+    std::shared_ptr<const void> owner_;
+
+    std::span<const Rect> rects_;
+    std::span<const size_t> waypoint_offsets_;
+    std::span<const Point> waypoints_;
+    std::span<const LayoutBuilder::EdgeType> edge_types_;
+    std::span<const size_t> label_offsets_;
+    std::string_view labels_;
+
+    float width_  = 0;
+    float height_ = 0;
+
+    LayoutStats stats_;
+};
+
+/// @brief Whole layouts kept in a directory and reused across runs by the
+/// builds whose `LayoutOptions::disk_cache` points to it.
+/// A layout is stored under a hash of `LAYOUT_VERSION`, the graph, the sizes
+/// and labels of the nodes, the types of the edges and the layout options.
+/// The files are replaced atomically, several processes can share the
+/// directory. Thread safe
+struct DiskCache {
+    /// @brief A 128 bits hash of what the layout depends on
+    using Key = std::array<uint64_t, 2>;
+
+    /// @brief The size of the directory kept by default
+    static constexpr size_t DEFAULT_MAX_BYTES = size_t{256} << 20U;
+
+    /// @brief The version of the layout algorithm, hashed into the keys. Bump
+    /// it with any change to the results of the layout so that the layouts
+    /// stored by earlier versions are no longer served
+    static constexpr uint64_t LAYOUT_VERSION = 1;
+
+    /// @param directory created if it does not exist
+    /// @param max_bytes the size of the stored layouts above which the least
+    /// recently used ones are removed
+    explicit DiskCache(std::filesystem::path directory,
+                       size_t max_bytes = DEFAULT_MAX_BYTES);
+
+    DiskCache(const DiskCache&)                    = delete;
+    DiskCache(DiskCache&&)                         = delete;
+    auto operator=(const DiskCache&) -> DiskCache& = delete;
+    auto operator=(DiskCache&&) -> DiskCache&      = delete;
+
+    /// @brief Maps the layout stored under `key` by `FrozenLayout::save`,
+    /// marked as coming from the disk cache. Missing or damaged files, and
+    /// layouts without `node_count` nodes and `edge_count` edges are misses
+    [[nodiscard]] auto find(const Key& key,
+                            size_t node_count,
+                            size_t edge_count) -> std::optional<FrozenLayout>;
+
+    /// @brief Stores `layout` under `key`, with its labels, then removes
+    /// the least recently used layouts if the directory is too large.
+    /// Failing to write the file leaves the cache as it was
+    void insert(const Key& key, const FrozenLayout& layout);
+
+    /// @brief Removes every stored layout
+    void clear();
+
+    [[nodiscard]] auto directory() const -> const std::filesystem::path& {
+        return directory_;
+    }
+
+    [[nodiscard]] auto max_bytes() const -> size_t { return max_bytes_; }
+
+    /// @brief The size of the stored layouts, as last measured by this cache
+    [[nodiscard]] auto size() const -> size_t;
+
+    /// @brief The number of layouts found so far
+    [[nodiscard]] auto hits() const -> size_t {
+        return hits_.load(std::memory_order_relaxed);
+    }
+
+    /// @brief The number of layouts looked for and not found so far
+    [[nodiscard]] auto misses() const -> size_t {
+        return misses_.load(std::memory_order_relaxed);
+    }
+
+   private:
+    /// @brief The file holding the layout stored under `key`
+    [[nodiscard]] auto path_of(const Key& key) const -> std::filesystem::path;
+
+    /// @brief Removes the least recently used layouts until the directory
+    /// fits in `max_bytes_`. Takes `mutex_`
+    void evict();
+
+    std::filesystem::path directory_;
+    size_t max_bytes_;
+
+    mutable std::mutex mutex_;
+
+    /// @brief The size of the directory, measured when the cache is created
+    /// and on eviction, then grown by the insertions
+    size_t bytes_ = 0;
+
+    std::atomic<size_t> hits_{0};
+    std::atomic<size_t> misses_{0};
+};
+
+struct CFGLayout {
+    CFGLayout() = default;
+
+    virtual ~CFGLayout() = default;
+
+    /// @brief Return the x coordinate of the top left of the `node` basic
+    /// block
+    [[nodiscard]] virtual auto get_coords(size_t node) const -> Point = 0;
+
+    /// @brief Returns the waypoints that the edge `edge` should follow
+    [[nodiscard]] virtual auto get_waypoints(size_t edge) const
+        -> WaypointsView = 0;
+
+    /// @brief Returns the height of the graph
+    [[nodiscard]] virtual auto get_height() const -> float = 0;
+
+    /// @brief Returns the width of the graph
+    [[nodiscard]] virtual auto get_width() const -> float = 0;
+
+    /// @brief Returns the number of node ids
+    [[nodiscard]] virtual auto node_count() const -> size_t = 0;
+
+    /// @brief Returns the number of edge ids, the removed edges included
+    [[nodiscard]] virtual auto edge_count() const -> size_t = 0;
+
+    /// @brief Returns measurements made while laying out the graph
+    [[nodiscard]] virtual auto get_stats() const -> const LayoutStats& = 0;
+
+    /// @brief The box of each node, by id.
+    /// The views into the layout stay valid until the layout is updated
+    [[nodiscard]] virtual auto node_rects() const -> std::span<const Rect> = 0;
+
+    /// @brief The waypoints of edge `i` are in
+    /// `waypoints()[waypoint_offsets()[i], waypoint_offsets()[i + 1])`.
+    /// Removed edges have none
+    [[nodiscard]] virtual auto waypoint_offsets() const
+        -> std::span<const size_t> = 0;
+
+    /// @brief The waypoints of every edge, in the order of their ids
+    [[nodiscard]] virtual auto waypoints() const
+        -> std::span<const Point> = 0;
+
+    /// @brief The type of each edge, by id
+    [[nodiscard]] virtual auto edge_types() const
+        -> std::span<const LayoutBuilder::EdgeType> = 0;
+
+    /// @brief Resizes the `node` basic block and updates the layout.
+    /// Only the regions containing the node are laid out again
+    virtual void update_node_size(size_t node, float width, float height) = 0;
+
+    /// @brief Calculates the dimension of each node using the renderer and
+    /// updates the layout.
+    /// Only the coordinates and the waypoints are computed again, the
+    /// regions, layers and orders of the nodes are reused when they don't
+    /// depend on the new sizes
+    virtual void measure_nodes(const Renderer& renderer) = 0;
+
+    /// @brief Adds an edge and updates the layout.
+    /// The regions left unchanged by the edge keep their layout
+    /// @return The id of the edge in the graph
+    virtual auto add_edge(size_t from, size_t to) -> size_t = 0;
+
+    /// @brief Adds an edge and updates the layout.
+    /// The regions left unchanged by the edge keep their layout
+    /// @return The id of the edge in the graph
+    virtual auto add_edge(size_t from,
+                          size_t to,
+                          LayoutBuilder::EdgeType type) -> size_t = 0;
+
+    /// @brief Removes an edge and updates the layout.
+    /// The regions left unchanged by the removal keep their layout
+    virtual void remove_edge(size_t edge) = 0;
+
+    /// @brief Splits the `node` basic block in two and updates the layout.
+    /// The new node takes the outgoing edges of `node` and gets its size
+    /// @return The id of the new node, the successor of `node`
+    virtual auto split_node(size_t node) -> size_t = 0;
+
+    /// @brief The result of the layout as a `FrozenLayout`, which shares the
+    /// arrays of the views. The graph and the steps of the layout can then be
+    /// dropped
+    [[nodiscard]] virtual auto freeze() const -> FrozenLayout = 0;
+
+    /// @brief Renders the cfg
+    virtual void render(Renderer& renderer) const = 0;
+
+    /// @brief Save the cfg
+    /// @param path the path where the render will be saved
+    virtual void render_and_save(ExportingRenderer& renderer,
+                                 const std::filesystem::path& path) const = 0;
 };
 
 [[nodiscard]] auto make_layout_builder() -> std::unique_ptr<LayoutBuilder>;
 
+/// @brief Creates a layout builder whose layouts use the given `options`
+[[nodiscard]] auto make_layout_builder(const LayoutOptions& options)
+    -> std::unique_ptr<LayoutBuilder>;
+
+/// @brief Creates a layout builder holding a graph in CSR form: the edges of
+/// node `i` go to `targets[offsets[i], offsets[i + 1])`
+/// @param types the type of each edge, in the order of `targets`. Can be empty
+[[nodiscard]] auto make_layout_builder(
+    std::span<const size_t> offsets,
+    std::span<const size_t> targets,
+    std::span<const LayoutBuilder::EdgeType> types = {},
+    const LayoutOptions& options                   = {})
+    -> std::unique_ptr<LayoutBuilder>;
+
+/// @brief Settings of `layout_batch`
+struct BatchOptions {
+    /// @brief Runs the layouts. `nullptr` uses `default_executor()`
+    Executor* executor = nullptr;
+
+    /// @brief The number of graphs laid out at the same time, the calling
+    /// thread included. `0` uses the concurrency of the executor
+    size_t threads = 0;
+};
+
+/// @brief The outcome of the layout of one graph of a batch
+struct BatchResult {
+    /// @brief The layout, `nullptr` if it failed
+    std::unique_ptr<CFGLayout> layout;
+
+    /// @brief Why the layout failed
+    std::exception_ptr error;
+
+    /// @brief The time spent laying the graph out
+    std::chrono::nanoseconds time{0};
+
+    [[nodiscard]] auto ok() const -> bool { return layout != nullptr; }
+};
+
+/// @brief Lays out independent graphs concurrently, the largest first.
+/// Each graph is built by one thread, with the options of its builder. The
+/// graphs built by a thread share a `LayoutContext`. The builders end like
+/// after `build`
+/// @return The result of each builder, in the same order
+[[nodiscard]] auto layout_batch(std::span<std::unique_ptr<LayoutBuilder>>
+                                    builders,
+                                const BatchOptions& options = {})
+    -> std::vector<BatchResult>;
+
 }  // namespace triskel
 
 #ifdef TRISKEL_CAIRO
@@ -236,9 +675,17 @@ struct ImguiRenderer : Renderer {
 #include "llvm/IR/ModuleSlotTracker.h"
 
 namespace triskel {
+/// @brief Creates a layout builder holding the CFG of `function`
+[[nodiscard]] auto make_layout_builder(llvm::Function* function,
+                                       Renderer* render             = nullptr,
+                                       llvm::ModuleSlotTracker* MST = nullptr,
+                                       const LayoutOptions& options = {})
+    -> std::unique_ptr<LayoutBuilder>;
+
 [[nodiscard]] auto make_layout(llvm::Function* function,
                                Renderer* render             = nullptr,
-                               llvm::ModuleSlotTracker* MST = nullptr)
+                               llvm::ModuleSlotTracker* MST = nullptr,
+                               const LayoutOptions& options = {})
     -> std::unique_ptr<CFGLayout>;
 }  // namespace triskel
 #endif
@@ -1,6 +1,8 @@
 #pragma once
 
 #include <fmt/printf.h>
+#include <algorithm>
+#include <span>
 #include <type_traits>
 #include <vector>
 
@@ -89,6 +91,22 @@ struct Attribute {
         data_[id_] = std::move(v);
     }
 
+    /// @brief Sets the ids from `first` on to `values`
+    void set(const ID<Tag>& first, std::span<const T> values) {
+        auto first_ = static_cast<size_t>(first);
+        reserve(first_ + values.size());
+        std::ranges::copy(values, data_.begin() + first_);
+    }
+
+    /// @brief Makes room for the ids below `size`, accessing them then never
+    /// resizes the attribute. This allows accessing distinct ids from several
+    /// threads
+    void reserve(size_t size) {
+        if (size > data_.size()) {
+            data_.resize(size, v_);
+        }
+    }
+
    private:
     /// @brief This is a const function thanks to mutable
     auto resize_if_necessary(size_t id) const {
@@ -15,6 +15,7 @@ constexpr uint8_t DEFAULT_PRIORITY        = 0;
 constexpr uint8_t WAYPOINT_PRIORITY       = 1;
 constexpr uint8_t ENTRY_WAYPOINT_PRIORITY = 2;
 constexpr uint8_t EXIT_WAYPOINT_PRIORITY  = 2;
+constexpr uint8_t SEGMENT_PRIORITY        = 3;
 
 // The space between nodes
 constexpr float X_GUTTER = 50.0F;
@@ -0,0 +1,124 @@
+#pragma once
+
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+
+namespace triskel {
+
+/// @brief Runs the tasks of the parallel steps of triskel.
+/// Implement it to run them on the threads of the host application
+struct Executor {
+    using Task = std::function<void()>;
+
+    Executor() = default;
+
+    virtual ~Executor() = default;
+
+    Executor(const Executor&)                    = delete;
+    Executor(Executor&&)                         = delete;
+    auto operator=(const Executor&) -> Executor& = delete;
+    auto operator=(Executor&&) -> Executor&      = delete;
+
+    /// @brief Queues a task, it may run on any thread. Tasks may submit other
+    /// tasks
+    virtual void submit(Task task) = 0;
+
+    /// @brief Waits for every submitted task. Rethrows the first exception
+    /// thrown by a task
+    virtual void wait() = 0;
+
+    /// @brief The number of tasks that can run at the same time
+    [[nodiscard]] virtual auto concurrency() const -> size_t = 0;
+
+    /// @brief Calls `body` with each index in `[0, count)` and waits for the
+    /// calls. The calling thread takes part, it can be one of the executor's
+    /// threads. Rethrows the first exception thrown by `body`
+    virtual void parallel_for(size_t count,
+                              const std::function<void(size_t)>& body);
+};
+
+/// @brief Runs each task on the calling thread, when it is submitted
+struct InlineExecutor : Executor {
+    InlineExecutor() = default;
+
+    ~InlineExecutor() override = default;
+
+    void submit(Task task) override;
+
+    void wait() override;
+
+    [[nodiscard]] auto concurrency() const -> size_t override { return 1; }
+
+   private:
+    std::exception_ptr error_;
+};
+
+/// @brief Tasks run on an executor by at most `width` threads, the thread
+/// waiting for them included.
+/// The waiting thread runs the tasks no other thread took, waiting from one of
+/// the executor's threads never deadlocks
+struct TaskGroup {
+    TaskGroup(Executor& executor, size_t width);
+
+    /// @brief Drops the queued tasks and waits for the running ones
+    ~TaskGroup();
+
+    TaskGroup(const TaskGroup&)                    = delete;
+    TaskGroup(TaskGroup&&)                         = delete;
+    auto operator=(const TaskGroup&) -> TaskGroup& = delete;
+    auto operator=(TaskGroup&&) -> TaskGroup&      = delete;
+
+    /// @brief Queues a task. Tasks may run other tasks of the group
+    void run(Executor::Task task);
+
+    /// @brief Runs and waits for every task of the group. Rethrows the first
+    /// exception thrown by a task
+    void wait();
+
+   private:
+    /// @brief Shared with the tasks submitted to the executor, which may start
+    /// after the group is done
+    struct State {
+        std::mutex mutex;
+        std::condition_variable changed;
+
+        std::deque<Executor::Task> tasks;
+
+        /// @brief The number of tasks being run
+        size_t running = 0;
+
+        /// @brief The number of `drain` calls submitted to the executor that
+        /// are not done
+        size_t drainers = 0;
+
+        std::exception_ptr error;
+
+        /// @brief Runs a task taken from the queue, with the lock held before
+        /// and after
+        void run_one(std::unique_lock<std::mutex>& lock);
+
+        /// @brief Runs the queued tasks, on one of the executor's threads,
+        /// until there are none left
+        void drain();
+    };
+
+    Executor& executor_;
+    size_t width_;
+
+    std::shared_ptr<State> state_;
+};
+
+/// @brief The executor used when `LayoutOptions::executor` is not set.
+/// Defaults to a pool with a thread per core, created when first used
+[[nodiscard]] auto default_executor() -> std::shared_ptr<Executor>;
+
+/// @brief Replaces the default executor, `nullptr` restores the built-in pool.
+/// The layouts that already started keep their executor
+void set_default_executor(std::shared_ptr<Executor> executor);
+
+}  // namespace triskel
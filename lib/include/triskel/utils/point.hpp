@@ -11,6 +11,10 @@ inline auto operator+(const Point& l, const Point& r) -> Point {
     return {.x = l.x + r.x, .y = l.y + r.y};
 }
 
+inline auto operator==(const Point& l, const Point& r) -> bool {
+    return l.x == r.x && l.y == r.y;
+}
+
 inline auto operator+=(Point& l, const Point& r) -> Point& {
     l = l + r;
     return l;
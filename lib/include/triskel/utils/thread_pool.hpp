@@ -0,0 +1,79 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <thread>
+#include <vector>
+
+#include "triskel/utils/executor.hpp"
+
+namespace triskel {
+
+/// @brief A pool of threads with one task queue per thread.
+/// Workers run their own tasks last in first out and steal the oldest tasks
+/// of the other workers when their queue is empty
+struct ThreadPool : Executor {
+    /// @brief Starts `thread_count` workers, at least one
+    explicit ThreadPool(size_t thread_count);
+
+    /// @brief Stops the workers, the tasks that did not start are dropped
+    ~ThreadPool() override;
+
+    ThreadPool(const ThreadPool&)                    = delete;
+    ThreadPool(ThreadPool&&)                         = delete;
+    auto operator=(const ThreadPool&) -> ThreadPool& = delete;
+    auto operator=(ThreadPool&&) -> ThreadPool&      = delete;
+
+    /// @brief Queues a task. Tasks submitted by a worker go to its own queue
+    void submit(Task task) override;
+
+    /// @brief Waits for every task, including the ones submitted by other
+    /// tasks. Rethrows the first exception thrown by a task
+    void wait() override;
+
+    [[nodiscard]] auto concurrency() const -> size_t override {
+        return threads_.size();
+    }
+
+   private:
+    struct Queue {
+        std::mutex mutex;
+        std::deque<Task> tasks;
+    };
+
+    void run(size_t worker);
+
+    /// @brief Takes a task from the worker's queue or steals one
+    [[nodiscard]] auto take(size_t worker) -> std::optional<Task>;
+
+    std::vector<std::unique_ptr<Queue>> queues_;
+    std::vector<std::thread> threads_;
+
+    /// @brief Wakes the sleeping workers
+    std::mutex mutex_;
+    std::condition_variable wake_;
+
+    /// @brief Signals that every task is done
+    std::condition_variable done_;
+
+    /// @brief The number of tasks waiting in the queues
+    std::atomic<size_t> queued_ = 0;
+
+    /// @brief The number of tasks that are not done
+    size_t pending_ = 0;
+
+    std::atomic<size_t> next_queue_ = 0;
+
+    std::exception_ptr error_;
+
+    bool stop_ = false;
+};
+
+}  // namespace triskel
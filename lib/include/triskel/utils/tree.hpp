@@ -3,13 +3,25 @@
 #include <algorithm>
 #include <cassert>
 #include <cstddef>
-#include <memory>
+#include <limits>
+#include <ranges>
+#include <span>
+#include <utility>
 #include <vector>
 
 namespace triskel {
 
+/// @brief A tree whose nodes are stored contiguously.
+///
+/// Nodes link to each other through their ids. Removing a node only marks it
+/// as removed, the removed nodes are dropped and the ids renumbered by
+/// `compact`, which also stores the children of each node as a contiguous
+/// range (CSR).
 template <typename T>
 struct Tree {
+    /// @brief The id of a missing node
+    static constexpr size_t InvalidID = std::numeric_limits<size_t>::max();
+
     struct Node {
         auto operator->() -> T* { return &label; }
         auto operator->() const -> const T* { return &label; }
@@ -20,47 +32,57 @@ struct Tree {
 
         /// @brief Is this node the root
         [[nodiscard]] auto is_root() const -> bool {
-            return parent_ == nullptr;
+            return parent_ == InvalidID;
         }
 
         /// @brief Finds the root of this tree
         [[nodiscard]] auto root() -> Node& {
-            if (is_root()) {
-                return *this;
+            auto* node = this;
+            while (!node->is_root()) {
+                node = &node->parent();
             }
 
-            return parent_->is_root();
+            return *node;
         }
 
         /// @brief The parent of this node. The node shouldn't be the root
         [[nodiscard]] auto parent() -> Node& {
             assert(!is_root());
-            return *parent_;
+            return tree_->nodes[parent_];
         }
 
         /// @brief The parent of this node. The node shouldn't be the root
         [[nodiscard]] auto parent() const -> const Node& {
             assert(!is_root());
-            return *parent_;
+            return tree_->nodes[parent_];
         }
 
-        /// @brief Is this node the root
-        [[nodiscard]] auto children() const -> const std::vector<Node*>& {
-            return children_;
+        /// @brief The children of this node, in the order of their ids.
+        /// The tree should be compact
+        [[nodiscard]] auto children() const {
+            assert(tree_->is_compact());
+
+            auto* tree = tree_;
+            return std::span{tree->children_}.subspan(
+                       children_begin_, children_end_ - children_begin_) |
+                   std::views::transform(
+                       [tree](size_t id) -> Node* { return &tree->nodes[id]; });
+        }
+
+        /// @brief Is this node `other` or one of its ancestors.
+        /// The tree should be compact
+        [[nodiscard]] auto is_ancestor_of(const Node& other) const -> bool {
+            assert(tree_->is_compact());
+            return enter_ <= other.enter_ && other.exit_ <= exit_;
         }
 
         /// @brief Adds a child to this node
         void add_child(Node* node) {
-            node->parent_ = this;
+            node->parent_ = id;
             node->depth   = depth + 1;
 
-            children_.push_back(node);
-        }
-
-        void remove_child(const Node* node) {
-            children_.erase(
-                std::remove(children_.begin(), children_.end(), node),
-                children_.end());
+            child_count_++;
+            tree_->compact_ = false;
         }
 
         /// @brief The data in the label
@@ -72,35 +94,224 @@ struct Tree {
         size_t depth = 0;
 
        private:
-        Node* parent_;
-        std::vector<Node*> children_;
+        Tree* tree_;
+        size_t parent_ = InvalidID;
+
+        // The range of this node's children in `Tree::children_`
+        size_t children_begin_ = 0;
+        size_t children_end_   = 0;
+
+        // The number of children that were not removed
+        size_t child_count_ = 0;
+
+        // The interval of this node's subtree in a preorder of the tree
+        size_t enter_ = 0;
+        size_t exit_  = 0;
+
+        bool removed_ = false;
 
         template <typename U>
         friend struct Tree;
     };
 
+    Tree() = default;
+
+    // The nodes point back to their tree
+    Tree(const Tree&)                    = delete;
+    Tree(Tree&&)                         = delete;
+    auto operator=(const Tree&) -> Tree& = delete;
+    auto operator=(Tree&&) -> Tree&      = delete;
+
+    /// @brief Creates a node. References to the nodes are invalidated
     [[nodiscard]] auto make_node() -> Node& {
-        nodes.push_back(std::make_unique<Node>());
-        auto& node = nodes.back();
+        auto& node = nodes.emplace_back();
+
+        node.id    = nodes.size() - 1;
+        node.tree_ = this;
+        compact_   = false;
+        return node;
+    }
 
-        node->id = nodes.size() - 1;
-        return *node;
+    /// @brief The root, the first node created
+    [[nodiscard]] auto root() -> Node& {
+        assert(!nodes.empty());
+        return nodes.front();
     }
 
+    /// @brief The root, the first node created
+    [[nodiscard]] auto root() const -> const Node& {
+        assert(!nodes.empty());
+        return nodes.front();
+    }
+
+    /// @brief Marks a leaf as removed. It stays in `nodes` until `compact`
     void remove_node(Node* node) {
-        assert(node != root);
-        assert(node->children_.empty());
-
-        node->parent().remove_child(node);
-        nodes.erase(std::remove_if(nodes.begin(), nodes.end(),
-                                   [node](const std::unique_ptr<Node>& a) {
-                                       return a.get() == node;
-                                   }),
-                    nodes.end());
+        assert(!node->is_root());
+        assert(node->child_count_ == 0);
+        assert(!node->removed_);
+
+        node->removed_ = true;
+        node->parent().child_count_--;
+        compact_ = false;
+    }
+
+    /// @brief Drops the removed nodes, renumbers the others and groups the
+    /// children of each node. The order of the nodes is kept.
+    /// Returns the new id of each old id, `InvalidID` for the removed nodes
+    auto compact() -> std::vector<size_t> {
+        auto new_ids = std::vector<size_t>(nodes.size(), InvalidID);
+
+        auto count = size_t{0};
+        for (auto& node : nodes) {
+            if (!node.removed_) {
+                new_ids[node.id] = count;
+                count++;
+            }
+        }
+
+        auto live = std::vector<Node>{};
+        live.reserve(count);
+        for (auto& node : nodes) {
+            if (node.removed_) {
+                continue;
+            }
+
+            auto& n = live.emplace_back(std::move(node));
+            n.id    = new_ids[n.id];
+            if (!n.is_root()) {
+                n.parent_ = new_ids[n.parent_];
+            }
+        }
+
+        nodes = std::move(live);
+
+        // Counting sort of the nodes by parent
+        auto offsets = std::vector<size_t>(nodes.size() + 1, 0);
+        for (const auto& node : nodes) {
+            if (!node.is_root()) {
+                offsets[node.parent_ + 1]++;
+            }
+        }
+
+        for (size_t i = 1; i < offsets.size(); ++i) {
+            offsets[i] += offsets[i - 1];
+        }
+
+        children_.resize(offsets.back());
+        for (auto& node : nodes) {
+            node.children_begin_ = offsets[node.id];
+            node.children_end_   = offsets[node.id];
+        }
+
+        for (const auto& node : nodes) {
+            if (!node.is_root()) {
+                auto& parent = nodes[node.parent_];
+                children_[parent.children_end_] = node.id;
+                parent.children_end_++;
+            }
+        }
+
+        index_ancestors();
+
+        compact_ = true;
+        return new_ids;
     }
 
-    Node* root;
-    std::vector<std::unique_ptr<Node>> nodes;
+    /// @brief The deepest node that is an ancestor of both `a` and `b`.
+    /// Takes O(log depth), the tree should be compact
+    [[nodiscard]] auto lowest_common_ancestor(const Node& a, const Node& b)
+        -> Node& {
+        assert(is_compact());
+
+        if (a.is_ancestor_of(b)) {
+            return nodes[a.id];
+        }
+
+        if (b.is_ancestor_of(a)) {
+            return nodes[b.id];
+        }
+
+        // Climbs from `a` to the highest ancestor that isn't an ancestor of `b`
+        auto id = a.id;
+        for (size_t k = ancestors_.size(); k-- > 0;) {
+            const auto& ancestor = nodes[ancestors_[k][id]];
+            if (!ancestor.is_ancestor_of(b)) {
+                id = ancestor.id;
+            }
+        }
+
+        return nodes[id].parent();
+    }
+
+    /// @brief Have the nodes been grouped by `compact` since the last change
+    [[nodiscard]] auto is_compact() const -> bool { return compact_; }
+
+    std::vector<Node> nodes;
+
+   private:
+    /// @brief Numbers the nodes in preorder and builds the binary lifting
+    /// table
+    void index_ancestors() {
+        if (nodes.empty()) {
+            return;
+        }
+
+        auto max_depth = size_t{0};
+        auto time      = size_t{0};
+
+        assert(nodes.front().is_root());
+
+        // Pairs of a node and the next child to visit
+        auto stack = std::vector<std::pair<size_t, size_t>>{{0, 0}};
+        nodes[0].enter_ = time++;
+        nodes[0].depth  = 0;
+
+        while (!stack.empty()) {
+            auto& [id, next] = stack.back();
+            auto& node       = nodes[id];
+
+            if (node.children_begin_ + next == node.children_end_) {
+                node.exit_ = time - 1;
+                stack.pop_back();
+                continue;
+            }
+
+            auto& child = nodes[children_[node.children_begin_ + next]];
+            next++;
+
+            child.enter_ = time++;
+            child.depth  = node.depth + 1;
+            max_depth    = std::max(max_depth, child.depth);
+            stack.emplace_back(child.id, 0);
+        }
+
+        // ancestors_[k][v] is the 2^k-th ancestor of v, the root being its
+        // own ancestor
+        ancestors_.clear();
+        auto& parents = ancestors_.emplace_back(nodes.size());
+        for (const auto& node : nodes) {
+            parents[node.id] = node.is_root() ? node.id : node.parent_;
+        }
+
+        for (size_t jump = 2; jump <= max_depth; jump *= 2) {
+            const auto& previous = ancestors_.back();
+            auto ancestors       = std::vector<size_t>(nodes.size());
+
+            for (size_t v = 0; v < nodes.size(); ++v) {
+                ancestors[v] = previous[previous[v]];
+            }
+
+            ancestors_.push_back(std::move(ancestors));
+        }
+    }
+
+    /// @brief The ids of the children of every node, grouped by parent
+    std::vector<size_t> children_;
+
+    /// @brief The binary lifting table of the tree
+    std::vector<std::vector<size_t>> ancestors_;
+
+    bool compact_ = true;
 };
 
-}  // namespace triskel
\ No newline at end of file
+}  // namespace triskel
@@ -0,0 +1,96 @@
+#pragma once
+
+#include <cstddef>
+#include <iterator>
+#include <span>
+#include <vector>
+
+#include "triskel/utils/point.hpp"
+
+namespace triskel {
+
+/// @brief A read only view of the waypoints of an edge.
+/// The coordinates are read from two arrays of floats, `stride` floats apart
+struct WaypointsView {
+    struct Iterator {
+        using iterator_concept = std::forward_iterator_tag;
+        using value_type       = Point;
+        using difference_type  = std::ptrdiff_t;
+
+        [[nodiscard]] auto operator*() const -> Point { return (*view)[i]; }
+
+        auto operator++() -> Iterator& {
+            i++;
+            return *this;
+        }
+
+        auto operator++(int) -> Iterator {
+            auto it = *this;
+            i++;
+            return it;
+        }
+
+        auto operator==(const Iterator& other) const -> bool {
+            return i == other.i;
+        }
+
+        const WaypointsView* view = nullptr;
+        size_t i                  = 0;
+    };
+
+    WaypointsView() = default;
+
+    WaypointsView(const float* xs,
+                  const float* ys,
+                  size_t size,
+                  size_t stride = 1)
+        : xs_{xs}, ys_{ys}, size_{size}, stride_{stride} {}
+
+    /// @brief A view of an array of points
+    // NOLINTNEXTLINE(google-explicit-constructor)
+    WaypointsView(std::span<const Point> points)
+        : WaypointsView(reinterpret_cast<const float*>(points.data()),
+                        reinterpret_cast<const float*>(points.data()) + 1,
+                        points.size(),
+                        2) {
+        static_assert(sizeof(Point) == 2 * sizeof(float));
+    }
+
+    [[nodiscard]] auto size() const -> size_t { return size_; }
+    [[nodiscard]] auto empty() const -> bool { return size_ == 0; }
+
+    [[nodiscard]] auto operator[](size_t i) const -> Point {
+        return {.x = xs_[i * stride_], .y = ys_[i * stride_]};
+    }
+
+    [[nodiscard]] auto front() const -> Point { return (*this)[0]; }
+    [[nodiscard]] auto back() const -> Point { return (*this)[size_ - 1]; }
+
+    [[nodiscard]] auto begin() const -> Iterator {
+        return {.view = this, .i = 0};
+    }
+
+    [[nodiscard]] auto end() const -> Iterator {
+        return {.view = this, .i = size_};
+    }
+
+    /// @brief Copies the waypoints
+    [[nodiscard]] auto to_vector() const -> std::vector<Point> {
+        auto points = std::vector<Point>{};
+        points.reserve(size_);
+
+        for (size_t i = 0; i < size_; ++i) {
+            points.push_back((*this)[i]);
+        }
+
+        return points;
+    }
+
+   private:
+    const float* xs_ = nullptr;
+    const float* ys_ = nullptr;
+    size_t size_     = 0;
+    size_t stride_   = 1;
+};
+
+}  // namespace triskel
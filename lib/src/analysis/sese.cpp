@@ -62,7 +62,7 @@ auto SESE::new_class() -> size_t {
     return edge_class;
 }
 
-SESE::SESE(Graph& g)
+SESE::SESE(Graph& g, const CancellationToken* cancellation)
     : g_{g},
       his_{g, static_cast<size_t>(-1)},
       blists_{g, {}},
@@ -71,9 +71,8 @@ SESE::SESE(Graph& g)
       exit_edge_{g, false},
       recent_sizes_{g, 0},
       recent_classes_{g, 0},
-      node_regions{g, nullptr} {
-    auto& ge = g_.editor();
-    ge.push();
+      node_regions{g, Tree<SESERegionData>::InvalidID} {
+    auto frame = EditFrame{g_.editor()};
 
     // TODO: check that the graph is strongly connected.
     // This can be done with a depth first search
@@ -84,6 +83,10 @@ SESE::SESE(Graph& g)
     udfs_ = std::make_unique<UnorderedDFSAnalysis>(g);
 
     for (const auto& n : udfs_->nodes() | std::views::reverse) {
+        if (cancellation != nullptr) {
+            cancellation->throw_if_cancelled();
+        }
+
         const size_t hi0 = get_hi0(n);
         const size_t hi1 = get_hi1(n);
         his_.set(n, std::min(hi0, hi1));
@@ -130,17 +133,29 @@ SESE::SESE(Graph& g)
         }
     }
 
-    ge.pop();
+    frame.pop();
 
     // Construct the program structure tree
     auto visited       = NodeAttribute<bool>{g_, false};
     auto visited_stack = std::vector<NodeClass>{};
     determine_region_boundaries(g_.root(), visited, visited_stack);
 
-    visited           = NodeAttribute<bool>{g_, false};
-    auto& root_region = regions.make_node();
-    regions.root      = &root_region;
-    construct_program_structure_tree(g.root(), &root_region, visited);
+    visited            = NodeAttribute<bool>{g_, false};
+    const auto root_id = regions.make_node().id;
+    construct_program_structure_tree(g.root(), root_id, visited);
+
+    regions.compact();
+}
+
+void SESE::compact_regions() {
+    const auto new_ids = regions.compact();
+
+    for (const auto& node : g_.nodes()) {
+        const auto id = node_regions.get(node);
+        if (id != Tree<SESERegionData>::InvalidID) {
+            node_regions.set(node, new_ids[id]);
+        }
+    }
 }
 
 void SESE::preprocess_graph() {
@@ -315,36 +330,36 @@ void SESE::determine_region_boundaries(
 
 // NOLINTNEXTLINE(misc-no-recursion)
 void SESE::construct_program_structure_tree(const Node& node,
-                                            SESERegion* current_region,
+                                            size_t current_region,
                                             NodeAttribute<bool>& visited) {
     visited.set(node, true);
 
     node_regions.set(node, current_region);
-    (*current_region)->nodes.push_back(node);
-
-    auto& region = get_region(node);
+    regions.nodes[current_region]->nodes.push_back(node);
 
     for (const auto& edge : node.child_edges()) {
-        auto* curr = current_region;
+        auto curr  = current_region;
         auto child = edge.to();
 
         if (exit_edge_.get(edge)) {
+            auto& region      = regions.nodes[current_region];
             region->exit_edge = edge;
             region->exit_node = edge.from();
-            curr              = &region.parent();
+            curr              = region.parent().id;
         }
 
         if (entry_edge_.get(edge)) {
+            // Creating the region invalidates the references to the others
             auto& region = regions.make_node();
 
-            curr->add_child(&region);
+            regions.nodes[curr].add_child(&region);
             region->entry_edge = edge;
             region->entry_node = edge.to();
-            curr               = &region;
+            curr               = region.id;
         }
 
         if (!visited.get(child)) {
             construct_program_structure_tree(child, curr, visited);
         }
     }
-}
\ No newline at end of file
+}
@@ -0,0 +1,207 @@
+#include "triskel/triskel.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <exception>
+#include <filesystem>
+#include <fstream>
+#include <functional>
+#include <ios>
+#include <mutex>
+#include <optional>
+#include <stdexcept>
+#include <system_error>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include <unistd.h>
+
+#include <fmt/format.h>
+
+// NOLINTNEXTLINE(google-build-using-namespace)
+using namespace triskel;
+
+namespace fs = std::filesystem;
+
+namespace {
+constexpr auto EXTENSION = ".layout";
+
+/// @brief A name for a temporary file no other thread or process uses
+auto temporary_name(const fs::path& path) -> fs::path {
+    static auto counter = std::atomic<uint64_t>{0};
+
+    const auto thread =
+        std::hash<std::thread::id>{}(std::this_thread::get_id());
+    const auto now =
+        std::chrono::steady_clock::now().time_since_epoch().count();
+
+    auto name = path;
+    name += fmt::format(".{}.{:x}.{:x}.{}.tmp", ::getpid(), thread, now,
+                        counter.fetch_add(1, std::memory_order_relaxed));
+    return name;
+}
+
+/// @brief The stored layouts of `directory`
+auto stored_layouts(const fs::path& directory) -> std::vector<fs::path> {
+    auto paths = std::vector<fs::path>{};
+
+    auto ec = std::error_code{};
+    for (const auto& entry : fs::directory_iterator{directory, ec}) {
+        if (entry.path().extension() == EXTENSION) {
+            paths.push_back(entry.path());
+        }
+    }
+
+    return paths;
+}
+}  // namespace
+
+DiskCache::DiskCache(fs::path directory, size_t max_bytes)
+    : directory_{std::move(directory)}, max_bytes_{max_bytes} {
+    auto ec = std::error_code{};
+    fs::create_directories(directory_, ec);
+    if (ec || !fs::is_directory(directory_, ec)) {
+        throw std::invalid_argument("Cannot create the cache directory");
+    }
+
+    for (const auto& path : stored_layouts(directory_)) {
+        const auto size = fs::file_size(path, ec);
+        bytes_ += ec ? 0 : size;
+    }
+}
+
+auto DiskCache::path_of(const Key& key) const -> fs::path {
+    return directory_ / fmt::format("{:016x}{:016x}{}", key[0], key[1],
+                                    EXTENSION);
+}
+
+auto DiskCache::find(const Key& key, size_t node_count, size_t edge_count)
+    -> std::optional<FrozenLayout> {
+    const auto path = path_of(key);
+
+    auto layout = std::optional<FrozenLayout>{};
+    try {
+        layout = FrozenLayout::load(path);
+    } catch (const std::invalid_argument&) {
+        // Missing and truncated files are misses
+    }
+
+    // The offsets are checked once here rather than by every accessor
+    if (!layout.has_value() || layout->node_count() != node_count ||
+        layout->edge_count() != edge_count || !layout->is_valid()) {
+        misses_.fetch_add(1, std::memory_order_relaxed);
+        return std::nullopt;
+    }
+
+    layout->stats_.from_disk_cache = true;
+
+    // Marks the layout as recently used
+    auto ec = std::error_code{};
+    fs::last_write_time(path, fs::file_time_type::clock::now(), ec);
+
+    hits_.fetch_add(1, std::memory_order_relaxed);
+    return layout;
+}
+
+void DiskCache::insert(const Key& key, const FrozenLayout& layout) {
+    const auto path      = path_of(key);
+    const auto temporary = temporary_name(path);
+
+    auto size = size_t{0};
+    try {
+        auto out = std::ofstream{temporary, std::ios::binary | std::ios::trunc};
+        out.exceptions(std::ios::failbit | std::ios::badbit);
+        layout.save(out);
+        size = static_cast<size_t>(out.tellp());
+    } catch (const std::exception&) {
+        auto ec = std::error_code{};
+        fs::remove(temporary, ec);
+        return;
+    }
+
+    // The file replaced, if any, no longer counts
+    auto ec             = std::error_code{};
+    const auto replaced = fs::file_size(path, ec);
+    const auto previous = ec ? 0 : static_cast<size_t>(replaced);
+
+    // Readers see either the previous file or the whole new one
+    fs::rename(temporary, path, ec);
+    if (ec) {
+        fs::remove(temporary, ec);
+        return;
+    }
+
+    {
+        auto lock = std::lock_guard{mutex_};
+        bytes_ -= std::min(bytes_, previous);
+        bytes_ += size;
+        if (bytes_ <= max_bytes_) {
+            return;
+        }
+    }
+
+    evict();
+}
+
+void DiskCache::evict() {
+    struct Entry {
+        fs::path path;
+        fs::file_time_type time;
+        uint64_t size;
+    };
+
+    auto lock = std::lock_guard{mutex_};
+
+    auto entries = std::vector<Entry>{};
+    auto bytes   = uint64_t{0};
+    for (auto& path : stored_layouts(directory_)) {
+        auto ec         = std::error_code{};
+        const auto size = fs::file_size(path, ec);
+        const auto time = fs::last_write_time(path, ec);
+        if (ec) {
+            continue;
+        }
+
+        bytes += size;
+        entries.push_back(
+            {.path = std::move(path), .time = time, .size = size});
+    }
+
+    // Goes down to three quarters of the maximum so that the next insertions
+    // don't each scan the directory
+    const auto target = max_bytes_ - (max_bytes_ / 4);
+
+    std::ranges::sort(entries, {}, &Entry::time);
+    for (const auto& entry : entries) {
+        if (bytes <= target) {
+            break;
+        }
+
+        auto ec = std::error_code{};
+        if (fs::remove(entry.path, ec)) {
+            bytes -= entry.size;
+        }
+    }
+
+    bytes_ = bytes;
+}
+
+void DiskCache::clear() {
+    auto lock = std::lock_guard{mutex_};
+
+    for (const auto& path : stored_layouts(directory_)) {
+        auto ec = std::error_code{};
+        fs::remove(path, ec);
+    }
+
+    bytes_ = 0;
+}
+
+auto DiskCache::size() const -> size_t {
+    auto lock = std::lock_guard{mutex_};
+    return bytes_;
+}
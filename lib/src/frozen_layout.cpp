@@ -0,0 +1,509 @@
+#include "triskel/triskel.hpp"
+
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <memory>
+#include <ostream>
+#include <span>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "triskel/utils/point.hpp"
+#include "triskel/utils/waypoints.hpp"
+
+// NOLINTNEXTLINE(google-build-using-namespace)
+using namespace triskel;
+
+namespace fs = std::filesystem;
+
+namespace {
+constexpr auto MAGIC =
+    std::array<char, 8>{'T', 'R', 'I', 'S', 'K', 'E', 'L', 'L'};
+
+/// @brief Set in `Header::flags` when the labels follow the edge types
+constexpr auto HAS_LABELS = uint32_t{1};
+
+/// @brief The start of a saved layout. Every number is little endian
+struct Header {
+    std::array<char, 8> magic;
+    uint32_t version;
+    uint32_t flags;
+
+    uint64_t node_count;
+    uint64_t edge_count;
+    uint64_t waypoint_count;
+
+    /// @brief The size of the labels, 0 without labels
+    uint64_t label_bytes;
+
+    float width;
+    float height;
+
+    uint64_t dummy_count;
+    uint64_t phantom_count;
+    uint64_t concentrated_edges;
+};
+
+static_assert(std::is_trivially_copyable_v<Header>);
+static_assert(sizeof(Header) % alignof(uint64_t) == 0);
+static_assert(sizeof(Rect) == 4 * sizeof(float));
+static_assert(sizeof(Point) == 2 * sizeof(float));
+static_assert(sizeof(LayoutBuilder::EdgeType) == 1);
+
+/// @brief The files are only read and written on little endian hosts, which
+/// use them as they are
+constexpr auto IS_LITTLE_ENDIAN = std::endian::native == std::endian::little;
+
+/// @brief Whether the offsets can be used from the file as they are
+constexpr auto HAS_64_BIT_SIZES = sizeof(size_t) == sizeof(uint64_t);
+
+/// @brief The position of each array in a saved layout. Each array starts
+/// on 8 bytes
+struct Sections {
+    size_t rects;
+    size_t waypoint_offsets;
+    size_t waypoints;
+    size_t edge_types;
+    size_t label_offsets;
+    size_t labels;
+    size_t end;
+};
+
+auto align(size_t offset) -> size_t {
+    return (offset + alignof(uint64_t) - 1) & ~(alignof(uint64_t) - 1);
+}
+
+auto sections_of(const Header& header) -> Sections {
+    auto sections = Sections{};
+    auto offset   = sizeof(Header);
+
+    sections.rects = offset;
+    offset += header.node_count * sizeof(Rect);
+
+    sections.waypoint_offsets = offset;
+    offset += (header.edge_count + 1) * sizeof(uint64_t);
+
+    sections.waypoints = offset;
+    offset += header.waypoint_count * sizeof(Point);
+
+    sections.edge_types = offset;
+    offset = align(offset + header.edge_count);
+
+    sections.label_offsets = offset;
+    if ((header.flags & HAS_LABELS) != 0) {
+        offset += (header.node_count + 1) * sizeof(uint64_t);
+    }
+
+    sections.labels = offset;
+    offset += header.label_bytes;
+
+    sections.end = offset;
+    return sections;
+}
+
+/// @brief A file mapped in memory, read only
+struct MappedFile {
+    explicit MappedFile(const fs::path& path) {
+        const auto fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+        if (fd < 0) {
+            throw std::invalid_argument("Cannot open the layout file");
+        }
+
+        struct stat st {};
+        if (::fstat(fd, &st) == 0 && st.st_size > 0) {
+            auto* data = ::mmap(nullptr, static_cast<size_t>(st.st_size),
+                                PROT_READ, MAP_PRIVATE, fd, 0);
+            if (data != MAP_FAILED) {
+                data_ = static_cast<const std::byte*>(data);
+                size_ = static_cast<size_t>(st.st_size);
+            }
+        }
+
+        // The mapping stays valid once the file is closed
+        ::close(fd);
+    }
+
+    ~MappedFile() {
+        if (data_ != nullptr) {
+            ::munmap(const_cast<std::byte*>(data_), size_);
+        }
+    }
+
+    MappedFile(const MappedFile&)                    = delete;
+    MappedFile(MappedFile&&)                         = delete;
+    auto operator=(const MappedFile&) -> MappedFile& = delete;
+    auto operator=(MappedFile&&) -> MappedFile&      = delete;
+
+    [[nodiscard]] auto bytes() const -> std::span<const std::byte> {
+        return {data_, size_};
+    }
+
+   private:
+    const std::byte* data_ = nullptr;
+    size_t size_           = 0;
+};
+
+/// @brief A loaded layout: the mapped file, and its offsets if they have to
+/// be converted to `size_t`
+struct Mapping {
+    explicit Mapping(const fs::path& path) : file{path} {}
+
+    MappedFile file;
+
+    std::vector<size_t> waypoint_offsets;
+    std::vector<size_t> label_offsets;
+};
+
+/// @brief The `count` values of `T` at `offset` in the file
+template <typename T>
+auto view(std::span<const std::byte> bytes, size_t offset, size_t count)
+    -> std::span<const T> {
+    return {reinterpret_cast<const T*>(bytes.data() + offset), count};
+}
+
+/// @brief The `count` offsets at `offset` in the file, converted into `out`
+/// if needed
+auto view_offsets(std::span<const std::byte> bytes,
+                  size_t offset,
+                  size_t count,
+                  std::vector<size_t>& out) -> std::span<const size_t> {
+    if constexpr (HAS_64_BIT_SIZES) {
+        return view<size_t>(bytes, offset, count);
+    }
+
+    const auto offsets = view<uint64_t>(bytes, offset, count);
+    out.assign(offsets.begin(), offsets.end());
+    return out;
+}
+
+/// @brief Whether `offsets` splits an array of `size` elements in order
+auto are_offsets_valid(std::span<const size_t> offsets, size_t size) -> bool {
+    return !offsets.empty() && offsets.front() == 0 &&
+           offsets.back() == size && std::ranges::is_sorted(offsets);
+}
+
+/// @brief The range of `offsets[i]` to `offsets[i + 1]` if it fits in `size`
+auto checked_range(std::span<const size_t> offsets, size_t i, size_t size)
+    -> std::pair<size_t, size_t> {
+    const auto begin = offsets[i];
+    const auto end   = offsets[i + 1];
+    if (begin > end || end > size) {
+        throw std::invalid_argument("Invalid offsets in the layout");
+    }
+
+    return {begin, end - begin};
+}
+
+template <typename T>
+void write(std::ostream& out, std::span<const T> values) {
+    out.write(reinterpret_cast<const char*>(values.data()),
+              static_cast<std::streamsize>(values.size_bytes()));
+}
+
+/// @brief Writes offsets as 64 bits numbers
+void write_offsets(std::ostream& out, std::span<const size_t> offsets) {
+    if constexpr (HAS_64_BIT_SIZES) {
+        write(out, offsets);
+        return;
+    }
+
+    for (auto offset : offsets) {
+        const auto value = static_cast<uint64_t>(offset);
+        out.write(reinterpret_cast<const char*>(&value), sizeof(value));
+    }
+}
+}  // namespace
+
+FrozenLayout::FrozenLayout(Data data) {
+    // Layouts without edges or labels may leave the offsets empty
+    if (data.waypoint_offsets.empty() && data.edge_types.empty()) {
+        data.waypoint_offsets.push_back(0);
+    }
+
+    if (data.label_offsets.empty() && data.labels.empty()) {
+        data.label_offsets.resize(data.rects.size() + 1, 0);
+    }
+
+    if (data.waypoint_offsets.size() != data.edge_types.size() + 1 ||
+        !are_offsets_valid(data.waypoint_offsets, data.waypoints.size())) {
+        throw std::invalid_argument("Invalid waypoint offsets");
+    }
+
+    if (data.label_offsets.size() != data.rects.size() + 1 ||
+        !are_offsets_valid(data.label_offsets, data.labels.size())) {
+        throw std::invalid_argument("Invalid label offsets");
+    }
+
+    auto owned = std::make_shared<const Data>(std::move(data));
+
+    rects_            = owned->rects;
+    waypoint_offsets_ = owned->waypoint_offsets;
+    waypoints_        = owned->waypoints;
+    edge_types_       = owned->edge_types;
+    label_offsets_    = owned->label_offsets;
+    labels_           = owned->labels;
+    width_            = owned->width;
+    height_           = owned->height;
+    stats_            = owned->stats;
+
+    owner_ = std::move(owned);
+}
+
+auto FrozenLayout::load(const fs::path& path) -> FrozenLayout {
+    if constexpr (!IS_LITTLE_ENDIAN) {
+        throw std::invalid_argument("Layout files need a little endian host");
+    }
+
+    auto mapping     = std::make_shared<Mapping>(path);
+    const auto bytes = mapping->file.bytes();
+
+    auto header = Header{};
+    if (bytes.size() < sizeof(Header)) {
+        throw std::invalid_argument("Not a layout file");
+    }
+    std::memcpy(&header, bytes.data(), sizeof(Header));
+
+    if (header.magic != MAGIC) {
+        throw std::invalid_argument("Not a layout file");
+    }
+
+    if (header.version != FORMAT_VERSION) {
+        throw std::invalid_argument("Unsupported layout file version");
+    }
+
+    // Bounds the counts so that the sizes of the arrays can't overflow
+    const auto is_bounded = [&](uint64_t count) {
+        return count <= bytes.size();
+    };
+    if (!is_bounded(header.node_count) || !is_bounded(header.edge_count) ||
+        !is_bounded(header.waypoint_count) ||
+        !is_bounded(header.label_bytes)) {
+        throw std::invalid_argument("Truncated layout file");
+    }
+
+    const auto sections = sections_of(header);
+    if (sections.end != bytes.size()) {
+        throw std::invalid_argument("Truncated layout file");
+    }
+
+    auto layout = FrozenLayout{};
+
+    layout.rects_ = view<Rect>(bytes, sections.rects, header.node_count);
+    layout.waypoint_offsets_ =
+        view_offsets(bytes, sections.waypoint_offsets, header.edge_count + 1,
+                     mapping->waypoint_offsets);
+    layout.waypoints_ =
+        view<Point>(bytes, sections.waypoints, header.waypoint_count);
+    layout.edge_types_ = view<LayoutBuilder::EdgeType>(
+        bytes, sections.edge_types, header.edge_count);
+
+    if ((header.flags & HAS_LABELS) != 0) {
+        layout.label_offsets_ =
+            view_offsets(bytes, sections.label_offsets, header.node_count + 1,
+                         mapping->label_offsets);
+
+        const auto labels = view<char>(bytes, sections.labels,
+                                       header.label_bytes);
+        layout.labels_    = {labels.data(), labels.size()};
+    }
+
+    layout.width_                    = header.width;
+    layout.height_                   = header.height;
+    layout.stats_.dummy_count        = header.dummy_count;
+    layout.stats_.phantom_count      = header.phantom_count;
+    layout.stats_.concentrated_edges = header.concentrated_edges;
+
+    layout.owner_ = std::move(mapping);
+    return layout;
+}
+
+void FrozenLayout::save(std::ostream& out, bool labels) const {
+    if constexpr (!IS_LITTLE_ENDIAN) {
+        throw std::invalid_argument("Layout files need a little endian host");
+    }
+
+    labels = labels && !label_offsets_.empty();
+
+    const auto header = Header{
+        .magic              = MAGIC,
+        .version            = FORMAT_VERSION,
+        .flags              = labels ? HAS_LABELS : 0,
+        .node_count         = rects_.size(),
+        .edge_count         = edge_types_.size(),
+        .waypoint_count     = waypoints_.size(),
+        .label_bytes        = labels ? labels_.size() : 0,
+        .width              = width_,
+        .height             = height_,
+        .dummy_count        = stats_.dummy_count,
+        .phantom_count      = stats_.phantom_count,
+        .concentrated_edges = stats_.concentrated_edges,
+    };
+
+    const auto sections = sections_of(header);
+    const auto padding  = std::array<char, alignof(uint64_t)>{};
+
+    out.write(reinterpret_cast<const char*>(&header), sizeof(Header));
+    write(out, rects_);
+    write_offsets(out, waypoint_offsets_);
+    write(out, waypoints_);
+    write(out, edge_types_);
+    out.write(padding.data(),
+              static_cast<std::streamsize>(
+                  sections.label_offsets -
+                  (sections.edge_types + edge_types_.size())));
+
+    if (labels) {
+        write_offsets(out, label_offsets_);
+        out.write(labels_.data(), static_cast<std::streamsize>(labels_.size()));
+    }
+}
+
+void FrozenLayout::save(const fs::path& path, bool labels) const {
+    auto out = std::ofstream{path, std::ios::binary | std::ios::trunc};
+    if (!out) {
+        throw std::invalid_argument("Cannot open the layout file");
+    }
+
+    save(out, labels);
+
+    out.flush();
+    if (!out) {
+        throw std::runtime_error("Cannot write the layout file");
+    }
+}
+
+auto FrozenLayout::get_coords(size_t node) const -> Point {
+    const auto rect = get_rect(node);
+    return {.x = rect.x, .y = rect.y};
+}
+
+auto FrozenLayout::get_rect(size_t node) const -> Rect {
+    if (node >= node_count()) {
+        throw std::invalid_argument("ID does not belong to the graph");
+    }
+
+    return rects_[node];
+}
+
+auto FrozenLayout::get_waypoints(size_t edge) const -> WaypointsView {
+    if (edge >= edge_count()) {
+        throw std::invalid_argument("ID does not belong to the graph");
+    }
+
+    const auto [begin, size] =
+        checked_range(waypoint_offsets_, edge, waypoints_.size());
+    return waypoints_.subspan(begin, size);
+}
+
+auto FrozenLayout::get_edge_type(size_t edge) const
+    -> LayoutBuilder::EdgeType {
+    if (edge >= edge_count()) {
+        throw std::invalid_argument("ID does not belong to the graph");
+    }
+
+    return edge_types_[edge];
+}
+
+auto FrozenLayout::get_label(size_t node) const -> std::string_view {
+    if (node >= node_count()) {
+        throw std::invalid_argument("ID does not belong to the graph");
+    }
+
+    if (label_offsets_.empty()) {
+        return {};
+    }
+
+    const auto [begin, size] = checked_range(label_offsets_, node,
+                                             labels_.size());
+    return labels_.substr(begin, size);
+}
+
+auto FrozenLayout::footprint() const -> size_t {
+    return sizeof(FrozenLayout) + rects_.size_bytes() +
+           waypoint_offsets_.size_bytes() + waypoints_.size_bytes() +
+           edge_types_.size_bytes() + label_offsets_.size_bytes() +
+           labels_.size();
+}
+
+auto FrozenLayout::is_valid() const -> bool {
+    return waypoint_offsets_.size() == edge_types_.size() + 1 &&
+           are_offsets_valid(waypoint_offsets_, waypoints_.size()) &&
+           (label_offsets_.empty() ||
+            (label_offsets_.size() == rects_.size() + 1 &&
+             are_offsets_valid(label_offsets_, labels_.size())));
+}
+
+void FrozenLayout::render(Renderer& renderer) const {
+    renderer.begin(get_width(), get_height());
+
+    // Draws the nodes
+    for (size_t node = 0; node < node_count(); ++node) {
+        const auto& rect = rects_[node];
+        const auto tl    = Point{.x = rect.x, .y = rect.y};
+
+        renderer.draw_rectangle_border(tl, rect.width, rect.height,
+                                       renderer.STYLE_BASICBLOCK_BORDER);
+
+        renderer.draw_text(tl, std::string{get_label(node)},
+                           renderer.STYLE_TEXT);
+    }
+
+    // Draws the edges
+    for (size_t edge = 0; edge < edge_count(); ++edge) {
+        const auto waypoints = get_waypoints(edge);
+        if (waypoints.empty()) {
+            continue;
+        }
+
+        // Gets the style for this edge
+        auto style = renderer.STYLE_EDGE;
+
+        auto t = edge_types_[edge];
+        if (t == LayoutBuilder::EdgeType::True) {
+            style = renderer.STYLE_EDGE_T;
+        } else if (t == LayoutBuilder::EdgeType::False) {
+            style = renderer.STYLE_EDGE_F;
+        }
+
+        auto last = waypoints.front();
+
+        for (size_t i = 1; i < waypoints.size(); ++i) {
+            auto waypoint = waypoints[i];
+
+            renderer.draw_line(last, waypoint, style);
+
+            last = waypoint;
+        }
+
+        renderer.draw_triangle(
+            last,
+            last + Point{.x = -renderer.TRIANGLE_SIZE / 2,
+                         .y = -renderer.TRIANGLE_SIZE},
+            last + Point{.x = +renderer.TRIANGLE_SIZE / 2,
+                         .y = -renderer.TRIANGLE_SIZE},
+            style.color);
+    }
+
+    renderer.end();
+}
+
+void FrozenLayout::render_and_save(ExportingRenderer& renderer,
+                                   const std::filesystem::path& path) const {
+    render(renderer);
+    renderer.save(path);
+}
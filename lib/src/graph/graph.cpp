@@ -3,6 +3,7 @@
 #include <cassert>
 #include <cstddef>
 #include <ranges>
+#include <span>
 #include <stack>
 #include <vector>
 
@@ -57,7 +58,7 @@ auto GraphEditor::make_edge(NodeId from, NodeId to) -> Edge {
     g_.get_node_data(from).edges.push_back(e.id);
     g_.get_node_data(to).edges.push_back(e.id);
 
-    frame().created_edges.push(e.id);
+    frame().created_edges_count += 1;
     return g_.get_edge(e.id);
 }
 
@@ -156,23 +157,15 @@ void GraphEditor::pop() {
     }
 
     // Revert created edges
-    auto created_edge_count = 0;
-    while (!f.created_edges.empty()) {
-        auto eid = f.created_edges.top();
-        f.created_edges.pop();
-
-        auto& e = g_.get_edge_data(eid);
+    for (size_t i = 0; i < f.created_edges_count; ++i) {
+        const auto& e = g_.data_.edges.back();
 
         auto& from = g_.get_node_data(e.from);
         auto& to   = g_.get_node_data(e.to);
 
-        std::erase(from.edges, eid);
-        std::erase(to.edges, eid);
-
-        created_edge_count++;
-    }
+        std::erase(from.edges, e.id);
+        std::erase(to.edges, e.id);
 
-    for (size_t i = 0; i < created_edge_count; ++i) {
         g_.data_.edges.pop_back();
     }
 
@@ -184,6 +177,84 @@ void GraphEditor::pop() {
     frames.pop();
 }
 
+auto GraphEditor::make_nodes(size_t count) -> NodeId {
+    const auto first = g_.data_.nodes.size();
+
+    for (size_t i = 0; i < count; ++i) {
+        g_.data_.nodes.push_back(NodeData{.id      = NodeId{first + i},
+                                          .edges   = {},
+                                          .deleted = false});
+    }
+
+    if (count > 0 && g_.data_.root == NodeId::InvalidID) {
+        g_.data_.root = NodeId{first};
+    }
+
+    frame().created_nodes_count += count;
+    return NodeId{first};
+}
+
+template <typename ForEachEdge>
+auto GraphEditor::append_edges(size_t count, const ForEachEdge& for_each_edge)
+    -> EdgeId {
+    auto& f          = frame();
+    const auto first = g_.data_.edges.size();
+
+    // Sizes the adjacency lists once instead of growing them edge by edge
+    auto degrees = std::vector<size_t>(g_.data_.nodes.size(), 0);
+    for_each_edge([&](size_t from, size_t to) {
+        degrees[from] += 1;
+        degrees[to] += 1;
+    });
+
+    for (auto& node : g_.data_.nodes) {
+        const auto degree = degrees[static_cast<size_t>(node.id)];
+        if (degree > 0) {
+            node.edges.reserve(node.edges.size() + degree);
+        }
+    }
+
+    for_each_edge([&](size_t from, size_t to) {
+        const auto id = EdgeId{g_.data_.edges.size()};
+
+        g_.data_.edges.push_back(EdgeData{.id      = id,
+                                          .from    = NodeId{from},
+                                          .to      = NodeId{to},
+                                          .deleted = false});
+
+        g_.data_.nodes[from].edges.push_back(id);
+        g_.data_.nodes[to].edges.push_back(id);
+    });
+
+    // The frame only records how many edges to pop
+    f.created_edges_count += count;
+    return EdgeId{first};
+}
+
+auto GraphEditor::make_edges(std::span<const size_t> from,
+                             std::span<const size_t> to) -> EdgeId {
+    assert(from.size() == to.size());
+
+    return append_edges(from.size(), [&](const auto& add) {
+        for (size_t i = 0; i < from.size(); ++i) {
+            add(from[i], to[i]);
+        }
+    });
+}
+
+auto GraphEditor::make_csr_edges(std::span<const size_t> offsets,
+                                 std::span<const size_t> targets) -> EdgeId {
+    assert(offsets.empty() || offsets.back() == targets.size());
+
+    return append_edges(targets.size(), [&](const auto& add) {
+        for (size_t node = 0; node + 1 < offsets.size(); ++node) {
+            for (size_t i = offsets[node]; i < offsets[node + 1]; ++i) {
+                add(node, targets[i]);
+            }
+        }
+    });
+}
+
 void GraphEditor::commit() {
     // Deletes all changes
     frames = std::stack<Frame>();
@@ -0,0 +1,128 @@
+#include "triskel/layout/context.hpp"
+
+#include <cstddef>
+#include <memory_resource>
+#include <stdexcept>
+
+// NOLINTNEXTLINE(google-build-using-namespace)
+using namespace triskel;
+
+namespace {
+/// @brief The scratch resource of the thread, `nullptr` for the heap
+thread_local std::pmr::memory_resource* current_scratch = nullptr;
+}  // namespace
+
+// =============================================================================
+// CountingResource
+// =============================================================================
+CountingResource::CountingResource(std::pmr::memory_resource* upstream)
+    : upstream_{upstream} {}
+
+auto CountingResource::do_allocate(size_t bytes, size_t alignment) -> void* {
+    auto* p = upstream_->allocate(bytes, alignment);
+
+    allocations_.fetch_add(1, std::memory_order_relaxed);
+    bytes_.fetch_add(bytes, std::memory_order_relaxed);
+    return p;
+}
+
+void CountingResource::do_deallocate(void* p, size_t bytes, size_t alignment) {
+    upstream_->deallocate(p, bytes, alignment);
+}
+
+auto CountingResource::do_is_equal(
+    const std::pmr::memory_resource& other) const noexcept -> bool {
+    return this == &other;
+}
+
+// =============================================================================
+// LayoutContext
+// =============================================================================
+LayoutContext::LayoutContext() : LayoutContext(0) {}
+
+LayoutContext::LayoutContext(size_t capacity) : capacity_{capacity} {
+    if (capacity_ > 0) {
+        buffer_ = static_cast<std::byte*>(
+            heap_.allocate(capacity_, alignof(std::max_align_t)));
+    }
+}
+
+LayoutContext::~LayoutContext() {
+    pool_.reset();
+    arena_.reset();
+
+    if (buffer_ != nullptr) {
+        heap_.deallocate(buffer_, capacity_, alignof(std::max_align_t));
+    }
+}
+
+auto LayoutContext::begin() -> std::pmr::memory_resource* {
+    if (in_use_) {
+        throw std::invalid_argument("The layout context is already in use");
+    }
+
+    in_use_     = true;
+    heap_bytes_ = heap_.bytes();
+
+    if (buffer_ != nullptr) {
+        arena_.emplace(buffer_, capacity_, &heap_);
+    } else {
+        arena_.emplace(&heap_);
+    }
+    pool_.emplace(&*arena_);
+
+    return &*pool_;
+}
+
+void LayoutContext::end() {
+    pool_.reset();
+    arena_.reset();
+    in_use_ = false;
+
+    // The arena outgrew the kept memory, the next layouts get all the memory
+    // this one used from the start
+    const auto overflow = heap_.bytes() - heap_bytes_;
+    if (overflow == 0) {
+        return;
+    }
+
+    const auto capacity = capacity_ + overflow;
+    release();
+
+    buffer_ = static_cast<std::byte*>(
+        heap_.allocate(capacity, alignof(std::max_align_t)));
+    capacity_ = capacity;
+}
+
+void LayoutContext::release() {
+    if (in_use_) {
+        throw std::invalid_argument("The layout context is in use");
+    }
+
+    if (buffer_ != nullptr) {
+        heap_.deallocate(buffer_, capacity_, alignof(std::max_align_t));
+    }
+
+    buffer_   = nullptr;
+    capacity_ = 0;
+}
+
+// =============================================================================
+// Scratch
+// =============================================================================
+auto triskel::scratch_resource() -> std::pmr::memory_resource* {
+    if (current_scratch == nullptr) {
+        return std::pmr::new_delete_resource();
+    }
+
+    return current_scratch;
+}
+
+ScratchScope::ScratchScope(std::pmr::memory_resource* resource)
+    : previous_{current_scratch} {
+    current_scratch = resource;
+}
+
+ScratchScope::~ScratchScope() {
+    current_scratch = previous_;
+}
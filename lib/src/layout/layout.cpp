@@ -1,120 +1,357 @@
 #include "triskel/layout/layout.hpp"
 
 #include <algorithm>
+#include <atomic>
+#include <bit>
+#include <chrono>
 #include <cassert>
+#include <cmath>
 #include <cstddef>
-#include <deque>
+#include <cstdint>
+#include <map>
 #include <memory>
+#include <memory_resource>
+#include <mutex>
+#include <optional>
+#include <thread>
+#include <utility>
 #include <vector>
 
 #include "triskel/analysis/sese.hpp"
 #include "triskel/graph/graph.hpp"
 #include "triskel/graph/igraph.hpp"
 #include "triskel/graph/subgraph.hpp"
+#include "triskel/layout/context.hpp"
+#include "triskel/layout/layout_cache.hpp"
 #include "triskel/layout/phantom_nodes.hpp"
 #include "triskel/layout/sugiyama/sugiyama.hpp"
 #include "triskel/utils/attribute.hpp"
 #include "triskel/utils/constants.hpp"
+#include "triskel/utils/executor.hpp"
 #include "triskel/utils/point.hpp"
 
 // NOLINTNEXTLINE(google-build-using-namespace)
 using namespace triskel;
 
+// =============================================================================
+// Scratch
+// =============================================================================
+struct Layout::Scratch {
+    Scratch(Layout& layout, LayoutContext* context)
+        : layout{layout},
+          context{context},
+          context_heap_allocations{
+              context != nullptr ? context->heap_allocations() : 0},
+          local{context != nullptr ? context->begin()
+                                   : std::pmr::new_delete_resource()},
+          scope{&local} {
+        layout.scratch_ = this;
+    }
+
+    ~Scratch() {
+        layout.scratch_ = nullptr;
+
+        auto& stats = layout.stats_;
+        stats.scratch_allocations =
+            local.allocations() + shared.allocations();
+        stats.scratch_heap_allocations = shared.allocations();
+
+        if (context == nullptr) {
+            stats.scratch_heap_allocations += local.allocations();
+            return;
+        }
+
+        // Frees the buffers
+        context->end();
+        stats.scratch_heap_allocations +=
+            context->heap_allocations() - context_heap_allocations;
+    }
+
+    Scratch(const Scratch&)                    = delete;
+    Scratch(Scratch&&)                         = delete;
+    auto operator=(const Scratch&) -> Scratch& = delete;
+    auto operator=(Scratch&&) -> Scratch&      = delete;
+
+    /// @brief The resource of the thread running a task. The context can only
+    /// be used by the thread building the layout
+    [[nodiscard]] auto resource() -> std::pmr::memory_resource* {
+        if (std::this_thread::get_id() == thread) {
+            return &local;
+        }
+
+        return &shared;
+    }
+
+    Layout& layout;
+    LayoutContext* context;
+
+    /// @brief The blocks the context took from the heap before the layout
+    size_t context_heap_allocations;
+
+    /// @brief The buffers of the thread building the layout
+    CountingResource local;
+
+    /// @brief The buffers of the other threads
+    CountingResource shared;
+
+    std::thread::id thread = std::this_thread::get_id();
+
+    ScratchScope scope;
+};
+
 Layout::Layout(Graph& g)
     : Layout(g, NodeAttribute<float>{g, 1.0F}, NodeAttribute<float>{g, 1.0F}) {}
 
 Layout::Layout(Graph& g,
                const NodeAttribute<float>& heights,
-               const NodeAttribute<float>& widths)
+               const NodeAttribute<float>& widths,
+               const LayoutOptions& options,
+               const WarmStart& warm_start,
+               LayoutContext* context)
     : g_{g},
       xs_(g, 0.0F),
       ys_(g, 0),
-      waypoints_(g, {}),
       start_x_offset_(g, -1),
       end_x_offset_(g, -1),
       heights_(heights),
-      widths_(widths)
+      widths_(widths),
+      previous_(warm_start.regions),
+      options_(options)
 
 {
-    // g.editor().push();
+    start_budget();
+
+    options_.cancellation.throw_if_cancelled();
 
-    // Add fake nodes to help sese
-    // create_phantom_nodes(g);
+    auto scratch = Scratch{*this, context};
+
+    if (warm_start.xs != nullptr) {
+        seed_xs_ = *warm_start.xs;
+    }
 
-    sese_ = std::make_unique<SESE>(g);
-    // g.editor().pop();
+    auto frame = EditFrame{g.editor()};
+
+    concentrate_edges();
+
+    report(LayoutPhase::Regions, 0.0F);
+    sese_ = std::make_unique<SESE>(g, &options_.cancellation);
 
     remove_small_regions();
+    report(LayoutPhase::Regions, 1.0F);
+
+    results_.resize(sese_->regions.nodes.size());
+
+    layout_regions(frame);
+
+    previous_ = nullptr;
+    seed_xs_.reset();
+
+    // The updates can't be cancelled or followed
+    options_.cancellation = {};
+    options_.progress     = nullptr;
+}
+
+void Layout::update_node_size(NodeId node, float width, float height) {
+    widths_.set(node, width);
+    heights_.set(node, height);
+
+    // The regions around the node change size, the others are unchanged
+    auto* r = &sese_->get_region(g_.get_node(node));
+    while (true) {
+        results_[r->id].dirty = true;
+        if (r->is_root()) {
+            break;
+        }
+
+        r = &r->parent();
+    }
+
+    relayout();
+}
+
+void Layout::update_node_sizes(const NodeAttribute<float>& heights,
+                               const NodeAttribute<float>& widths) {
+    heights_ = heights;
+    widths_  = widths;
+
+    for (auto& result : results_) {
+        result.dirty = true;
+    }
+
+    relayout();
+}
+
+void Layout::start_budget() {
+    deadline_ = options_.deadline;
+    if (options_.budget.count() > 0) {
+        deadline_ = std::min(deadline_,
+                             LayoutOptions::Clock::now() + options_.budget);
+    }
+}
+
+void Layout::relayout() {
+    start_budget();
+
+    xs_             = NodeAttribute<float>{g_, 0.0F};
+    ys_             = NodeAttribute<float>{g_, 0.0F};
+    start_x_offset_ = EdgeAttribute<float>{g_, -1.0F};
+    end_x_offset_   = EdgeAttribute<float>{g_, -1.0F};
+    waypoints_      = WaypointBuffer{};
+    stats_          = LayoutStats{};
+    regions_data_.clear();
+
+    auto scratch = Scratch{*this, nullptr};
+
+    // The phantom nodes get the same ids, the regions still apply
+    auto frame = EditFrame{g_.editor()};
+    concentrate_edges();
+
+    layout_regions(frame);
+}
 
-    g.editor().push();
+auto Layout::saved_regions() const -> std::unique_ptr<LayoutCache> {
+    auto cache = std::make_unique<LayoutCache>(results_.size());
+    for (const auto& result : results_) {
+        // The truncated regions are laid out again
+        if (result.dirty) {
+            continue;
+        }
+
+        cache->insert(result.key, result.layout);
+    }
+
+    return cache;
+}
+
+void Layout::layout_regions(EditFrame& concentrated) {
+    auto frame = EditFrame{g_.editor()};
     init_regions();
 
-    compute_layout(*sese_->regions.root);
-    translate_region(*sese_->regions.root);
+    laid_out_regions_ = 0;
+    report(LayoutPhase::Nodes, 0.0F);
+
+    if (options_.threads > 1) {
+        compute_layout_parallel();
+    } else {
+        compute_layout(sese_->regions.root());
+    }
+    resolve_coordinates();
 
-    g.editor().pop();
+    frame.pop();
+
+    options_.cancellation.throw_if_cancelled();
+    report(LayoutPhase::Edges, 0.0F);
 
     // Tie loose ends
+    auto waypoints = std::vector<Point>{};
     for (const auto& region : sese_->regions.nodes) {
-        auto& data = regions_data_[region->id];
+        auto& data = regions_data_[region.id];
 
         // Add the exit waypoints
         for (auto exit_pair : data.exits) {
-            auto& exit_waypoints = data.io_waypoints[exit_pair];
+            const auto& exit_waypoints = data.io_waypoints[exit_pair];
             assert(!exit_waypoints.empty());
-            auto& waypoints = waypoints_.get(exit_pair.edge);
+            const auto edge_waypoints = waypoints_.get(exit_pair.edge);
 
-            // Remove the nodes connecting it to the next layer
-            waypoints.erase(waypoints.begin());
-            waypoints.front().x = exit_waypoints.back().x;
-            exit_waypoints.pop_back();
+            // Replaces the first waypoint, connecting it to the next layer
+            waypoints.assign(exit_waypoints.begin(), exit_waypoints.end());
+            waypoints.back().y = edge_waypoints[1].y;
+            for (size_t i = 2; i < edge_waypoints.size(); ++i) {
+                waypoints.push_back(edge_waypoints[i]);
+            }
 
-            waypoints.insert(waypoints.begin(), exit_waypoints.begin(),
-                             exit_waypoints.end());
+            waypoints_.assign(exit_pair.edge, waypoints);
         }
 
         for (auto entry_pair : data.entries) {
-            auto& entry_waypoints = data.io_waypoints[entry_pair];
+            const auto& entry_waypoints = data.io_waypoints[entry_pair];
             assert(!entry_waypoints.empty());
-            auto& waypoints = waypoints_.get(entry_pair.edge);
+            const auto edge_waypoints = waypoints_.get(entry_pair.edge);
 
-            // Remove the nodes connecting it to the next layer
-            waypoints.pop_back();
-            waypoints.back().x = entry_waypoints.front().x;
-            entry_waypoints.erase(entry_waypoints.begin());
-
-            waypoints.insert(waypoints.end(), entry_waypoints.begin(),
+            // Replaces the last waypoint, connecting it to the next layer
+            waypoints.clear();
+            for (size_t i = 0; i + 2 < edge_waypoints.size(); ++i) {
+                waypoints.push_back(edge_waypoints[i]);
+            }
+            waypoints.push_back(
+                {.x = entry_waypoints.front().x,
+                 .y = edge_waypoints[edge_waypoints.size() - 2].y});
+            waypoints.insert(waypoints.end(), entry_waypoints.begin() + 1,
                              entry_waypoints.end());
+
+            waypoints_.assign(entry_pair.edge, waypoints);
         }
     }
+
+    draw_concentrated_edges();
+
+    concentrated.pop();
+
+    waypoints_.pack(g_);
+    report(LayoutPhase::Edges, 1.0F);
+}
+
+void Layout::concentrate_edges() {
+    if (options_.concentration_threshold == 0) {
+        return;
+    }
+
+    concentration_ =
+        create_phantom_nodes(g_, options_.concentration_threshold);
+
+    for (auto phantom : concentration_.phantoms) {
+        heights_.set(phantom, WAYPOINT_HEIGHT);
+        widths_.set(phantom, WAYPOINT_WIDTH);
+    }
+
+    stats_.phantom_count      = concentration_.phantoms.size();
+    stats_.concentrated_edges = concentration_.paths.size();
+}
+
+void Layout::draw_concentrated_edges() {
+    auto waypoints = std::vector<Point>{};
+
+    for (const auto& path : concentration_.paths) {
+        waypoints.clear();
+
+        for (auto edge : path.edges) {
+            const auto edge_waypoints = waypoints_.get(edge);
+
+            for (const auto& waypoint : edge_waypoints) {
+                // The edges meet on the phantom node
+                if (!waypoints.empty() && waypoint == waypoints.back()) {
+                    continue;
+                }
+
+                waypoints.push_back(waypoint);
+            }
+        }
+
+        waypoints_.assign(path.edge, waypoints);
+    }
 }
 
 void Layout::remove_small_regions() {
     // Remove SESE regions with a single node
-    std::deque<SESE::SESERegion*> small_regions;
+    std::vector<SESE::SESERegion*> small_regions;
     for (auto& region : sese_->regions.nodes) {
-        if ((*region)->nodes.size() == 1 && region->children().empty() &&
-            !region->is_root()) {
-            small_regions.push_back(region.get());
+        if (region->nodes.size() == 1 && region.children().empty() &&
+            !region.is_root()) {
+            small_regions.push_back(&region);
         }
     }
 
-    while (!small_regions.empty()) {
-        auto& region = small_regions.back();
-        small_regions.pop_back();
-
+    for (auto* region : small_regions) {
         auto node_id = (*region)->nodes.front();
 
         region->parent()->nodes.push_back(node_id);
-        sese_->node_regions.set(node_id, &region->parent());
+        sese_->node_regions.set(node_id, region->parent().id);
 
         sese_->regions.remove_node(region);
     }
 
-    // fix the ids
-    for (size_t i = 0; i < sese_->regions.nodes.size(); ++i) {
-        sese_->regions.nodes[i]->id = i;
-    }
+    // Drops the removed regions and fixes the ids
+    sese_->compact_regions();
 }
 
 void Layout::create_region_subgraphs() {
@@ -129,19 +366,19 @@ void Layout::create_region_nodes() {
     auto& editor = g_.editor();
 
     for (const auto& r : sese_->regions.nodes) {
-        auto& data   = regions_data_[r->id];
+        auto& data   = regions_data_[r.id];
         data.node_id = editor.make_node().id();
     }
 
     // Adds the region nodes to the appropriate regions
     for (const auto& r : sese_->regions.nodes) {
-        if (r->is_root()) {
+        if (r.is_root()) {
             continue;
         }
 
-        const auto& parent_region = r->parent();
+        const auto& parent_region = r.parent();
         auto& editor = regions_data_[parent_region.id].subgraph.editor();
-        editor.select_node(regions_data_[r->id].node_id);
+        editor.select_node(regions_data_[r.id].node_id);
     }
 }
 
@@ -188,51 +425,6 @@ void Layout::edit_region_exit(const SESE::SESERegion& r) {
     ge.edit_edge(exit, from_node, to_node);
 }
 
-namespace {
-// Is `successor` a successor of `region` that is, is `successor` contained
-// within `region`
-// NOLINTNEXTLINE(misc-no-recursion)
-auto is_region_successor(const SESE::SESERegion& region,
-                         const SESE::SESERegion& successor) -> bool {
-    if (successor == region) {
-        return true;
-    }
-
-    if (successor.depth <= region.depth) {
-        return false;
-    }
-
-    return is_region_successor(region, successor.parent());
-}
-
-[[nodiscard]] auto get_closest_ancestor(const SESE::SESERegion& r1,
-                                        const SESE::SESERegion& r2)
-    -> const SESE::SESERegion& {
-    auto depth = std::min(r1.depth, r2.depth);
-
-    const auto* r1_ = &r1;
-    const auto* r2_ = &r2;
-
-    while (r1_->depth != depth) {
-        r1_ = &r1_->parent();
-    }
-
-    while (r2_->depth != depth) {
-        r2_ = &r2_->parent();
-    }
-
-    while (r1_ != r2_) {
-        r1_ = &r1_->parent();
-        r2_ = &r2_->parent();
-    }
-
-    assert(r1_ == r2_);
-
-    return *r1_;
-}
-
-}  // namespace
-
 void Layout::edit_region_subgraph() {
     // return;
     for (const auto& edge : g_.edges()) {
@@ -240,7 +432,7 @@ void Layout::edit_region_subgraph() {
         const auto* to_region   = &sese_->get_region(edge.to());
 
         if (from_region != to_region) {
-            if (is_region_successor(*from_region, *to_region)) {
+            if (from_region->is_ancestor_of(*to_region)) {
                 // This is an entry edge
                 const auto* parent_region = from_region;
                 const auto* child_region  = to_region;
@@ -257,7 +449,7 @@ void Layout::edit_region_subgraph() {
 
                 auto& ge = get_editor(*parent_region);
                 ge.edit_edge(edge, edge.from(), node_id);
-            } else if (is_region_successor(*to_region, *from_region)) {
+            } else if (to_region->is_ancestor_of(*from_region)) {
                 // This is an exit edge
                 const auto* parent_region = to_region;
                 const auto* child_region  = from_region;
@@ -277,7 +469,8 @@ void Layout::edit_region_subgraph() {
             } else {
                 // The nodes connect through their parent
                 const auto& closest_ancestor =
-                    get_closest_ancestor(*to_region, *from_region);
+                    sese_->regions.lowest_common_ancestor(*to_region,
+                                                          *from_region);
 
                 auto from_id = edge.from().id();
                 while (from_region != &closest_ancestor) {
@@ -334,7 +527,7 @@ auto Layout::get_height(NodeId node) const -> float {
     return heights_.get(node);
 }
 
-auto Layout::get_waypoints(EdgeId edge) const -> const std::vector<Point>& {
+auto Layout::get_waypoints(EdgeId edge) const -> WaypointsView {
     return waypoints_.get(edge);
 }
 
@@ -355,35 +548,502 @@ void Layout::compute_layout(const SESE::SESERegion& r) {
 
     region.was_layout = true;
 
+    for (const auto* child_region : r.children()) {
+        compute_layout(*child_region);
+    }
+
+    layout_region(r);
+    finish_region();
+}
+
+void Layout::compute_layout_parallel() {
+    // The regions write to distinct ids of the attributes, which must not
+    // be resized concurrently
+    xs_.reserve(g_.max_node_id());
+    ys_.reserve(g_.max_node_id());
+    heights_.reserve(g_.max_node_id());
+    widths_.reserve(g_.max_node_id());
+    start_x_offset_.reserve(g_.max_edge_id());
+    end_x_offset_.reserve(g_.max_edge_id());
+    if (seed_xs_.has_value()) {
+        seed_xs_->reserve(g_.max_node_id());
+    }
+
+    // The number of children of each region that are not laid out
+    auto remaining =
+        std::vector<std::atomic<size_t>>(sese_->regions.nodes.size());
+    for (const auto& r : sese_->regions.nodes) {
+        remaining[r.id] = r.children().size();
+    }
+
+    // Holds the default executor until the regions are laid out
+    auto fallback  = std::shared_ptr<Executor>{};
+    auto* executor = options_.executor;
+    if (executor == nullptr) {
+        fallback = default_executor();
+        executor = fallback.get();
+    }
+
+    auto group = TaskGroup{*executor, options_.threads};
+
+    // Lays out a region then schedules its parent if it was the last child
+    auto schedule = [&](auto& self, const SESE::SESERegion& r) -> void {
+        group.run([&self, &r, &remaining, this] {
+            auto scope = ScratchScope{scratch_->resource()};
+
+            layout_region(r);
+            finish_region();
+
+            if (r.is_root()) {
+                return;
+            }
+
+            const auto& parent = r.parent();
+            if (remaining[parent.id].fetch_sub(1, std::memory_order_acq_rel) ==
+                1) {
+                self(self, parent);
+            }
+        });
+    };
+
+    for (const auto& r : sese_->regions.nodes) {
+        if (r.children().empty()) {
+            schedule(schedule, r);
+        }
+    }
+
+    group.wait();
+}
+
+struct Layout::ScratchGraph {
+    ScratchGraph(const Layout& layout, const RegionData& region)
+        : heights{graph, 0.0F},
+          widths{graph, 0.0F},
+          start_x_offset{graph, -1.0F},
+          end_x_offset{graph, -1.0F} {
+        auto& editor = graph.editor();
+        editor.push();
+
+        // The ids are given in the same order as in the subgraph
+        for (const auto& node : region.subgraph.nodes()) {
+            const auto local = editor.make_node();
+            nodes.push_back(node.id());
+
+            heights.set(local, layout.heights_.get(node));
+            widths.set(local, layout.widths_.get(node));
+        }
+
+        if (layout.seed_xs_.has_value()) {
+            seed_xs.emplace(graph, NAN);
+            for (size_t i = 0; i < nodes.size(); ++i) {
+                seed_xs->set(NodeId{i}, layout.seed_xs_->get(nodes[i]));
+            }
+        }
+
+        for (const auto& edge : region.subgraph.edges()) {
+            const auto local =
+                editor.make_edge(this->local(edge.from()), this->local(edge.to()));
+            edges.push_back(edge.id());
+
+            start_x_offset.set(local, layout.start_x_offset_.get(edge));
+            end_x_offset.set(local, layout.end_x_offset_.get(edge));
+        }
+
+        editor.commit();
+
+        assert(nodes.empty() ||
+               graph.root() == this->local(region.subgraph.root()));
+
+        // The entry and exit edges are only used as keys, they are numbered
+        // in order
+        for (auto entry : region.entries) {
+            entries.push_back({.node = this->local(entry.node),
+                               .edge = EdgeId{entries.size()}});
+        }
+
+        for (auto exit : region.exits) {
+            exits.push_back(
+                {.node = this->local(exit.node),
+                 .edge = EdgeId{entries.size() + exits.size()}});
+        }
+    }
+
+    /// @brief The id in the copy of a node of the subgraph
+    [[nodiscard]] auto local(NodeId node) const -> NodeId {
+        auto it = std::ranges::lower_bound(nodes, node);
+        assert(it != nodes.end() && *it == node);
+        return NodeId{static_cast<size_t>(it - nodes.begin())};
+    }
+
+    /// @brief The id in the copy of an edge of the subgraph
+    [[nodiscard]] auto local(EdgeId edge) const -> EdgeId {
+        auto it = std::ranges::lower_bound(edges, edge);
+        assert(it != edges.end() && *it == edge);
+        return EdgeId{static_cast<size_t>(it - edges.begin())};
+    }
+
+    Graph graph;
+
+    /// @brief The original id of each node of the copy
+    std::vector<NodeId> nodes;
+
+    /// @brief The original id of each edge of the copy
+    std::vector<EdgeId> edges;
+
+    NodeAttribute<float> heights;
+    NodeAttribute<float> widths;
+    EdgeAttribute<float> start_x_offset;
+    EdgeAttribute<float> end_x_offset;
+
+    std::optional<NodeAttribute<float>> seed_xs;
+
+    std::vector<IOPair> entries;
+    std::vector<IOPair> exits;
+};
+
+void Layout::init_region_order(RegionData& region) const {
+    auto& subgraph = region.subgraph;
+    auto& nodes    = region.dfs_nodes;
+    auto& edges    = region.dfs_edges;
+
+    nodes.clear();
+    edges.clear();
+
+    const auto ids = subgraph.nodes();
+    nodes.reserve(ids.size());
+    edges.reserve(subgraph.edge_count());
+
+    auto visited = std::vector<bool>(ids.size(), false);
+    auto index   = [&ids](NodeId node) {
+        auto it = std::ranges::lower_bound(ids, node, {}, &Node::id);
+        assert(it != ids.end() && it->id() == node);
+        return static_cast<size_t>(it - ids.begin());
+    };
+
+    // The children of each node on the path, and the next one to visit
+    auto stack = std::vector<std::pair<std::vector<NodeId>, size_t>>{};
+
+    auto visit = [&](NodeId node) {
+        visited[index(node)] = true;
+        nodes.push_back(node);
+
+        auto children = std::vector<NodeId>{};
+        for (const auto& edge : g_.get_node(node).edges()) {
+            if (edge.from() == node && subgraph.contains(edge.id())) {
+                edges.push_back(edge.id());
+                children.push_back(edge.to());
+            }
+        }
+
+        stack.emplace_back(std::move(children), 0);
+    };
+
+    auto search = [&](NodeId start) {
+        visit(start);
+
+        while (!stack.empty()) {
+            auto& [children, next] = stack.back();
+            if (next == children.size()) {
+                stack.pop_back();
+                continue;
+            }
+
+            const auto child = children[next++];
+            if (!visited[index(child)]) {
+                visit(child);
+            }
+        }
+    };
+
+    // The root of the subgraph is its smallest id, it only starts the search
+    // when the region has no entry
+    for (auto entry : region.entries) {
+        if (!visited[index(entry.node)]) {
+            search(entry.node);
+        }
+    }
+
+    if (!ids.empty() && !visited[index(subgraph.root().id())]) {
+        search(subgraph.root().id());
+    }
+
+    for (size_t i = 0; i < ids.size(); ++i) {
+        if (!visited[i]) {
+            search(ids[i].id());
+        }
+    }
+}
+
+auto Layout::region_key(const RegionData& region) const -> LayoutCache::Key {
+    const auto& nodes = region.dfs_nodes;
+    const auto& edges = region.dfs_edges;
+
+    // The position of each node in the region, by id
+    auto positions = std::vector<std::pair<NodeId, uint64_t>>{};
+    positions.reserve(nodes.size());
+    for (size_t i = 0; i < nodes.size(); ++i) {
+        positions.emplace_back(nodes[i], i);
+    }
+    std::ranges::sort(positions);
+
+    auto local = [&positions](NodeId node) -> uint64_t {
+        auto it = std::ranges::lower_bound(positions, node, {},
+                                           &std::pair<NodeId, uint64_t>::first);
+        assert(it != positions.end() && it->first == node);
+        return it->second;
+    };
+
+    auto pack = [](float a, float b) {
+        return (static_cast<uint64_t>(std::bit_cast<uint32_t>(a)) << 32U) |
+               std::bit_cast<uint32_t>(b);
+    };
+
+    auto key = LayoutCache::Key{};
+    key.reserve(6 + nodes.size() + (2 * edges.size()) + region.entries.size() +
+                region.exits.size());
+
+    key.push_back(static_cast<uint64_t>(options_.ordering));
+    key.push_back(static_cast<uint64_t>(options_.coordinates));
+    key.push_back(nodes.size());
+    key.push_back(edges.size());
+    key.push_back(region.entries.size());
+    key.push_back(region.exits.size());
+
+    for (const auto node : nodes) {
+        key.push_back(pack(widths_.get(node), heights_.get(node)));
+    }
+
+    for (const auto id : edges) {
+        const auto edge = g_.get_edge(id);
+        key.push_back((local(edge.from()) << 32U) | local(edge.to()));
+        key.push_back(
+            pack(start_x_offset_.get(edge), end_x_offset_.get(edge)));
+    }
+
+    for (auto entry : region.entries) {
+        key.push_back(local(entry.node));
+    }
+
+    for (auto exit : region.exits) {
+        key.push_back(local(exit.node));
+    }
+
+    return key;
+}
+
+void Layout::layout_region(const SESE::SESERegion& r) {
+    options_.cancellation.throw_if_cancelled();
+
+    auto& region = regions_data_[r.id];
+    auto& result = results_[r.id];
+
     for (const auto* child_region : r.children()) {
         auto node = get_region_node(*child_region);
 
-        compute_layout(*child_region);
         widths_.set(node, regions_data_[child_region->id].width);
         heights_.set(node, regions_data_[child_region->id].height);
     }
 
-    auto sugiyama =
-        SugiyamaAnalysis(region.subgraph, heights_, widths_, start_x_offset_,
-                         end_x_offset_, region.entries, region.exits);
+    init_region_order(region);
 
-    for (const auto& node : region.subgraph.nodes()) {
-        auto x = sugiyama.xs_.get(node);
-        auto y = sugiyama.ys_.get(node);
+    if (!result.dirty) {
+        store_region_layout(r, *result.layout);
+        return;
+    }
 
-        xs_.set(node, x);
+    result.key   = region_key(region);
+    result.dirty = false;
 
-        ys_.set(node, y);
+    // The region is the same as in the previous layout
+    if (previous_ != nullptr) {
+        result.layout = previous_->find(result.key);
+        if (result.layout != nullptr) {
+            store_region_layout(r, *result.layout);
+            return;
+        }
     }
 
-    for (const auto& edge : region.subgraph.edges()) {
-        waypoints_.set(edge, sugiyama.waypoints_.get(edge));
+    {
+        auto lock = std::lock_guard{mutex_};
+        stats_.region_layouts++;
+    }
+
+    auto options     = options_;
+    options.deadline = deadline_;
+
+    if (options_.threads <= 1 && !options_.cache_regions) {
+        auto sugiyama = SugiyamaAnalysis(
+            region.subgraph, heights_, widths_, start_x_offset_, end_x_offset_,
+            region.entries, region.exits, options, &result.hints,
+            seed_xs_.has_value() ? &*seed_xs_ : nullptr);
+
+        add_ordering_time(sugiyama.ordering_time_);
+        if (sugiyama.truncated_) {
+            mark_truncated(result);
+        }
+        result.layout = std::make_shared<const RegionLayout>(
+            read_region_layout(sugiyama, region.dfs_nodes, region.dfs_edges,
+                               region.entries, region.exits));
+
+        store_region_layout(r, *result.layout);
+        return;
+    }
+
+    // The key doesn't cover the seed, a seeded layout is neither read from nor
+    // written to the shared cache
+    const auto use_cache = options_.cache_regions && !seed_xs_.has_value();
+
+    auto layout = std::shared_ptr<const RegionLayout>{};
+    if (use_cache) {
+        layout = LayoutCache::global().find(result.key);
+
+        auto lock = std::lock_guard{mutex_};
+        if (layout != nullptr) {
+            stats_.cache_hits++;
+        } else {
+            stats_.cache_misses++;
+        }
+    }
+
+    if (layout == nullptr) {
+        // Works on a copy so that the regions don't share a graph editor, and
+        // so that identical regions have identical copies
+        auto scratch = ScratchGraph{*this, region};
+
+        auto sugiyama = SugiyamaAnalysis(
+            scratch.graph, scratch.heights, scratch.widths,
+            scratch.start_x_offset, scratch.end_x_offset, scratch.entries,
+            scratch.exits, options, &result.hints,
+            scratch.seed_xs.has_value() ? &*scratch.seed_xs : nullptr);
+
+        add_ordering_time(sugiyama.ordering_time_);
+        // The layout follows the order of the region
+        auto nodes = std::vector<NodeId>{};
+        nodes.reserve(region.dfs_nodes.size());
+        for (const auto node : region.dfs_nodes) {
+            nodes.push_back(scratch.local(node));
+        }
+
+        auto edges = std::vector<EdgeId>{};
+        edges.reserve(region.dfs_edges.size());
+        for (const auto edge : region.dfs_edges) {
+            edges.push_back(scratch.local(edge));
+        }
+
+        layout = std::make_shared<const RegionLayout>(read_region_layout(
+            sugiyama, nodes, edges, scratch.entries, scratch.exits));
+
+        if (sugiyama.truncated_) {
+            mark_truncated(result);
+        } else if (use_cache) {
+            LayoutCache::global().insert(result.key, layout);
+        }
     }
 
-    region.height = sugiyama.get_graph_height();
-    region.width  = sugiyama.get_graph_width();
+    result.layout = std::move(layout);
 
-    region.io_waypoints = sugiyama.get_io_waypoints();
+    store_region_layout(r, *result.layout);
+}
+
+void Layout::mark_truncated(RegionResult& result) {
+    // Laid out again by the next update
+    result.dirty = true;
+
+    auto lock        = std::lock_guard{mutex_};
+    stats_.truncated = true;
+}
+
+void Layout::finish_region() {
+    auto lock = std::lock_guard{mutex_};
+    laid_out_regions_++;
+    report(LayoutPhase::Nodes, static_cast<float>(laid_out_regions_) /
+                                   static_cast<float>(regions_data_.size()));
+}
+
+void Layout::report(LayoutPhase phase, float fraction) const {
+    if (options_.progress) {
+        options_.progress(phase, fraction);
+    }
+}
+
+void Layout::add_ordering_time(std::chrono::nanoseconds time) {
+    auto lock             = std::lock_guard{mutex_};
+    stats_.ordering_time += time;
+}
+
+auto Layout::read_region_layout(const SugiyamaAnalysis& sugiyama,
+                                std::span<const NodeId> nodes,
+                                std::span<const EdgeId> edges,
+                                const std::vector<IOPair>& entries,
+                                const std::vector<IOPair>& exits)
+    -> RegionLayout {
+    auto layout = RegionLayout{
+        .coords        = {},
+        .waypoints     = {},
+        .io_waypoints  = {},
+        .width         = sugiyama.get_graph_width(),
+        .height        = sugiyama.get_graph_height(),
+        .has_top_loop  = sugiyama.has_top_loop_,
+        .dummy_count   = sugiyama.dummy_nodes_.size(),
+    };
+
+    for (const auto node : nodes) {
+        layout.coords.push_back(
+            {.x = sugiyama.xs_.get(node), .y = sugiyama.ys_.get(node)});
+    }
+
+    for (const auto edge : edges) {
+        layout.waypoints.push_back(sugiyama.waypoints_.get(edge));
+    }
+
+    const auto& io_waypoints = sugiyama.get_io_waypoints();
+    for (auto entry : entries) {
+        layout.io_waypoints.push_back(io_waypoints.at(entry));
+    }
+
+    for (auto exit : exits) {
+        layout.io_waypoints.push_back(io_waypoints.at(exit));
+    }
+
+    return layout;
+}
+
+void Layout::store_region_layout(const SESE::SESERegion& r,
+                                 const RegionLayout& layout) {
+    auto& region = regions_data_[r.id];
+
+    const auto& nodes = region.dfs_nodes;
+    for (size_t i = 0; i < nodes.size(); ++i) {
+        xs_.set(nodes[i], layout.coords[i].x);
+        ys_.set(nodes[i], layout.coords[i].y);
+    }
+
+    region.io_waypoints.clear();
+    for (size_t i = 0; i < region.entries.size(); ++i) {
+        region.io_waypoints[region.entries[i]] = layout.io_waypoints[i];
+    }
+
+    for (size_t i = 0; i < region.exits.size(); ++i) {
+        region.io_waypoints[region.exits[i]] =
+            layout.io_waypoints[region.entries.size() + i];
+    }
+
+    {
+        auto lock = std::lock_guard{mutex_};
+
+        stats_.dummy_count += layout.dummy_count;
+
+        // The edges of a region are contiguous in the buffer
+        const auto& edges      = region.dfs_edges;
+        region.waypoints_begin = waypoints_.mark();
+        for (size_t i = 0; i < edges.size(); ++i) {
+            waypoints_.assign(edges[i], layout.waypoints[i]);
+        }
+        region.waypoints_end = waypoints_.mark();
+    }
+
+    region.height = layout.height;
+    region.width  = layout.width;
 
     for (auto entry_pair : region.entries) {
         end_x_offset_.set(entry_pair.edge,
@@ -398,8 +1058,8 @@ void Layout::compute_layout(const SESE::SESERegion& r) {
     heights_.set(region.node_id, region.height);
     widths_.set(region.node_id, region.width);
 
-    if (sugiyama.has_top_loop_) {
-        translate_region(r, {.x = 0, .y = -2 * Y_GUTTER});
+    if (layout.has_top_loop) {
+        region.offset = {.x = 0, .y = -2 * Y_GUTTER};
     }
 }
 
@@ -414,13 +1074,7 @@ void Layout::translate_region(const SESE::SESERegion& r, const Point& v) {
         ys_.set(node, node_y + v.y);
     }
 
-    for (const auto& edge : region.subgraph.edges()) {
-        auto& waypoints = waypoints_.get(edge);
-
-        for (auto& waypoint : waypoints) {
-            waypoint += v;
-        }
-    }
+    waypoints_.translate(region.waypoints_begin, region.waypoints_end, v);
 
     for (auto& kv : region.io_waypoints) {
         for (auto& waypoint : kv.second) {
@@ -429,18 +1083,26 @@ void Layout::translate_region(const SESE::SESERegion& r, const Point& v) {
     }
 }
 
-// NOLINTNEXTLINE (misc-no-recursion)
-void Layout::translate_region(const SESE::SESERegion& r) {
-    if (!r.is_root()) {
-        auto node = get_region_node(r);
+void Layout::resolve_coordinates() {
+    // Parents are resolved before their children: once a region is resolved
+    // the nodes standing for its children are at their absolute position
+    auto stack = std::vector<const SESE::SESERegion*>{&sese_->regions.root()};
 
-        auto v = Point{.x = Layout::get_x(node), .y = Layout::get_y(node)};
-        translate_region(r, v);
-    }
+    while (!stack.empty()) {
+        const auto* r = stack.back();
+        stack.pop_back();
 
-    // Propagate to children
-    for (const auto* child_region : r.children()) {
-        translate_region(*child_region);
+        auto v = regions_data_[r->id].offset;
+        if (!r->is_root()) {
+            auto node  = get_region_node(*r);
+            v         += {.x = Layout::get_x(node), .y = Layout::get_y(node)};
+        }
+
+        translate_region(*r, v);
+
+        for (const auto* child_region : r->children()) {
+            stack.push_back(child_region);
+        }
     }
 }
 
@@ -0,0 +1,92 @@
+#include "triskel/layout/layout_cache.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <utility>
+
+// NOLINTNEXTLINE(google-build-using-namespace)
+using namespace triskel;
+
+LayoutCache::LayoutCache(size_t capacity) : capacity_{capacity} {}
+
+auto LayoutCache::global() -> LayoutCache& {
+    static auto cache = LayoutCache{};
+    return cache;
+}
+
+auto LayoutCache::KeyHash::operator()(const Key& key) const -> size_t {
+    // Mixes in each word with the splitmix64 finalizer
+    auto hash = static_cast<uint64_t>(key.size());
+    for (auto word : key) {
+        hash ^= word + 0x9e3779b97f4a7c15ULL + (hash << 6) + (hash >> 2);
+        hash  = (hash ^ (hash >> 30)) * 0xbf58476d1ce4e5b9ULL;
+        hash  = (hash ^ (hash >> 27)) * 0x94d049bb133111ebULL;
+        hash ^= hash >> 31;
+    }
+
+    return static_cast<size_t>(hash);
+}
+
+auto LayoutCache::find(const Key& key) -> std::shared_ptr<const RegionLayout> {
+    auto lock = std::lock_guard{mutex_};
+
+    auto it = entries_.find(key);
+    if (it == entries_.end()) {
+        return nullptr;
+    }
+
+    lru_.splice(lru_.begin(), lru_, it->second.position);
+    return it->second.layout;
+}
+
+void LayoutCache::insert(Key key, std::shared_ptr<const RegionLayout> layout) {
+    auto lock = std::lock_guard{mutex_};
+
+    if (capacity_ == 0) {
+        return;
+    }
+
+    auto [it, inserted] = entries_.try_emplace(std::move(key));
+    if (!inserted) {
+        // Another thread laid out the same region
+        lru_.splice(lru_.begin(), lru_, it->second.position);
+        return;
+    }
+
+    lru_.push_front(&it->first);
+    it->second = {.layout = std::move(layout), .position = lru_.begin()};
+
+    evict();
+}
+
+void LayoutCache::evict() {
+    while (entries_.size() > capacity_) {
+        const auto* key = lru_.back();
+        lru_.pop_back();
+        entries_.erase(*key);
+    }
+}
+
+void LayoutCache::set_capacity(size_t capacity) {
+    auto lock = std::lock_guard{mutex_};
+    capacity_ = capacity;
+    evict();
+}
+
+auto LayoutCache::capacity() const -> size_t {
+    auto lock = std::lock_guard{mutex_};
+    return capacity_;
+}
+
+auto LayoutCache::size() const -> size_t {
+    auto lock = std::lock_guard{mutex_};
+    return entries_.size();
+}
+
+void LayoutCache::clear() {
+    auto lock = std::lock_guard{mutex_};
+    entries_.clear();
+    lru_.clear();
+}
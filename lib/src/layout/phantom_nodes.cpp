@@ -6,7 +6,6 @@
 #include <map>
 #include <memory>
 #include <ranges>
-#include <set>
 #include <span>
 #include <unordered_map>
 #include <utility>
@@ -16,7 +15,6 @@
 #include <fmt/format.h>
 #include <fmt/ranges.h>
 
-#include "triskel/analysis/dfs.hpp"
 #include "triskel/analysis/lengauer_tarjan.hpp"
 #include "triskel/graph/igraph.hpp"
 #include "triskel/utils/attribute.hpp"
@@ -26,8 +24,6 @@ using namespace triskel;
 
 namespace {
 
-using DFSNums = NodeAttribute<std::vector<size_t>>;
-
 auto starts_with(const std::span<size_t>& vec,
                  const std::span<size_t>& prefix) -> bool {
     return vec.size() >= prefix.size() &&
@@ -42,17 +38,13 @@ struct RNode {
     std::vector<size_t> radix;
     std::unordered_map<size_t, std::unique_ptr<RNode>> children;
 
-    RNode() {
-        static size_t id_ = 0;
-        id                = id_++;
-    }
-
     // NOLINTNEXTLINE
     void dump() {
+        const auto id = fmt::ptr(this);
         fmt::print("n{} [label=\"{}\"]\n", id, radix);
 
         for (const auto& child : children) {
-            fmt::print("n{} -> n{}\n", id, child.second->id);
+            fmt::print("n{} -> n{}\n", id, fmt::ptr(child.second.get()));
             child.second->dump();
         }
 
@@ -74,7 +66,7 @@ struct RNode {
     }
 
     void split(const Node& n, const std::span<size_t>& n_radix) {
-        auto i = 0;
+        size_t i = 0;
 
         auto size = std::min(radix.size(), n_radix.size());
         while (i < size) {
@@ -101,7 +93,7 @@ struct RNode {
         radix.assign(start.begin(), start.end());
         new_node->radix.assign(end.begin(), end.end());
 
-        children[radix[i]] = std::move(new_node);
+        children[new_node->radix.front()] = std::move(new_node);
 
         if (i == n_radix.size()) {
             node_ids.push_back(n);
@@ -109,8 +101,6 @@ struct RNode {
             new_child(n, n_radix.subspan(i));
         }
     }
-
-    size_t id;
 };
 
 // A radix tree ish
@@ -180,16 +170,43 @@ struct RTree {
     RNode root;
 };
 
-// Split the entry edges using a radix tree
-void split_node(IGraph& graph, Node& node, DFSNums& keys) {
+// The ids of the strict dominators of `node`, from the root down
+auto dominator_path(const NodeAttribute<NodeId>& idoms,
+                    NodeId root,
+                    NodeId node) -> std::vector<size_t> {
+    auto path = std::vector<size_t>{};
+
+    while (node != root && node != NodeId::InvalidID) {
+        node = idoms.get(node);
+
+        if (node != NodeId::InvalidID) {
+            path.push_back(static_cast<size_t>(node));
+        }
+    }
+
+    std::ranges::reverse(path);
+    return path;
+}
+
+// Merges the edges entering the node using a radix tree of the dominator
+// paths of its predecessors
+void split_node(IGraph& graph,
+                const Node& node,
+                const std::map<NodeId, std::vector<EdgeId>>& parents,
+                const NodeAttribute<NodeId>& idoms,
+                EdgeConcentration& concentration) {
     auto& editor = graph.editor();
     auto rtree   = RTree{};
 
-    for (const auto& parent : node.parent_nodes()) {
-        rtree.insert(parent, keys[parent]);
+    for (const auto& [parent, edges] : parents) {
+        auto keys = dominator_path(idoms, graph.root(), parent);
+        rtree.insert(graph.get_node(parent), keys);
     }
 
-    std::map<size_t, NodeId> rnode_to_graph;
+    std::unordered_map<const RNode*, NodeId> rnode_to_graph;
+
+    // The edge leaving each node of the tree towards `node`
+    std::map<NodeId, EdgeId> next;
 
     // reverse bfs
     auto rnodes = rtree.bfs();
@@ -197,86 +214,168 @@ void split_node(IGraph& graph, Node& node, DFSNums& keys) {
 
     for (auto* rnode : rnodes) {
         if (rnode->children.empty() && rnode->node_ids.size() == 1) {
-            rnode_to_graph[rnode->id] = rnode->node_ids.front();
+            rnode_to_graph[rnode] = rnode->node_ids.front();
+            continue;
+        }
+
+        if (rnode->children.size() == 1 && rnode->node_ids.empty()) {
+            // Nothing is merged here
+            rnode_to_graph[rnode] =
+                rnode_to_graph.at(rnode->children.begin()->second.get());
             continue;
         }
 
         // We need to create a new node for this element
-        auto node                 = editor.make_node();
-        rnode_to_graph[rnode->id] = node.id();
+        auto phantom          = editor.make_node();
+        rnode_to_graph[rnode] = phantom.id();
+        concentration.phantoms.push_back(phantom.id());
 
         // Creates an edge from each of the children to the parent
         for (auto& child : rnode->children) {
-            auto child_id = rnode_to_graph.at(child.second->id);
-            editor.make_edge(child_id, node);
+            auto child_id  = rnode_to_graph.at(child.second.get());
+            next[child_id] = editor.make_edge(child_id, phantom).id();
         }
 
         // Create an edge from each leaf to the parent
         for (auto& leaf_id : rnode->node_ids) {
-            editor.make_edge(leaf_id, node);
+            next[leaf_id] = editor.make_edge(leaf_id, phantom).id();
         }
     }
 
-    // Deletes all the edges to the node
-    for (const auto& edge : node.parent_edges()) {
-        editor.remove_edge(edge);
-    }
+    // Adds the trunk from the root to our node
+    auto root_id  = rnode_to_graph.at(&rtree.root);
+    next[root_id] = editor.make_edge(root_id, node).id();
+
+    // Replaces the edges to the node by their path
+    for (const auto& [parent, edges] : parents) {
+        auto path = std::vector<EdgeId>{};
 
-    // Adds an edge from the root to our node
-    editor.make_edge(rnode_to_graph.at(rtree.root.id), node);
+        for (auto cursor = parent; cursor != node.id();) {
+            const auto edge = graph.get_edge(next.at(cursor));
+            path.push_back(edge.id());
+            cursor = edge.to().id();
+        }
+
+        for (auto edge : edges) {
+            editor.remove_edge(edge);
+            concentration.paths.push_back({.edge = edge, .edges = path});
+        }
+    }
 }
 
-// NOLINTNEXTLINE(misc-no-recursion)
-auto make_keys(NodeId root,
-               NodeAttribute<std::vector<size_t>>& keys,
-               NodeAttribute<NodeId>& idoms,
-               NodeId node) -> std::vector<size_t> {
-    auto& nums = keys[node];
+// Merges the parallel edges, the first edge is kept
+void dedupe_edges(IGraph& g, EdgeConcentration& concentration) {
+    auto& editor = g.editor();
+
+    for (const auto& node : g.nodes()) {
+        auto kept = std::map<NodeId, EdgeId>{};
+
+        for (const auto& edge : node.child_edges()) {
+            auto [it, inserted] = kept.try_emplace(edge.to().id(), edge.id());
+
+            // Self loops are listed twice
+            if (inserted || it->second == edge.id()) {
+                continue;
+            }
 
-    if (!nums.empty()) {
-        return nums;
+            editor.remove_edge(edge);
+            concentration.paths.push_back(
+                {.edge = edge.id(), .edges = {it->second}});
+        }
     }
+}
+
+// Pre and post order numbers of the dominator tree, to test dominance in
+// constant time
+struct DominatorTree {
+    DominatorTree(const IGraph& g, const NodeAttribute<NodeId>& idoms)
+        : pre(g, 0), post(g, 0) {
+        auto children = NodeAttribute<std::vector<NodeId>>{g, {}};
+        for (const auto& node : g.nodes()) {
+            auto idom = idoms.get(node);
+            if (node != g.root() && idom != NodeId::InvalidID) {
+                children[idom].push_back(node.id());
+            }
+        }
+
+        size_t counter = 1;
+        auto stack     = std::vector<std::pair<NodeId, size_t>>{};
+        stack.emplace_back(g.root().id(), 0);
+        pre.set(g.root(), counter++);
+
+        while (!stack.empty()) {
+            auto& [node, i] = stack.back();
 
-    if (node == root) {
-        return nums;
+            if (i < children[node].size()) {
+                auto child = children[node][i++];
+                pre.set(child, counter++);
+                stack.emplace_back(child, 0);
+                continue;
+            }
+
+            post.set(node, counter++);
+            stack.pop_back();
+        }
     }
 
-    auto idom     = idoms[node];
-    auto previous = make_keys(root, keys, idoms, idom);
-    nums          = std::vector<size_t>(previous);
-    nums.push_back(static_cast<size_t>(idom));
+    // Does `a` dominate `b`
+    [[nodiscard]] auto dominates(NodeId a, NodeId b) const -> bool {
+        return pre.get(b) != 0 && pre.get(a) <= pre.get(b) &&
+               post.get(b) <= post.get(a);
+    }
 
-    return nums;
-}
+    NodeAttribute<size_t> pre;
+    NodeAttribute<size_t> post;
+};
 
 }  // namespace
 
-void triskel::create_phantom_nodes(IGraph& g) {
-    auto idoms = make_idoms(g);
+auto triskel::create_phantom_nodes(IGraph& g,
+                                   size_t threshold) -> EdgeConcentration {
+    auto concentration = EdgeConcentration{};
 
-    const auto& nodes = g.nodes();
-    auto keys         = NodeAttribute<std::vector<size_t>>{nodes.size(), {}};
+    // Merging a single edge is pointless
+    threshold = std::max<size_t>(threshold, 2);
 
-    for (const auto& node : nodes) {
-        make_keys(g.root(), keys, idoms, node);
-    }
+    dedupe_edges(g, concentration);
 
-    auto& editor = g.editor();
+    auto idoms       = make_idoms(g);
+    const auto dtree = DominatorTree{g, idoms};
 
-    for (auto& node : g.nodes()) {
-        if (node.parent_nodes().size() >= 3) {
-            split_node(g, node, keys);
+    for (const auto& node : g.nodes()) {
+        if (node.parent_edges().size() < threshold) {
             continue;
         }
-        if (node.child_edges().size() > 1 && node.parent_edges().size() > 1) {
-            // Create a single parent for this node
-            auto parent = editor.make_node();
 
-            for (const auto& edge : node.parent_edges()) {
-                editor.edit_edge(edge, edge.from(), parent);
+        auto parents = std::map<NodeId, std::vector<EdgeId>>{};
+
+        for (const auto& edge : node.parent_edges()) {
+            const auto parent = edge.from().id();
+
+            // Back edges are not merged
+            if (dtree.dominates(node, parent)) {
+                continue;
             }
 
-            editor.make_edge(parent, node);
+            parents[parent].push_back(edge.id());
+        }
+
+        if (parents.size() >= threshold) {
+            split_node(g, node, parents, idoms, concentration);
         }
     }
-}
\ No newline at end of file
+
+    // Paths can go through deduplicated edges
+    auto kept = std::map<EdgeId, std::vector<EdgeId>>{};
+    for (const auto& path : concentration.paths) {
+        kept[path.edge] = path.edges;
+    }
+
+    for (auto& path : concentration.paths) {
+        while (path.edges.size() == 1 && kept.contains(path.edges.front())) {
+            path.edges = kept.at(path.edges.front());
+        }
+    }
+
+    return concentration;
+}
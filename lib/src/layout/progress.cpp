@@ -0,0 +1,28 @@
+#include "triskel/layout/progress.hpp"
+
+#include <atomic>
+#include <memory>
+#include <stdexcept>
+
+// NOLINTNEXTLINE(google-build-using-namespace)
+using namespace triskel;
+
+LayoutCancelled::LayoutCancelled()
+    : std::runtime_error{"The layout was cancelled"} {}
+
+CancellationToken::CancellationToken()
+    : cancelled_{std::make_shared<std::atomic<bool>>(false)} {}
+
+void CancellationToken::cancel() const {
+    cancelled_->store(true, std::memory_order_relaxed);
+}
+
+auto CancellationToken::is_cancelled() const -> bool {
+    return cancelled_->load(std::memory_order_relaxed);
+}
+
+void CancellationToken::throw_if_cancelled() const {
+    if (is_cancelled()) {
+        throw LayoutCancelled{};
+    }
+}
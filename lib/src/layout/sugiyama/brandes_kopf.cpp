@@ -0,0 +1,509 @@
+// Based on "Fast and Simple Horizontal Coordinate Assignment" by Brandes and
+// Koepf.
+// The horizontal compaction runs a longest path on the graph of the blocks
+// rather than the original class shifting, which can make nodes overlap (see
+// "Erratum: Fast and Simple Horizontal Coordinate Assignment")
+
+#include "triskel/layout/sugiyama/brandes_kopf.hpp"
+
+#include <algorithm>
+#include <array>
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <span>
+#include <vector>
+
+// NOLINTNEXTLINE(google-build-using-namespace)
+using namespace triskel;
+
+namespace {
+
+/// @brief The direction the layers are swept in during the vertical alignment
+enum class Vertical : uint8_t { Down, Up };
+
+/// @brief The direction the nodes are packed towards during the horizontal
+/// compaction
+enum class Horizontal : uint8_t { Left, Right };
+
+struct BKAnalysis {
+    explicit BKAnalysis(const BKGraph& graph);
+
+    /// @brief Lays out the graph in a given direction, the coordinates are
+    /// those of the left side of the nodes
+    [[nodiscard]] auto layout(Vertical vertical, Horizontal horizontal)
+        -> std::vector<float>;
+
+    /// @brief Merges the four layouts into the final one
+    [[nodiscard]] auto balance(std::array<std::vector<float>, 4>& layouts) const
+        -> std::vector<float>;
+
+   private:
+    const BKGraph& graph_;
+
+    /// @brief The index of each node in its layer
+    std::vector<size_t> positions_;
+
+    // The segments to the upper and lower layer of each node (CSR), sorted
+    // from left to right
+    std::vector<size_t> up_offsets_;
+    std::vector<size_t> up_segments_;
+    std::vector<size_t> down_offsets_;
+    std::vector<size_t> down_segments_;
+
+    /// @brief Segments crossing an inner segment (type 1 conflicts)
+    std::vector<bool> conflicts_;
+
+    [[nodiscard]] auto up_segments(size_t node) const
+        -> std::span<const size_t> {
+        return std::span{up_segments_}.subspan(
+            up_offsets_[node], up_offsets_[node + 1] - up_offsets_[node]);
+    }
+
+    [[nodiscard]] auto down_segments(size_t node) const
+        -> std::span<const size_t> {
+        return std::span{down_segments_}.subspan(
+            down_offsets_[node], down_offsets_[node + 1] - down_offsets_[node]);
+    }
+
+    [[nodiscard]] auto is_inner(const BKGraph::Segment& segment) const
+        -> bool {
+        return graph_.nodes[segment.upper].is_dummy &&
+               graph_.nodes[segment.lower].is_dummy;
+    }
+
+    void make_segment_lists();
+
+    void mark_type1_conflicts();
+
+    // Scratch vectors, reused by each layout
+    std::vector<size_t> roots_;
+    std::vector<size_t> aligns_;
+    std::vector<float> inner_shifts_;
+    std::vector<size_t> hpositions_;
+    std::vector<size_t> candidates_;
+
+    void vertical_alignment(const std::vector<std::vector<size_t>>& layers,
+                            Vertical vertical,
+                            Horizontal horizontal);
+
+    [[nodiscard]] auto horizontal_compaction(
+        const std::vector<std::vector<size_t>>& layers,
+        Horizontal horizontal) const -> std::vector<float>;
+};
+
+BKAnalysis::BKAnalysis(const BKGraph& graph)
+    : graph_{graph}, positions_(graph.nodes.size(), 0) {
+    for (const auto& layer : graph_.layers) {
+        for (size_t i = 0; i < layer.size(); ++i) {
+            positions_[layer[i]] = i;
+        }
+    }
+
+    make_segment_lists();
+    mark_type1_conflicts();
+}
+
+void BKAnalysis::make_segment_lists() {
+    const auto node_count = graph_.nodes.size();
+
+    up_offsets_.assign(node_count + 1, 0);
+    down_offsets_.assign(node_count + 1, 0);
+
+    for (const auto& segment : graph_.segments) {
+        up_offsets_[segment.lower + 1]++;
+        down_offsets_[segment.upper + 1]++;
+    }
+
+    for (size_t i = 0; i < node_count; ++i) {
+        up_offsets_[i + 1] += up_offsets_[i];
+        down_offsets_[i + 1] += down_offsets_[i];
+    }
+
+    up_segments_.resize(graph_.segments.size());
+    down_segments_.resize(graph_.segments.size());
+
+    auto up_cursor   = up_offsets_;
+    auto down_cursor = down_offsets_;
+    for (size_t s = 0; s < graph_.segments.size(); ++s) {
+        const auto& segment                      = graph_.segments[s];
+        up_segments_[up_cursor[segment.lower]++] = s;
+        down_segments_[down_cursor[segment.upper]++] = s;
+    }
+
+    // Segments are sorted by the position of their other end, then by port
+    for (size_t node = 0; node < node_count; ++node) {
+        auto ups = std::span{up_segments_}.subspan(
+            up_offsets_[node], up_offsets_[node + 1] - up_offsets_[node]);
+        std::ranges::sort(ups, [&](size_t a, size_t b) {
+            const auto& sa = graph_.segments[a];
+            const auto& sb = graph_.segments[b];
+            if (sa.upper != sb.upper) {
+                return positions_[sa.upper] < positions_[sb.upper];
+            }
+            return sa.upper_port < sb.upper_port;
+        });
+
+        auto downs = std::span{down_segments_}.subspan(
+            down_offsets_[node], down_offsets_[node + 1] - down_offsets_[node]);
+        std::ranges::sort(downs, [&](size_t a, size_t b) {
+            const auto& sa = graph_.segments[a];
+            const auto& sb = graph_.segments[b];
+            if (sa.lower != sb.lower) {
+                return positions_[sa.lower] < positions_[sb.lower];
+            }
+            return sa.lower_port < sb.lower_port;
+        });
+    }
+}
+
+// Inner segments (between two dummy nodes) take precedence over the segments
+// they cross
+void BKAnalysis::mark_type1_conflicts() {
+    conflicts_.assign(graph_.segments.size(), false);
+
+    for (size_t i = 0; i + 1 < graph_.layers.size(); ++i) {
+        const auto& upper = graph_.layers[i];
+        const auto& lower = graph_.layers[i + 1];
+
+        if (upper.empty()) {
+            continue;
+        }
+
+        size_t k0 = 0;
+        size_t l  = 0;
+
+        for (size_t l1 = 0; l1 < lower.size(); ++l1) {
+            const auto v = lower[l1];
+
+            auto inner = std::ranges::find_if(up_segments(v), [&](size_t s) {
+                return is_inner(graph_.segments[s]);
+            });
+            const auto has_inner = inner != up_segments(v).end();
+
+            if (l1 != lower.size() - 1 && !has_inner) {
+                continue;
+            }
+
+            auto k1 = upper.size() - 1;
+            if (has_inner) {
+                k1 = positions_[graph_.segments[*inner].upper];
+            }
+
+            for (; l <= l1; ++l) {
+                for (auto s : up_segments(lower[l])) {
+                    const auto& segment = graph_.segments[s];
+                    const auto k        = positions_[segment.upper];
+
+                    if ((k < k0 || k > k1) && !is_inner(segment)) {
+                        conflicts_[s] = true;
+                    }
+                }
+            }
+
+            k0 = k1;
+        }
+    }
+}
+
+void BKAnalysis::vertical_alignment(
+    const std::vector<std::vector<size_t>>& layers,
+    Vertical vertical,
+    Horizontal horizontal) {
+    const auto node_count = graph_.nodes.size();
+
+    roots_.resize(node_count);
+    aligns_.resize(node_count);
+    inner_shifts_.assign(node_count, 0.0F);
+    for (size_t v = 0; v < node_count; ++v) {
+        roots_[v]  = v;
+        aligns_[v] = v;
+    }
+
+    // Ports in the mirrored space of a right compaction
+    auto port = [&](size_t node, float p) {
+        return horizontal == Horizontal::Left ? p
+                                              : graph_.nodes[node].width - p;
+    };
+
+    for (size_t i = 1; i < layers.size(); ++i) {
+        // The position of the last aligned node on the previous layer
+        int64_t r = -1;
+
+        for (auto v : layers[i]) {
+            candidates_.clear();
+
+            const auto segments = vertical == Vertical::Down
+                                      ? up_segments(v)
+                                      : down_segments(v);
+            for (auto s : segments) {
+                if (graph_.segments[s].is_alignable) {
+                    candidates_.push_back(s);
+                }
+            }
+
+            if (horizontal == Horizontal::Right) {
+                std::ranges::reverse(candidates_);
+            }
+
+            const auto d = candidates_.size();
+            if (d == 0) {
+                continue;
+            }
+
+            // The lower and upper medians
+            for (auto m : {(d - 1) / 2, d / 2}) {
+                if (aligns_[v] != v) {
+                    break;
+                }
+
+                const auto s        = candidates_[m];
+                const auto& segment = graph_.segments[s];
+
+                auto u      = segment.upper;
+                auto u_port = segment.upper_port;
+                auto v_port = segment.lower_port;
+                if (vertical == Vertical::Up) {
+                    u = segment.lower;
+                    std::swap(u_port, v_port);
+                }
+
+                const auto pos = static_cast<int64_t>(hpositions_[u]);
+                if (conflicts_[s] || r >= pos) {
+                    continue;
+                }
+
+                aligns_[u] = v;
+                roots_[v]  = roots_[u];
+                aligns_[v] = roots_[v];
+                r          = pos;
+
+                // Keeps the segment straight
+                inner_shifts_[v] =
+                    inner_shifts_[u] + port(u, u_port) - port(v, v_port);
+            }
+        }
+    }
+}
+
+auto BKAnalysis::horizontal_compaction(
+    const std::vector<std::vector<size_t>>& layers,
+    Horizontal horizontal) const -> std::vector<float> {
+    const auto node_count = graph_.nodes.size();
+
+    // Gutters in the mirrored space of a right compaction
+    auto left_gutter = [&](size_t node) {
+        const auto& n = graph_.nodes[node];
+        return horizontal == Horizontal::Left ? n.left_gutter : n.right_gutter;
+    };
+    auto right_gutter = [&](size_t node) {
+        const auto& n = graph_.nodes[node];
+        return horizontal == Horizontal::Left ? n.right_gutter : n.left_gutter;
+    };
+
+    // The graph of the blocks: root(p) -> root(w) when p is left of w
+    struct Separation {
+        size_t to;
+        float distance;
+    };
+
+    auto offsets = std::vector<size_t>(node_count + 1, 0);
+    for (const auto& layer : layers) {
+        for (size_t i = 1; i < layer.size(); ++i) {
+            offsets[roots_[layer[i - 1]] + 1]++;
+        }
+    }
+    for (size_t i = 0; i < node_count; ++i) {
+        offsets[i + 1] += offsets[i];
+    }
+
+    auto separations = std::vector<Separation>(offsets.back());
+    auto in_degrees  = std::vector<size_t>(node_count, 0);
+    auto cursor      = offsets;
+    for (const auto& layer : layers) {
+        for (size_t i = 1; i < layer.size(); ++i) {
+            const auto p = layer[i - 1];
+            const auto w = layer[i];
+
+            const auto distance = graph_.nodes[p].width + right_gutter(p) +
+                                  left_gutter(w) + inner_shifts_[p] -
+                                  inner_shifts_[w];
+
+            separations[cursor[roots_[p]]++] = {.to       = roots_[w],
+                                                .distance = distance};
+            in_degrees[roots_[w]]++;
+        }
+    }
+
+    // Topological order of the blocks
+    auto order = std::vector<size_t>{};
+    order.reserve(node_count);
+
+    [[maybe_unused]] size_t block_count = 0;
+    for (size_t v = 0; v < node_count; ++v) {
+        if (roots_[v] != v) {
+            continue;
+        }
+
+        block_count++;
+        if (in_degrees[v] == 0) {
+            order.push_back(v);
+        }
+    }
+
+    for (size_t i = 0; i < order.size(); ++i) {
+        const auto b = order[i];
+        for (size_t e = offsets[b]; e < offsets[b + 1]; ++e) {
+            if (--in_degrees[separations[e].to] == 0) {
+                order.push_back(separations[e].to);
+            }
+        }
+    }
+
+    // The alignment never crosses itself, so the block graph is acyclic
+    assert(order.size() == block_count);
+
+    // Pushes the blocks as far left as possible
+    auto xs = std::vector<float>(node_count, 0.0F);
+    for (auto b : order) {
+        for (size_t e = offsets[b]; e < offsets[b + 1]; ++e) {
+            const auto& separation = separations[e];
+            xs[separation.to] =
+                std::max(xs[separation.to], xs[b] + separation.distance);
+        }
+    }
+
+    // Pulls the blocks to the right, towards the blocks they are separated
+    // from, without moving the blocks on their right
+    for (auto it = order.rbegin(); it != order.rend(); ++it) {
+        const auto b = *it;
+
+        auto x = std::numeric_limits<float>::infinity();
+        for (size_t e = offsets[b]; e < offsets[b + 1]; ++e) {
+            const auto& separation = separations[e];
+            x = std::min(x, xs[separation.to] - separation.distance);
+        }
+
+        if (x != std::numeric_limits<float>::infinity()) {
+            xs[b] = std::max(xs[b], x);
+        }
+    }
+
+    auto node_xs = std::vector<float>(node_count, 0.0F);
+    for (size_t v = 0; v < node_count; ++v) {
+        node_xs[v] = xs[roots_[v]] + inner_shifts_[v];
+
+        if (horizontal == Horizontal::Right) {
+            // Back from the mirrored space
+            node_xs[v] = -node_xs[v] - graph_.nodes[v].width;
+        }
+    }
+
+    return node_xs;
+}
+
+auto BKAnalysis::layout(Vertical vertical, Horizontal horizontal)
+    -> std::vector<float> {
+    auto layers = graph_.layers;
+
+    if (vertical == Vertical::Up) {
+        std::ranges::reverse(layers);
+    }
+
+    if (horizontal == Horizontal::Right) {
+        for (auto& layer : layers) {
+            std::ranges::reverse(layer);
+        }
+    }
+
+    hpositions_.resize(graph_.nodes.size());
+    for (const auto& layer : layers) {
+        for (size_t i = 0; i < layer.size(); ++i) {
+            hpositions_[layer[i]] = i;
+        }
+    }
+
+    vertical_alignment(layers, vertical, horizontal);
+
+    return horizontal_compaction(layers, horizontal);
+}
+
+auto BKAnalysis::balance(std::array<std::vector<float>, 4>& layouts) const
+    -> std::vector<float> {
+    const auto node_count = graph_.nodes.size();
+
+    auto mins = std::array<float, 4>{};
+    auto maxs = std::array<float, 4>{};
+
+    for (size_t k = 0; k < layouts.size(); ++k) {
+        mins[k] = std::numeric_limits<float>::infinity();
+        maxs[k] = -std::numeric_limits<float>::infinity();
+
+        for (size_t v = 0; v < node_count; ++v) {
+            const auto& node = graph_.nodes[v];
+            mins[k] = std::min(mins[k], layouts[k][v] - node.left_gutter);
+            maxs[k] = std::max(maxs[k],
+                               layouts[k][v] + node.width + node.right_gutter);
+        }
+    }
+
+    // Aligns every layout to the narrowest one
+    size_t smallest = 0;
+    for (size_t k = 1; k < layouts.size(); ++k) {
+        if (maxs[k] - mins[k] < maxs[smallest] - mins[smallest]) {
+            smallest = k;
+        }
+    }
+
+    for (size_t k = 0; k < layouts.size(); ++k) {
+        // Left layouts are even numbered
+        const auto shift = k % 2 == 0 ? mins[smallest] - mins[k]
+                                      : maxs[smallest] - maxs[k];
+
+        for (auto& x : layouts[k]) {
+            x += shift;
+        }
+    }
+
+    auto xs = std::vector<float>(node_count, 0.0F);
+    auto x0 = std::numeric_limits<float>::infinity();
+
+    for (size_t v = 0; v < node_count; ++v) {
+        auto candidates = std::array<float, 4>{};
+        for (size_t k = 0; k < layouts.size(); ++k) {
+            candidates[k] = layouts[k][v];
+        }
+
+        std::ranges::sort(candidates);
+
+        // Average median
+        xs[v] = (candidates[1] + candidates[2]) / 2.0F;
+        x0    = std::min(x0, xs[v] - graph_.nodes[v].left_gutter);
+    }
+
+    for (auto& x : xs) {
+        x -= x0;
+    }
+
+    return xs;
+}
+
+}  // namespace
+
+auto triskel::brandes_kopf(const BKGraph& graph) -> std::vector<float> {
+    if (graph.nodes.empty()) {
+        return {};
+    }
+
+    auto analysis = BKAnalysis{graph};
+
+    auto layouts = std::array<std::vector<float>, 4>{
+        analysis.layout(Vertical::Down, Horizontal::Left),
+        analysis.layout(Vertical::Down, Horizontal::Right),
+        analysis.layout(Vertical::Up, Horizontal::Left),
+        analysis.layout(Vertical::Up, Horizontal::Right),
+    };
+
+    return analysis.balance(layouts);
+}
@@ -0,0 +1,159 @@
+#include "triskel/layout/sugiyama/layer_bounds.hpp"
+
+#include <algorithm>
+#include <bit>
+#include <cfloat>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <vector>
+
+// NOLINTNEXTLINE(google-build-using-namespace)
+using namespace triskel;
+
+namespace {
+/// @brief The number of bits after the binary point needed to represent `v`
+auto fractional_bits(float v) -> int {
+    if (v == 0.0F) {
+        return 0;
+    }
+
+    if (!std::isfinite(v)) {
+        return std::numeric_limits<int>::max();
+    }
+
+    // v = mantissa * 2^(exponent - FLT_MANT_DIG) with mantissa an integer
+    int exponent        = 0;
+    const auto mantissa = static_cast<uint32_t>(
+        std::ldexp(std::frexp(std::abs(v), &exponent), FLT_MANT_DIG));
+
+    return std::max(0, FLT_MANT_DIG - exponent - std::countr_zero(mantissa));
+}
+}  // namespace
+
+LayerBounds::LayerBounds(const std::vector<Item>& items)
+    : prefix_widths_(items.size() + 1, 0.0),
+      left_blockers_(items.size(), NO_BLOCKER),
+      right_blockers_(items.size(), NO_BLOCKER) {
+    widths_.reserve(items.size());
+    rights_.reserve(items.size());
+    left_gutters_.reserve(items.size());
+    priorities_.reserve(items.size());
+
+    // The sums of widths are exact when every term is a multiple of
+    // 2^-bits and the sums stay below 2^(FLT_MANT_DIG - bits)
+    auto bits   = 0;
+    auto total  = 0.0;
+    auto margin = 0.0;
+
+    for (size_t i = 0; i < items.size(); ++i) {
+        const auto& item = items[i];
+
+        // The same terms as the additions of the walk
+        const float width =
+            item.width + (item.left_gutter + item.right_gutter);
+        const float right = item.width + item.right_gutter;
+
+        widths_.push_back(width);
+        rights_.push_back(right);
+        left_gutters_.push_back(item.left_gutter);
+        priorities_.push_back(item.priority);
+
+        prefix_widths_[i + 1] = prefix_widths_[i] + width;
+
+        bits   = std::max({bits, fractional_bits(width), fractional_bits(right),
+                           fractional_bits(item.left_gutter)});
+        total  += std::abs(width);
+        margin = std::max({margin, std::abs(static_cast<double>(right)),
+                           std::abs(static_cast<double>(item.left_gutter))});
+    }
+
+    is_exact_ =
+        std::ldexp(total + margin, bits) < std::ldexp(1.0, FLT_MANT_DIG);
+
+    // Monotonic stacks of the priorities
+    auto stack = std::vector<size_t>{};
+    for (size_t i = 0; i < items.size(); ++i) {
+        while (!stack.empty() && priorities_[stack.back()] < priorities_[i]) {
+            stack.pop_back();
+        }
+
+        if (!stack.empty()) {
+            left_blockers_[i] = stack.back();
+        }
+
+        stack.push_back(i);
+    }
+
+    stack.clear();
+    for (size_t i = items.size() - 1; i < items.size(); --i) {
+        while (!stack.empty() && priorities_[stack.back()] <= priorities_[i]) {
+            stack.pop_back();
+        }
+
+        if (!stack.empty()) {
+            right_blockers_[i] = stack.back();
+        }
+
+        stack.push_back(i);
+    }
+}
+
+auto LayerBounds::left(size_t id) const -> Bound {
+    if (is_exact_) {
+        const auto blocker = left_blockers_[id];
+
+        if (blocker != NO_BLOCKER) {
+            return {.blocker = blocker,
+                    .offset  = static_cast<float>(prefix_widths_[id] -
+                                                 prefix_widths_[blocker])};
+        }
+
+        return {.blocker = NO_BLOCKER,
+                .offset  = static_cast<float>(prefix_widths_[id] +
+                                             left_gutters_[id])};
+    }
+
+    auto w = 0.0F;
+
+    for (size_t i = id - 1; i < id; --i) {
+        w += widths_[i];
+
+        // Nodes are laid out left to right so we also care about equal
+        // priority nodes
+        if (priorities_[i] >= priorities_[id]) {
+            return {.blocker = i, .offset = w};
+        }
+    }
+    // The left gutter of this block
+    w += left_gutters_[id];
+
+    return {.blocker = NO_BLOCKER, .offset = w};
+}
+
+auto LayerBounds::right(size_t id) const -> Bound {
+    if (is_exact_) {
+        const auto blocker = right_blockers_[id];
+        const auto end     = blocker != NO_BLOCKER ? prefix_widths_[blocker]
+                                                   : prefix_widths_.back();
+
+        return {.blocker = blocker,
+                .offset  = static_cast<float>(
+                    rights_[id] + (end - prefix_widths_[id + 1]))};
+    }
+
+    auto w = rights_[id];
+
+    for (size_t i = id + 1; i < widths_.size(); ++i) {
+        // Nodes are laid out left to right so we only care about higher
+        // priority nodes
+        if (priorities_[i] > priorities_[id]) {
+            return {.blocker = i, .offset = w};
+        }
+
+        w += widths_[i];
+    }
+
+    return {.blocker = NO_BLOCKER, .offset = w};
+}
@@ -3,6 +3,8 @@
 
 #include <algorithm>
 #include <cassert>
+#include <chrono>
+#include <cmath>
 #include <cstddef>
 #include <cstdint>
 #include <cstdio>
@@ -10,8 +12,12 @@
 #include <iterator>
 #include <limits>
 #include <map>
+#include <memory_resource>
+#include <numeric>
 #include <ranges>
+#include <span>
 #include <stack>
+#include <utility>
 #include <vector>
 
 #include <fmt/core.h>
@@ -19,10 +25,15 @@
 
 #include "triskel/analysis/dfs.hpp"
 #include "triskel/graph/igraph.hpp"
+#include "triskel/layout/context.hpp"
+#include "triskel/layout/options.hpp"
+#include "triskel/layout/sugiyama/brandes_kopf.hpp"
+#include "triskel/layout/sugiyama/layer_bounds.hpp"
 #include "triskel/layout/sugiyama/vertex_ordering.hpp"
 #include "triskel/utils/attribute.hpp"
 #include "triskel/utils/constants.hpp"
 #include "triskel/utils/point.hpp"
+#include "triskel/utils/waypoints.hpp"
 
 // NOLINTNEXTLINE(google-build-using-namespace)
 using namespace triskel;
@@ -84,7 +95,10 @@ SugiyamaAnalysis::SugiyamaAnalysis(IGraph& g,
                                    const EdgeAttribute<float>& start_x_offset,
                                    const EdgeAttribute<float>& end_x_offset,
                                    const std::vector<IOPair>& entries,
-                                   const std::vector<IOPair>& exits)
+                                   const std::vector<IOPair>& exits,
+                                   const LayoutOptions& options,
+                                   SugiyamaHints* hints,
+                                   const NodeAttribute<float>* order_seed)
     : layers_(g, 0),
       orders_(g, 0),
       waypoints_(g, {}),
@@ -99,19 +113,24 @@ SugiyamaAnalysis::SugiyamaAnalysis(IGraph& g,
       offsets_from_(g, 0.0F),
       edge_weights_(g, 1.0F),
       priorities_(g, 0),
+      hints_(hints),
+      order_seed_(order_seed),
+      node_segments_(g, NO_SEGMENT),
+      edge_segments_(g, NO_SEGMENT),
       entries(entries),
       exits(exits),
       start_x_offset_(start_x_offset),
       end_x_offset_(end_x_offset),
+      options_(options),
       g{g}
 
 {
-    auto& ge = g.editor();
-    ge.push();
+    auto frame = EditFrame{g.editor()};
 
     cycle_removal();
 
     layer_assignment();
+    options_.cancellation.throw_if_cancelled();
 
     slide_nodes();
 
@@ -121,15 +140,19 @@ SugiyamaAnalysis::SugiyamaAnalysis(IGraph& g,
 
     init_node_layers();
 
-    ge.push();
+    auto flipped = EditFrame{g.editor()};
     flip_edges();
 
     y_coordinate_assignment();
 
+    options_.cancellation.throw_if_cancelled();
+    const auto ordering_start = std::chrono::steady_clock::now();
     vertex_ordering();
+    ordering_time_ = std::chrono::steady_clock::now() - ordering_start;
 
     waypoint_creation();
 
+    options_.cancellation.throw_if_cancelled();
     x_coordinate_assignment();
 
     translate_waypoints();
@@ -137,9 +160,8 @@ SugiyamaAnalysis::SugiyamaAnalysis(IGraph& g,
     calculate_waypoints_y();
 
     height_ = compute_graph_height();
-    width_  = compute_graph_width();
 
-    ge.pop();
+    flipped.pop();
 
     make_io_waypoints();
 
@@ -147,7 +169,7 @@ SugiyamaAnalysis::SugiyamaAnalysis(IGraph& g,
 
     // Sets the edge waypoints
 
-    ge.pop();
+    frame.pop();
 
     // Fix the self loops
     draw_self_loops();
@@ -161,15 +183,10 @@ SugiyamaAnalysis::SugiyamaAnalysis(IGraph& g,
 
         auto& waypoints = waypoints_.get(eid);
 
-        waypoints.erase(waypoints.begin() + 3);
-        waypoints.erase(waypoints.begin() + 3);
-        // waypoints.erase(waypoints.begin() + 3);
-        // waypoints.erase(waypoints.begin() + 3);
-
-        waypoints.erase(waypoints.end() - 4);
-        waypoints.erase(waypoints.end() - 4);
-        // waypoints.erase(waypoints.end() - 4);
-        // waypoints.erase(waypoints.end() - 4);
+        // The edge wraps around with a segment: only the first and last
+        // turns are kept
+        assert(waypoints.size() == 12);
+        waypoints.erase(waypoints.begin() + 3, waypoints.end() - 3);
     }
 }
 
@@ -245,9 +262,21 @@ void SugiyamaAnalysis::cycle_removal() {
 }
 
 void SugiyamaAnalysis::layer_assignment() {
+    // The network simplex only looks at the edges
+    if (hints_ != nullptr && hints_->ranks.has_value()) {
+        layers_      = *hints_->ranks;
+        layer_count_ = hints_->rank_count;
+        return;
+    }
+
     auto layers  = network_simplex(g);
     layers_      = layers->layers;
     layer_count_ = layers->layer_count;
+
+    if (hints_ != nullptr) {
+        hints_->ranks      = layers_;
+        hints_->rank_count = layer_count_;
+    }
 }
 
 struct SlideCandidate {
@@ -424,6 +453,15 @@ void SugiyamaAnalysis::remove_long_edges() {
 
         auto previous_point = bottom;
         for (size_t layer = bottom_layer + 1; layer < top_layer; layer++) {
+            // Only the two ends of a long edge get a waypoint, the layers in
+            // between are crossed by a segment
+            const auto is_segment =
+                (layer == bottom_layer + 2) &&
+                (top_layer - bottom_layer >= MIN_SEGMENT_SPAN);
+            if (is_segment) {
+                layer = top_layer - 1;
+            }
+
             auto waypoint = create_ghost_node(layer);
 
             auto new_edge = ge.make_edge(waypoint, previous_point);
@@ -432,6 +470,18 @@ void SugiyamaAnalysis::remove_long_edges() {
                 edge_weights_.set(new_edge, 0);
             }
 
+            if (is_segment) {
+                const auto segment = segments_.size();
+                segments_.push_back({.edge  = new_edge.id(),
+                                     .upper = waypoint.id(),
+                                     .lower = previous_point.id(),
+                                     .x     = 0.0F});
+
+                node_segments_.set(waypoint, segment);
+                node_segments_.set(previous_point, segment);
+                edge_segments_.set(new_edge, segment);
+            }
+
             previous_point = waypoint;
         }
 
@@ -451,9 +501,60 @@ void SugiyamaAnalysis::remove_long_edges() {
     }
 }
 
+auto SugiyamaAnalysis::layer_snapshot() const -> std::vector<size_t> {
+    auto layers = std::vector<size_t>{};
+    layers.reserve(g.node_count() + 1);
+
+    // The long edges were split according to the layers, the same layers
+    // give the same graph
+    layers.push_back(g.edge_count());
+    for (const auto& node : g.nodes()) {
+        layers.push_back(layers_.get(node));
+    }
+
+    return layers;
+}
+
 void SugiyamaAnalysis::vertex_ordering() {
-    auto ordering = VertexOrdering(g, layers_, layer_count_);
-    orders_       = ordering.orders_;
+    if (hints_ == nullptr) {
+        auto ordering =
+            VertexOrdering(g, layers_, layer_count_, options_.ordering,
+                           order_seed_, options_.warm_start_max_shift,
+                           options_.deadline, &options_.cancellation);
+        truncated_ |= ordering.truncated_;
+        orders_ = std::move(ordering.orders_);
+        apply_ordering(ordering.layer_slots_);
+        return;
+    }
+
+    // The ordering only looks at the edges and the layers
+    auto layers = layer_snapshot();
+    if (!hints_->orders.has_value() || hints_->ordered_layers != layers) {
+        auto ordering =
+            VertexOrdering(g, layers_, layer_count_, options_.ordering,
+                           order_seed_, options_.warm_start_max_shift,
+                           options_.deadline, &options_.cancellation);
+
+        // A truncated order is not worth reusing
+        if (ordering.truncated_) {
+            truncated_ = true;
+            hints_->orders.reset();
+            orders_ = std::move(ordering.orders_);
+            apply_ordering(ordering.layer_slots_);
+            return;
+        }
+
+        hints_->ordered_layers = std::move(layers);
+        hints_->orders         = std::move(ordering.orders_);
+        hints_->layer_slots    = std::move(ordering.layer_slots_);
+    }
+
+    orders_ = *hints_->orders;
+    apply_ordering(hints_->layer_slots);
+}
+
+void SugiyamaAnalysis::apply_ordering(
+    const std::vector<std::vector<VertexOrdering::Slot>>& layer_slots) {
     for (size_t l = 0; l < layer_count_; ++l) {
         auto& nodes = node_layers_[l];
 
@@ -461,8 +562,225 @@ void SugiyamaAnalysis::vertex_ordering() {
             return orders_.get(a) < orders_.get(b);
         });
     }
+
+    layer_items_.clear();
+    layer_items_.resize(layer_count_);
+
+    for (size_t l = 0; l < layer_count_; ++l) {
+        auto& items = layer_items_[l];
+        items.reserve(layer_slots[l].size());
+
+        for (const auto& slot : layer_slots[l]) {
+            if (slot.node == NodeId::InvalidID) {
+                items.push_back(
+                    {.node = slot.node, .segment = edge_segments_.get(slot.edge)});
+            } else {
+                items.push_back(
+                    {.node = slot.node, .segment = node_segments_.get(slot.node)});
+            }
+
+            assert(items.back().segment != NO_SEGMENT ||
+                   slot.node != NodeId::InvalidID);
+        }
+    }
+
+    // The position of the segments on the layers they cross
+    segment_offsets_.assign(segments_.size() + 1, 0);
+    for (size_t s = 0; s < segments_.size(); ++s) {
+        const auto& segment     = segments_[s];
+        segment_offsets_[s + 1] = segment_offsets_[s] +
+                                  layers_.get(segment.upper) -
+                                  layers_.get(segment.lower) + 1;
+    }
+
+    segment_indexes_.assign(segment_offsets_.back(), 0);
+    for (size_t l = 0; l < layer_count_; ++l) {
+        const auto& items = layer_items_[l];
+
+        for (size_t i = 0; i < items.size(); ++i) {
+            const auto segment = items[i].segment;
+            if (segment == NO_SEGMENT) {
+                continue;
+            }
+
+            const auto lower_layer = layers_.get(segments_[segment].lower);
+            segment_indexes_[segment_offsets_[segment] + l - lower_layer] = i;
+        }
+    }
 };
 
+auto SugiyamaAnalysis::item_x(const LayerItem& item) -> float {
+    if (item.segment != NO_SEGMENT) {
+        return segments_[item.segment].x;
+    }
+
+    return xs_.get(item.node);
+}
+
+auto SugiyamaAnalysis::item_width(const LayerItem& item) -> float {
+    if (item.node == NodeId::InvalidID) {
+        return WAYPOINT_WIDTH;
+    }
+
+    return widths_.get(item.node);
+}
+
+auto SugiyamaAnalysis::item_padding(const LayerItem& item) -> Padding {
+    if (item.node == NodeId::InvalidID) {
+        return Padding::horizontal(X_GUTTER);
+    }
+
+    return paddings_.get(item.node);
+}
+
+auto SugiyamaAnalysis::item_priority(const LayerItem& item) -> uint8_t {
+    if (item.segment != NO_SEGMENT) {
+        return SEGMENT_PRIORITY;
+    }
+
+    return priorities_.get(item.node);
+}
+
+void SugiyamaAnalysis::set_segment_x(size_t segment, float x) {
+    auto& s = segments_[segment];
+    s.x     = x;
+    xs_.set(s.upper, x);
+    xs_.set(s.lower, x);
+}
+
+auto SugiyamaAnalysis::init_x_coordinates() -> float {
+    // The next item to place on each layer
+    auto cursors = std::vector<size_t>(layer_count_, 0);
+
+    // The number of layers waiting on each segment
+    auto arrivals = std::vector<size_t>(segments_.size(), 0);
+
+    // Where the item at the cursor can start, ignoring its left gutter
+    auto left_bound = [&](size_t layer) {
+        const auto cursor = cursors[layer];
+        if (cursor == 0) {
+            return 0.0F;
+        }
+
+        const auto& left = layer_items_[layer][cursor - 1];
+        return item_x(left) + (item_width(left) + item_padding(left).right);
+    };
+
+    auto layers = std::vector<size_t>(layer_count_);
+    std::iota(layers.begin(), layers.end(), 0);
+
+    // Layers are packed from left to right, a segment is placed once it is
+    // the next item of every layer it crosses
+    while (!layers.empty()) {
+        const auto layer = layers.back();
+        layers.pop_back();
+
+        const auto& items = layer_items_[layer];
+        while (cursors[layer] < items.size()) {
+            const auto& item = items[cursors[layer]];
+
+            if (item.segment == NO_SEGMENT) {
+                xs_.set(item.node,
+                        left_bound(layer) + item_padding(item).left);
+                cursors[layer]++;
+                continue;
+            }
+
+            const auto segment     = item.segment;
+            const auto lower_layer = layers_.get(segments_[segment].lower);
+            const auto span =
+                segment_offsets_[segment + 1] - segment_offsets_[segment];
+
+            arrivals[segment]++;
+            if (arrivals[segment] < span) {
+                // Waits for the other layers
+                break;
+            }
+
+            auto x = 0.0F;
+            for (size_t l = lower_layer; l < lower_layer + span; ++l) {
+                x = std::max(x, left_bound(l) + item_padding(item).left);
+            }
+            set_segment_x(segment, x);
+
+            for (size_t l = lower_layer; l < lower_layer + span; ++l) {
+                cursors[l]++;
+                if (l != layer) {
+                    layers.push_back(l);
+                }
+            }
+        }
+    }
+
+    auto graph_width = compute_graph_width();
+
+    // Segments can push nodes further than the widest layer
+    if (!segments_.empty()) {
+        for (size_t l = 0; l < layer_count_; ++l) {
+            assert(cursors[l] == layer_items_[l].size());
+            graph_width = std::max(graph_width, left_bound(l));
+        }
+    }
+
+    return graph_width;
+}
+
+void SugiyamaAnalysis::place_segments(float graph_width) {
+    for (size_t s = 0; s < segments_.size(); ++s) {
+        const auto& segment = segments_[s];
+
+        const auto upper_layer = layers_.get(segment.upper);
+        const auto lower_layer = layers_.get(segment.lower);
+
+        // The segment is pulled by the nodes at its two ends
+        auto n = 0.0F;
+        auto d = 0.0F;
+        for (const auto avg :
+             {average_position(g.get_node(segment.upper), upper_layer + 1,
+                               false),
+              average_position(g.get_node(segment.lower), lower_layer - 1,
+                               true)}) {
+            if (avg >= 0) {
+                n += avg;
+                d += 1.0F;
+            }
+        }
+
+        if (d == 0.0F) {
+            continue;
+        }
+
+        const auto padding = Padding::horizontal(X_GUTTER);
+
+        auto lo = padding.left;
+        auto hi = graph_width - (WAYPOINT_WIDTH + padding.right);
+
+        for (size_t l = lower_layer; l <= upper_layer; ++l) {
+            const auto& items = layer_items_[l];
+            const auto i = segment_indexes_[segment_offsets_[s] + l - lower_layer];
+
+            if (i > 0) {
+                const auto& left = items[i - 1];
+                lo = std::max(lo, item_x(left) + (item_width(left) +
+                                                  item_padding(left).right) +
+                                      padding.left);
+            }
+
+            if (i + 1 < items.size()) {
+                const auto& right = items[i + 1];
+                hi = std::min(hi, item_x(right) - item_padding(right).left -
+                                      (WAYPOINT_WIDTH + padding.right));
+            }
+        }
+
+        if (lo > hi) {
+            continue;
+        }
+
+        set_segment_x(s, std::clamp(n / d, lo, hi));
+    }
+}
+
 auto SugiyamaAnalysis::get_priority(const Node& node, size_t layer) -> size_t {
     if (std::ranges::contains(dummy_nodes_, node.id())) {
         return -1;
@@ -476,42 +794,51 @@ auto SugiyamaAnalysis::get_priority(const Node& node, size_t layer) -> size_t {
               [&](const Node& n) { return layers_.get(n) == layer; }));
 }
 
-auto SugiyamaAnalysis::min_x(std::vector<Node>& nodes, size_t id) -> float {
-    auto priority = priorities_.get(nodes[id]);
-    auto w        = 0.0F;
+void SugiyamaAnalysis::init_layer_bounds() {
+    layer_bounds_.clear();
+    layer_bounds_.reserve(layer_count_);
 
-    for (size_t i = id - 1; i < id; --i) {
-        w += widths_.get(nodes[i]) + paddings_.get(nodes[i]).width();
+    auto bound_items = std::vector<LayerBounds::Item>{};
 
-        // Nodes are laid out left to right so we also care about equal
-        // priority nodes
-        if (priorities_.get(nodes[i]) >= priority) {
-            return xs_.get(nodes[i]) + w;
+    for (size_t layer = 0; layer < layer_count_; ++layer) {
+        bound_items.clear();
+
+        for (const auto& item : layer_items_[layer]) {
+            const auto padding = item_padding(item);
+            bound_items.push_back({.width        = item_width(item),
+                                   .left_gutter  = padding.left,
+                                   .right_gutter = padding.right,
+                                   .priority     = item_priority(item)});
         }
+
+        layer_bounds_.emplace_back(bound_items);
+    }
+}
+
+auto SugiyamaAnalysis::min_x(size_t layer,
+                             std::vector<LayerItem>& items,
+                             size_t id) -> float {
+    const auto bound = layer_bounds_[layer].left(id);
+
+    if (bound.blocker == LayerBounds::NO_BLOCKER) {
+        return bound.offset;
     }
-    // The left gutter of this block
-    w += paddings_.get(nodes[id]).left;
 
-    return w;
+    return item_x(items[bound.blocker]) + bound.offset;
 }
 
-auto SugiyamaAnalysis::max_x(std::vector<Node>& nodes,
+auto SugiyamaAnalysis::max_x(size_t layer,
+                             std::vector<LayerItem>& items,
                              size_t id,
                              float graph_width) -> float {
-    auto priority = priorities_.get(nodes[id]);
-    auto w        = widths_.get(nodes[id]) + paddings_.get(nodes[id]).right;
-
-    for (size_t i = id + 1; i < nodes.size(); ++i) {
-        // Nodes are laid out left to right so we only care about higher
-        // priority nodes
-        if (priorities_.get(nodes[i]) > priority) {
-            return xs_.get(nodes[i]) - w;
-        }
+    const auto bound = layer_bounds_[layer].right(id);
 
-        w += widths_.get(nodes[i]) + paddings_.get(nodes[i]).width();
+    if (bound.blocker == LayerBounds::NO_BLOCKER) {
+        assert(graph_width >= bound.offset);
+        return graph_width - bound.offset;
     }
-    assert(graph_width >= w);
-    return graph_width - w;
+
+    return item_x(items[bound.blocker]) - bound.offset;
 }
 
 auto SugiyamaAnalysis::average_position(const Node& node,
@@ -547,23 +874,28 @@ auto SugiyamaAnalysis::average_position(const Node& node,
 void SugiyamaAnalysis::coordinate_assignment_iteration(size_t layer,
                                                        size_t next_layer,
                                                        float graph_width) {
-    auto nodes = node_layers_[layer];
+    auto& items = layer_items_[layer];
 
     auto sorted_indexes =
-        std::views::iota(static_cast<size_t>(0), nodes.size()) |
-        std::ranges::to<std::vector<size_t>>();
+        std::pmr::vector<size_t>(items.size(), 0, scratch_resource());
+    std::iota(sorted_indexes.begin(), sorted_indexes.end(), 0);
 
     std::ranges::sort(sorted_indexes, [&](size_t a, size_t b) {
-        auto pa = priorities_.get(nodes[a]);
-        auto pb = priorities_.get(nodes[b]);
+        auto pa = item_priority(items[a]);
+        auto pb = item_priority(items[b]);
         return (pa > pb);
     });
 
     for (auto i : sorted_indexes) {
-        const auto& node = nodes[i];
+        // Segments are placed with `place_segments`
+        if (items[i].segment != NO_SEGMENT) {
+            continue;
+        }
+
+        const auto& node = g.get_node(items[i].node);
 
-        auto lo = min_x(nodes, i);
-        auto hi = max_x(nodes, i, graph_width);
+        auto lo = min_x(layer, items, i);
+        auto hi = max_x(layer, items, i, graph_width);
 
         if (std::abs(hi - lo) < 0.01) {
             hi = lo;
@@ -593,11 +925,11 @@ void SugiyamaAnalysis::coordinate_assignment_iteration(size_t layer,
 auto SugiyamaAnalysis::compute_graph_width() -> float {
     auto graph_width = 0.0F;
 
-    for (const auto& layer : node_layers_) {
+    for (const auto& layer : layer_items_) {
         auto layer_width = 0.0F;
 
-        for (const auto& node : layer) {
-            layer_width += widths_.get(node) + paddings_.get(node).width();
+        for (const auto& item : layer) {
+            layer_width += item_width(item) + item_padding(item).width();
         }
 
         graph_width = std::max(graph_width, layer_width);
@@ -606,6 +938,23 @@ auto SugiyamaAnalysis::compute_graph_width() -> float {
     return graph_width;
 }
 
+auto SugiyamaAnalysis::compute_graph_extent() -> float {
+    auto graph_width = 0.0F;
+
+    for (const auto& node : g.nodes()) {
+        graph_width = std::max(graph_width, xs_.get(node) + widths_.get(node) +
+                                                paddings_.get(node).right);
+    }
+
+    return graph_width;
+}
+
+auto SugiyamaAnalysis::gap_edge_count(const Node& node) -> size_t {
+    return std::ranges::count_if(node.child_edges(), [&](const Edge& edge) {
+        return edge_segments_.get(edge) == NO_SEGMENT;
+    });
+}
+
 auto SugiyamaAnalysis::get_graph_width() const -> float {
     return width_;
 }
@@ -636,8 +985,7 @@ auto SugiyamaAnalysis::compute_graph_height() -> float {
             layer_height =
                 std::max(layer_height,
                          heights_.get(node) + paddings_.get(node).height());
-            layer_gap +=
-                static_cast<float>(node.child_edges().size()) * EDGE_HEIGHT;
+            layer_gap += static_cast<float>(gap_edge_count(node)) * EDGE_HEIGHT;
         }
 
         if (layer_gap == 2.0F * Y_GUTTER) {
@@ -656,29 +1004,28 @@ auto SugiyamaAnalysis::compute_graph_height() -> float {
 }
 
 void SugiyamaAnalysis::x_coordinate_assignment() {
-    auto priorities = NodeAttribute<size_t>{g.max_node_id(), 0};
+    if (options_.coordinates == LayoutOptions::Coordinates::BrandesKopf) {
+        brandes_kopf_assignment();
+        width_ = compute_graph_extent();
+        return;
+    }
 
-    const float graph_width = compute_graph_width();
+    init_layer_bounds();
 
-    // Init X coordinates
-    for (size_t layer = 0; layer < layer_count_; ++layer) {
-        auto nodes = node_layers_[layer];
+    const float graph_width = init_x_coordinates();
+    width_                  = graph_width;
 
-        std::ranges::sort(nodes, [&](const Node& a, const Node& b) {
-            return orders_.get(a) < orders_.get(b);
-        });
-
-        auto x = 0.0F;
+    for (size_t i = 0; i < 5; ++i) {
+        options_.cancellation.throw_if_cancelled();
 
-        for (const auto& node : nodes) {
-            auto& padding = paddings_.get(node);
-            x += padding.left;
-            xs_.set(node, x);
-            x += widths_.get(node) + padding.right;
+        // Each round trip leaves valid coordinates
+        if (i > 0 && options_.is_past_deadline()) {
+            truncated_ = true;
+            break;
         }
-    }
 
-    for (size_t i = 0; i < 5; ++i) {
+        place_segments(graph_width);
+
         for (size_t r = 0 + 1; r < layer_count_; ++r) {
             coordinate_assignment_iteration(r, r - 1, graph_width);
         }
@@ -688,11 +1035,88 @@ void SugiyamaAnalysis::x_coordinate_assignment() {
         }
     }
 
+    place_segments(graph_width);
+
     for (size_t r = 0 + 1; r < layer_count_; ++r) {
         coordinate_assignment_iteration(r, r - 1, graph_width);
     }
 }
 
+void SugiyamaAnalysis::brandes_kopf_assignment() {
+    auto graph   = BKGraph{};
+    auto indexes = NodeAttribute<size_t>{g.max_node_id(), 0};
+
+    // The BK node of each slot of the segments
+    auto slots = std::vector<size_t>(segment_offsets_.back(), 0);
+
+    // The highest layer is on top
+    for (size_t layer = layer_count_ - 1; layer < layer_count_; --layer) {
+        auto& indexes_layer = graph.layers.emplace_back();
+
+        for (const auto& item : layer_items_[layer]) {
+            const auto padding = item_padding(item);
+
+            if (item.node != NodeId::InvalidID) {
+                indexes.set(item.node, graph.nodes.size());
+            }
+
+            if (item.segment != NO_SEGMENT) {
+                const auto lower_layer =
+                    layers_.get(segments_[item.segment].lower);
+                slots[segment_offsets_[item.segment] + layer - lower_layer] =
+                    graph.nodes.size();
+            }
+
+            indexes_layer.push_back(graph.nodes.size());
+
+            graph.nodes.push_back({.width        = item_width(item),
+                                   .left_gutter  = padding.left,
+                                   .right_gutter = padding.right,
+                                   .is_dummy = item.segment != NO_SEGMENT});
+        }
+    }
+
+    // Segments are a chain of dummy nodes
+    for (size_t s = 0; s < segments_.size(); ++s) {
+        for (size_t i = segment_offsets_[s] + 1; i < segment_offsets_[s + 1];
+             ++i) {
+            graph.segments.push_back({.upper        = slots[i],
+                                      .lower        = slots[i - 1],
+                                      .upper_port   = 0.0F,
+                                      .lower_port   = 0.0F,
+                                      .is_alignable = true});
+        }
+    }
+
+    for (const auto& edge : g.edges()) {
+        if (edge_segments_.get(edge) != NO_SEGMENT) {
+            continue;
+        }
+
+        assert(layers_.get(edge.from()) == layers_.get(edge.to()) + 1);
+
+        // The waypoints still hold the offsets of the edge on each node
+        const auto& waypoints = waypoints_.get(edge);
+
+        graph.segments.push_back(
+            {.upper        = indexes.get(edge.from()),
+             .lower        = indexes.get(edge.to()),
+             .upper_port   = waypoints[1].x,
+             .lower_port   = waypoints[2].x,
+             .is_alignable = edge_weights_.get(edge) > 0.0F});
+    }
+
+    const auto xs = brandes_kopf(graph);
+
+    for (const auto& node : g.nodes()) {
+        xs_.set(node, xs[indexes.get(node)]);
+    }
+
+    for (size_t s = 0; s < segments_.size(); ++s) {
+        segments_[s].x = xs[slots[segment_offsets_[s]]];
+    }
+}
+
 auto SugiyamaAnalysis::get_x(NodeId node) const -> float {
     return xs_.get(node);
 }
@@ -708,9 +1132,8 @@ auto SugiyamaAnalysis::get_height(NodeId node) const -> float {
     return heights_.get(node);
 }
 
-auto SugiyamaAnalysis::get_waypoints(EdgeId edge) const
-    -> const std::vector<Point>& {
-    return waypoints_.get(edge);
+auto SugiyamaAnalysis::get_waypoints(EdgeId edge) const -> WaypointsView {
+    return std::span<const Point>{waypoints_.get(edge)};
 }
 
 // TODO: it's kind of odd that the xs are offsets and ys are coords
@@ -954,6 +1377,14 @@ void SugiyamaAnalysis::calculate_waypoints_y() {
 
         for (const auto& node : node_layers_[layer]) {
             for (const auto& edge : node.child_edges()) {
+                if (edge_segments_.get(edge) != NO_SEGMENT) {
+                    // Segments are straight
+                    auto& waypoints = waypoints_.get(edge);
+                    waypoints[1].y  = waypoints[0].y;
+                    waypoints[2].y  = waypoints[0].y;
+                    continue;
+                }
+
                 edges.push_back(edge);
             }
         }
@@ -1021,8 +1452,7 @@ void SugiyamaAnalysis::y_coordinate_assignment() {
         for (const auto& node : nodes) {
             ys_.set(node, y);
             layer_height = std::max(layer_height, heights_.get(node));
-            layer_gap +=
-                static_cast<float>(node.child_edges().size()) * EDGE_HEIGHT;
+            layer_gap += static_cast<float>(gap_edge_count(node)) * EDGE_HEIGHT;
         }
 
         if (layer_gap == 2.0F * Y_GUTTER) {
@@ -3,19 +3,39 @@
 #include <algorithm>
 #include <cassert>
 #include <cstddef>
+#include <cmath>
 #include <cstdint>
+#include <functional>
+#include <limits>
+#include <memory_resource>
+#include <numeric>
 #include <ranges>
+#include <span>
 #include <utility>
 #include <vector>
 
-#include "triskel/graph/graph_view.hpp"
 #include "triskel/graph/igraph.hpp"
+#include "triskel/layout/context.hpp"
+#include "triskel/layout/options.hpp"
 #include "triskel/utils/attribute.hpp"
 
 // NOLINTNEXTLINE(google-build-using-namespace)
 using namespace triskel;
 
 namespace {
+/// @brief Upper bound on the number of down and up sifting sweeps
+constexpr size_t MAX_SIFTING_PASSES = 8;
+
+// The 24 comes from
+// https://blog.disy.net/sugiyama-method/
+constexpr size_t MEDIAN_ITERATIONS = 24;
+
+/// @brief The number of median iterations refining a previous order
+constexpr size_t SEEDED_MEDIAN_ITERATIONS = 4;
+
+/// @brief The number of median iterations seeding the sifting
+constexpr size_t SIFTING_MEDIAN_ITERATIONS = 4;
+
 [[nodiscard]] auto merge_and_count(std::vector<size_t>& lo,
                                    std::vector<size_t>& hi) -> size_t {
     size_t inversions = 0;
@@ -35,13 +55,15 @@ namespace {
     return inversions;
 }
 
-[[nodiscard]] auto merge_and_count(std::vector<size_t>& arr,
+[[nodiscard]] auto merge_and_count(std::pmr::vector<size_t>& arr,
                                    int64_t lo,
                                    int64_t mid,
                                    int64_t hi) -> size_t {
-    auto lo_arr = std::vector<size_t>{arr.begin() + lo, arr.begin() + mid};
+    auto lo_arr = std::pmr::vector<size_t>{arr.begin() + lo, arr.begin() + mid,
+                                           scratch_resource()};
 
-    auto hi_arr = std::vector<size_t>{arr.begin() + mid, arr.begin() + hi};
+    auto hi_arr = std::pmr::vector<size_t>{arr.begin() + mid, arr.begin() + hi,
+                                           scratch_resource()};
 
     auto lo_sz = mid - lo;
     auto hi_sz = hi - mid;
@@ -77,7 +99,7 @@ namespace {
 }
 
 // NOLINTNEXTLINE(misc-no-recursion)
-[[nodiscard]] auto sort_and_count(std::vector<size_t>& arr,
+[[nodiscard]] auto sort_and_count(std::pmr::vector<size_t>& arr,
                                   int64_t lo,
                                   int64_t hi) -> size_t {
     size_t inversions = 0;
@@ -95,66 +117,465 @@ namespace {
 
 VertexOrdering::VertexOrdering(const IGraph& g,
                                const NodeAttribute<size_t>& layers,
-                               size_t layer_count_)
-    : orders_(g, -1), g_{g}, layers_(layers) {
+                               size_t layer_count_,
+                               LayoutOptions::Ordering strategy,
+                               const NodeAttribute<float>* seed,
+                               size_t max_shift,
+                               LayoutOptions::Clock::time_point deadline,
+                               const CancellationToken* cancellation)
+    : orders_(g, -1),
+      max_shift_{max_shift},
+      deadline_{deadline},
+      cancellation_{cancellation} {
     node_layers_.resize(layer_count_);
-    for (const auto& node : g_.nodes()) {
-        node_layers_[layers_.get(node)].push_back(&node);
+    make_slots(g, layers);
+
+    if (seed != nullptr) {
+        seed_order(*seed);
+    }
+
+    switch (strategy) {
+        case LayoutOptions::Ordering::MedianTranspose:
+            median_transpose(MEDIAN_ITERATIONS);
+            break;
+
+        case LayoutOptions::Ordering::Sifting:
+            sifting();
+            break;
+    }
+
+    save_layers();
+}
+
+void VertexOrdering::make_slots(const IGraph& g,
+                                const NodeAttribute<size_t>& layers) {
+    auto node_slots = NodeAttribute<size_t>{g, 0};
+
+    for (const auto& node : g.nodes()) {
+        node_slots.set(node, slot_nodes_.size());
+        slot_nodes_.push_back(node.id());
+        slot_edges_.push_back(EdgeId::InvalidID);
+        slot_layers_.push_back(layers.get(node));
     }
 
+    slot_segments_.assign(slot_nodes_.size(), NO_SEGMENT);
+
+    // (parent, child) pairs
+    auto links = std::vector<std::pair<size_t, size_t>>{};
+    links.reserve(g.edge_count());
+
+    for (const auto& edge : g.edges()) {
+        const auto from = node_slots.get(edge.from());
+        const auto to   = node_slots.get(edge.to());
+
+        const auto from_layer = slot_layers_[from];
+        const auto to_layer   = slot_layers_[to];
+
+        if (std::max(from_layer, to_layer) - std::min(from_layer, to_layer) <=
+            1) {
+            links.emplace_back(from, to);
+            continue;
+        }
+
+        // The edge is a segment: it crosses the layers between its two ends
+        const auto segment = segment_count_++;
+
+        for (auto slot : {from, to}) {
+            if (slot_segments_[slot] == NO_SEGMENT) {
+                slot_segments_[slot] = segment;
+            }
+        }
+
+        auto previous = from;
+        auto layer    = from_layer;
+        while (true) {
+            layer = from_layer > to_layer ? layer - 1 : layer + 1;
+            if (layer == to_layer) {
+                break;
+            }
+
+            const auto slot = slot_nodes_.size();
+            slot_nodes_.push_back(NodeId::InvalidID);
+            slot_edges_.push_back(edge.id());
+            slot_layers_.push_back(layer);
+            slot_segments_.push_back(segment);
+
+            links.emplace_back(previous, slot);
+            previous = slot;
+        }
+
+        links.emplace_back(previous, to);
+    }
+
+    const auto slot_count = slot_nodes_.size();
+    slot_orders_.assign(slot_count, -1);
+
+    for (size_t slot = 0; slot < slot_count; ++slot) {
+        node_layers_[slot_layers_[slot]].push_back(slot);
+    }
+
+    parent_offsets_.assign(slot_count + 1, 0);
+    child_offsets_.assign(slot_count + 1, 0);
+    for (const auto& [parent, child] : links) {
+        parent_offsets_[child + 1]++;
+        child_offsets_[parent + 1]++;
+    }
+
+    for (size_t slot = 0; slot < slot_count; ++slot) {
+        parent_offsets_[slot + 1] += parent_offsets_[slot];
+        child_offsets_[slot + 1] += child_offsets_[slot];
+    }
+
+    parents_.resize(links.size());
+    children_.resize(links.size());
+
+    auto parent_cursor = parent_offsets_;
+    auto child_cursor  = child_offsets_;
+    for (const auto& [parent, child] : links) {
+        parents_[parent_cursor[child]++]  = parent;
+        children_[child_cursor[parent]++] = child;
+    }
+}
+
+auto VertexOrdering::parents(size_t slot) const -> std::span<const size_t> {
+    return std::span{parents_}.subspan(
+        parent_offsets_[slot], parent_offsets_[slot + 1] - parent_offsets_[slot]);
+}
+
+auto VertexOrdering::children(size_t slot) const -> std::span<const size_t> {
+    return std::span{children_}.subspan(
+        child_offsets_[slot], child_offsets_[slot + 1] - child_offsets_[slot]);
+}
+
+auto VertexOrdering::is_segment(size_t slot) const -> bool {
+    return slot_segments_[slot] != NO_SEGMENT;
+}
+
+void VertexOrdering::save_layers() {
+    layer_slots_.resize(node_layers_.size());
+
+    for (size_t l = 0; l < node_layers_.size(); ++l) {
+        auto& slots = node_layers_[l];
+
+        std::ranges::sort(slots, [this](size_t a, size_t b) {
+            return slot_orders_[a] < slot_orders_[b];
+        });
+
+        auto& layer = layer_slots_[l];
+        layer.clear();
+        layer.reserve(slots.size());
+
+        for (const auto slot : slots) {
+            if (slot_nodes_[slot] != NodeId::InvalidID) {
+                orders_.set(slot_nodes_[slot], layer.size());
+            }
+
+            layer.push_back(
+                {.node = slot_nodes_[slot], .edge = slot_edges_[slot]});
+        }
+    }
+}
+
+void VertexOrdering::seed_order(const NodeAttribute<float>& xs) {
+    auto keys = std::vector<float>(slot_nodes_.size(), NAN);
+    for (size_t slot = 0; slot < slot_nodes_.size(); ++slot) {
+        if (slot_nodes_[slot] != NodeId::InvalidID) {
+            keys[slot] = xs.get(slot_nodes_[slot]);
+        }
+    }
+
+    auto average = [&keys](std::span<const size_t> neighbors) {
+        auto sum   = 0.0F;
+        auto count = 0;
+        for (const auto neighbor : neighbors) {
+            if (!std::isnan(keys[neighbor])) {
+                sum += keys[neighbor];
+                count++;
+            }
+        }
+
+        return count == 0 ? NAN : sum / static_cast<float>(count);
+    };
+
+    // The new slots are placed under their parents, then above their children
+    for (const auto& slots : node_layers_) {
+        for (const auto slot : slots) {
+            if (std::isnan(keys[slot])) {
+                keys[slot] = average(parents(slot));
+            }
+        }
+    }
+
+    for (size_t l = node_layers_.size(); l-- > 0;) {
+        for (const auto slot : node_layers_[l]) {
+            if (std::isnan(keys[slot])) {
+                keys[slot] = average(children(slot));
+            }
+        }
+    }
+
+    for (auto& slots : node_layers_) {
+        // The remaining slots follow their left neighbor
+        auto previous = -std::numeric_limits<float>::infinity();
+        for (const auto slot : slots) {
+            if (std::isnan(keys[slot])) {
+                keys[slot] = previous;
+            }
+
+            previous = keys[slot];
+        }
+
+        std::ranges::stable_sort(slots, std::ranges::less{},
+                                 [&keys](size_t slot) { return keys[slot]; });
+
+        for (size_t i = 0; i < slots.size(); ++i) {
+            slot_orders_[slots[i]] = i;
+        }
+    }
+
+    order_segments();
+    seed_orders_ = slot_orders_;
+}
+
+auto VertexOrdering::should_stop() -> bool {
+    if (cancellation_ != nullptr) {
+        cancellation_->throw_if_cancelled();
+    }
+
+    if (deadline_ == LayoutOptions::Clock::time_point::max() ||
+        LayoutOptions::Clock::now() < deadline_) {
+        return false;
+    }
+
+    truncated_ = true;
+    return true;
+}
+
+auto VertexOrdering::is_within_shift() const -> bool {
+    if (seed_orders_.empty() ||
+        max_shift_ == std::numeric_limits<size_t>::max()) {
+        return true;
+    }
+
+    for (size_t slot = 0; slot < slot_orders_.size(); ++slot) {
+        const auto shift = std::max(slot_orders_[slot], seed_orders_[slot]) -
+                           std::min(slot_orders_[slot], seed_orders_[slot]);
+        if (shift > max_shift_) {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+void VertexOrdering::median_transpose(size_t iterations) {
     normalize_order();
 
-    auto best        = orders_;
+    auto best        = slot_orders_;
     size_t crossings = -1;
 
-    // The 24 comes from
-    // https://blog.disy.net/sugiyama-method/
-    for (size_t i = 0; i < 24; ++i) {
+    // The previous order is the first candidate, it is improved by swapping
+    // neighbors before the median moves the nodes further
+    if (!seed_orders_.empty()) {
+        crossings  = count_crossings();
+        iterations = std::min(iterations, SEEDED_MEDIAN_ITERATIONS);
+
+        transpose();
+
+        const auto new_crossings = count_crossings();
+        if (new_crossings < crossings && is_within_shift()) {
+            best      = slot_orders_;
+            crossings = new_crossings;
+        }
+    }
+
+    for (size_t i = 0; i < iterations && crossings != 0; ++i) {
+        // The first iteration always runs, the initial order is random
+        if (i > 0 && should_stop()) {
+            break;
+        }
+
         median(i);
 
         normalize_order();
 
+        order_segments();
+
         transpose();
 
         const auto new_crossings = count_crossings();
-        if (new_crossings < crossings) {
-            best      = orders_;
+        if (new_crossings < crossings && is_within_shift()) {
+            best      = slot_orders_;
             crossings = new_crossings;
+        }
+    }
 
-            if (new_crossings == 0) {
-                break;
+    slot_orders_ = best;
+}
+
+// Based on "Using Sifting for k-Layer Straightline Crossing Minimization"
+// by Matuszewski et al.
+void VertexOrdering::sifting() {
+    // Sifting moves a single node at a time, on its own it gets stuck on the
+    // chains of long edge waypoints. It is seeded with a few iterations of the
+    // median heuristic rather than the full run
+    median_transpose(SIFTING_MEDIAN_ITERATIONS);
+
+    // Sorts the layers according to the best order
+    normalize_order();
+
+    auto crossings = count_crossings();
+
+    // Sifting a node never increases the number of crossings, the sweeps stop
+    // once they no longer improve the ordering
+    for (size_t pass = 0; pass < MAX_SIFTING_PASSES && crossings > 0; ++pass) {
+        if (should_stop()) {
+            break;
+        }
+
+        const auto before = slot_orders_;
+
+        for (size_t l = 0; l < node_layers_.size(); ++l) {
+            sift_layer(l);
+        }
+
+        for (size_t l = node_layers_.size(); l-- > 0;) {
+            sift_layer(l);
+        }
+
+        const auto new_crossings = count_crossings();
+        if (new_crossings >= crossings) {
+            break;
+        }
+
+        if (!is_within_shift()) {
+            slot_orders_ = before;
+            break;
+        }
+
+        crossings = new_crossings;
+    }
+}
+
+void VertexOrdering::sift_layer(size_t layer) {
+    auto& slots = node_layers_[layer];
+
+    if (slots.size() <= 1) {
+        return;
+    }
+
+    // The neighboring layers do not move while this layer is sifted, so the
+    // sorted neighbor orders of each node only need to be computed once
+    struct SiftedNode {
+        size_t slot;
+        std::vector<size_t> top;
+        std::vector<size_t> bottom;
+    };
+
+    auto sifted = std::vector<SiftedNode>{};
+    sifted.reserve(slots.size());
+    for (const auto slot : slots) {
+        auto& s =
+            sifted.emplace_back(SiftedNode{.slot = slot, .top = {}, .bottom = {}});
+        get_neighbor_orders(slot, s.top, s.bottom);
+    }
+
+    // Number of crossings between the edges of u and v when u is left of v
+    auto crossings = [&sifted](size_t u, size_t v) -> int64_t {
+        return static_cast<int64_t>(
+            merge_and_count(sifted[u].top, sifted[v].top) +
+            merge_and_count(sifted[u].bottom, sifted[v].bottom));
+    };
+
+    auto is_segment = [&](size_t i) { return this->is_segment(sifted[i].slot); };
+
+    // The layer, as indexes in `sifted`
+    auto order = std::vector<size_t>(sifted.size());
+    std::iota(order.begin(), order.end(), 0);
+
+    // Nodes with the most edges are sifted first
+    auto sift_order = order;
+    std::ranges::stable_sort(sift_order, std::ranges::greater{}, [&](size_t i) {
+        return sifted[i].top.size() + sifted[i].bottom.size();
+    });
+
+    // deltas[i] is the change in crossings when the sifted node is placed at
+    // index i, relative to it being placed first
+    auto deltas = std::pmr::vector<int64_t>{scratch_resource()};
+    deltas.reserve(sifted.size());
+
+    for (auto v : sift_order) {
+        auto it            = std::ranges::find(order, v);
+        const auto current = static_cast<size_t>(it - order.begin());
+        order.erase(it);
+
+        deltas.assign(1, 0);
+        for (auto w : order) {
+            // Moving v one step to the right swaps it with w
+            deltas.push_back(deltas.back() + crossings(w, v) - crossings(v, w));
+        }
+
+        // Segments stay between the segments around them
+        auto lo = static_cast<size_t>(0);
+        auto hi = order.size();
+        if (is_segment(v)) {
+            for (size_t i = current; i-- > 0;) {
+                if (is_segment(order[i])) {
+                    lo = i + 1;
+                    break;
+                }
+            }
+
+            for (size_t i = current; i < order.size(); ++i) {
+                if (is_segment(order[i])) {
+                    hi = i;
+                    break;
+                }
+            }
+        }
+
+        // Only move the node on strict improvements
+        auto best = current;
+        for (size_t i = lo; i <= hi; ++i) {
+            if (deltas[i] < deltas[best]) {
+                best = i;
             }
         }
+
+        order.insert(order.begin() + static_cast<int64_t>(best), v);
     }
 
-    orders_ = best;
+    for (size_t i = 0; i < order.size(); ++i) {
+        slots[i]             = sifted[order[i]].slot;
+        slot_orders_[slots[i]] = i;
+    }
 }
 
 void VertexOrdering::get_neighbor_orders(
-    const NodeView& n,
+    size_t slot,
     std::vector<size_t>& orders_top,
     std::vector<size_t>& orders_bottom) const {
-    for (const auto* child : n.child_nodes()) {
-        orders_bottom.push_back(orders_.get(*child));
+    for (const auto child : children(slot)) {
+        orders_bottom.push_back(slot_orders_[child]);
     }
 
-    for (const auto* parent : n.parent_nodes()) {
-        orders_top.push_back(orders_.get(*parent));
+    for (const auto parent : parents(slot)) {
+        orders_top.push_back(slot_orders_[parent]);
     }
 
     std::ranges::sort(orders_top);
     std::ranges::sort(orders_bottom);
 }
 
-auto VertexOrdering::count_crossings(const NodeView& node1,
-                                     const NodeView& node2) const -> size_t {
+auto VertexOrdering::count_crossings(size_t slot1, size_t slot2) const
+    -> size_t {
     orders_top1.clear();
     orders_top2.clear();
     orders_bottom1.clear();
     orders_bottom2.clear();
 
-    get_neighbor_orders(node1, orders_top1, orders_bottom1);
-    get_neighbor_orders(node2, orders_top2, orders_bottom2);
+    get_neighbor_orders(slot1, orders_top1, orders_bottom1);
+    get_neighbor_orders(slot2, orders_top2, orders_bottom2);
 
     return merge_and_count(orders_top1, orders_top2) +
            merge_and_count(orders_bottom1, orders_bottom2);
@@ -168,23 +589,28 @@ auto VertexOrdering::count_crossings_with_layer(size_t l1,
         return 0;
     }
 
-    assert(std::ranges::is_sorted(layer, [&](const auto* a, const auto* b) {
-        return orders_.get(*a) < orders_.get(*b);
+    assert(std::ranges::is_sorted(layer, [&](size_t a, size_t b) {
+        return slot_orders_[a] < slot_orders_[b];
     }));
 
-    // TODO: have a preallocated static vector
-    auto orders = std::vector<size_t>{};
+    auto orders = std::pmr::vector<size_t>{scratch_resource()};
     orders.reserve(2 * node_layers_[l2].size());  // heuristically
 
-    auto neighbors = std::vector<size_t>{};
+    auto neighbors = std::pmr::vector<size_t>{scratch_resource()};
     neighbors.reserve(node_layers_[l2].size());  // heuristically
 
-    for (const auto* node : layer) {
+    for (const auto slot : layer) {
         neighbors.clear();
 
-        for (const auto* child : node->neighbors()) {
-            if (layers_.get(*child) == l2) {
-                neighbors.push_back(orders_.get(*child));
+        for (const auto parent : parents(slot)) {
+            if (slot_layers_[parent] == l2) {
+                neighbors.push_back(slot_orders_[parent]);
+            }
+        }
+
+        for (const auto child : children(slot)) {
+            if (slot_layers_[child] == l2) {
+                neighbors.push_back(slot_orders_[child]);
             }
         }
 
@@ -206,63 +632,110 @@ auto VertexOrdering::count_crossings() -> size_t {
 }
 
 void VertexOrdering::normalize_order() {
-    for (auto& nodes : node_layers_) {
+    for (auto& slots : node_layers_) {
         // THIS IS IMPORTANT
-        std::ranges::shuffle(nodes, rng_);
+        std::ranges::shuffle(slots, rng_);
 
-        std::ranges::sort(nodes, [this](const auto* a, const auto* b) {
-            return orders_.get(*a) < orders_.get(*b);
+        std::ranges::sort(slots, [this](size_t a, size_t b) {
+            return slot_orders_[a] < slot_orders_[b];
         });
 
         auto order = 0;
 
-        for (const auto* node : nodes) {
-            orders_.set(*node, order);
+        for (const auto slot : slots) {
+            slot_orders_[slot] = order;
             order++;
         }
     }
 }
 
+void VertexOrdering::order_segments() {
+    if (segment_count_ == 0) {
+        return;
+    }
+
+    // The average order of the slots of each segment
+    auto sums   = std::vector<double>(segment_count_, 0.0);
+    auto counts = std::vector<size_t>(segment_count_, 0);
+
+    for (size_t slot = 0; slot < slot_orders_.size(); ++slot) {
+        if (is_segment(slot)) {
+            sums[slot_segments_[slot]] += static_cast<double>(slot_orders_[slot]);
+            counts[slot_segments_[slot]]++;
+        }
+    }
+
+    auto ranks = std::vector<size_t>(segment_count_);
+    {
+        auto segments = std::vector<size_t>(segment_count_);
+        std::iota(segments.begin(), segments.end(), 0);
+        std::ranges::stable_sort(segments, std::ranges::less{}, [&](size_t s) {
+            return sums[s] / static_cast<double>(counts[s]);
+        });
+
+        for (size_t rank = 0; rank < segments.size(); ++rank) {
+            ranks[segments[rank]] = rank;
+        }
+    }
+
+    // Redistributes the positions of the segments on each layer by rank
+    auto positions = std::vector<size_t>{};
+    auto members   = std::vector<size_t>{};
+
+    for (auto& slots : node_layers_) {
+        positions.clear();
+        members.clear();
+
+        for (size_t i = 0; i < slots.size(); ++i) {
+            if (is_segment(slots[i])) {
+                positions.push_back(i);
+                members.push_back(slots[i]);
+            }
+        }
+
+        std::ranges::sort(members, std::ranges::less{}, [&](size_t slot) {
+            return ranks[slot_segments_[slot]];
+        });
+
+        for (size_t i = 0; i < members.size(); ++i) {
+            slots[positions[i]]       = members[i];
+            slot_orders_[members[i]] = positions[i];
+        }
+    }
+}
+
 // TODO: this sucks
 void VertexOrdering::median(size_t iter) {
-    if (iter % 2 == 0) {
-        for (const auto& nodes : node_layers_) {
-            for (const auto* node : nodes) {
-                auto median_order = orders_.get(*node);
+    auto orders = std::pmr::vector<size_t>{scratch_resource()};
 
-                auto children =
-                    node->child_nodes() |
-                    std::ranges::views::transform(
-                        [&](const auto* node) { return orders_.get(*node); }) |
-                    std::ranges::to<std::vector<size_t>>();
+    if (iter % 2 == 0) {
+        for (const auto& slots : node_layers_) {
+            for (const auto slot : slots) {
+                orders.clear();
+                for (const auto child : children(slot)) {
+                    orders.push_back(slot_orders_[child]);
+                }
 
-                std::ranges::sort(children);
+                std::ranges::sort(orders);
 
-                if (!children.empty()) {
-                    median_order = children[children.size() / 2];
+                if (!orders.empty()) {
+                    slot_orders_[slot] = orders[orders.size() / 2];
                 }
-
-                orders_.set(*node, median_order);
             }
         }
     } else {
-        for (const auto& nodes : node_layers_) {
-            for (const auto* node : nodes) {
-                auto median_order = orders_.get(*node);
-
-                auto parents =
-                    node->parent_nodes() |
-                    std::ranges::views::transform(
-                        [&](const auto* node) { return orders_.get(*node); }) |
-                    std::ranges::to<std::vector<size_t>>();
+        for (const auto& slots : node_layers_) {
+            for (const auto slot : slots) {
+                orders.clear();
+                for (const auto parent : parents(slot)) {
+                    orders.push_back(slot_orders_[parent]);
+                }
 
-                std::ranges::sort(parents);
+                std::ranges::sort(orders);
 
-                if (!parents.empty()) {
-                    median_order = parents[parents.size() / 2];
+                if (!orders.empty()) {
+                    slot_orders_[slot] = orders[orders.size() / 2];
                 }
-
-                orders_.set(*node, median_order);
             }
         }
     }
@@ -273,17 +746,22 @@ void VertexOrdering::transpose() {
 
     while (improved) {
         improved = false;
-        for (auto& nodes : node_layers_) {
-            if (nodes.empty()) {
+        for (auto& slots : node_layers_) {
+            if (slots.empty()) {
                 continue;
             }
 
-            for (size_t i = 0; i < nodes.size() - 1; ++i) {
-                const auto* v = nodes[i];
-                const auto* w = nodes[i + 1];
+            for (size_t i = 0; i < slots.size() - 1; ++i) {
+                const auto v = slots[i];
+                const auto w = slots[i + 1];
 
-                const auto crossings     = count_crossings(*v, *w);
-                const auto new_crossings = count_crossings(*w, *v);
+                // Segments never cross each other
+                if (is_segment(v) && is_segment(w)) {
+                    continue;
+                }
+
+                const auto crossings     = count_crossings(v, w);
+                const auto new_crossings = count_crossings(w, v);
 
                 if (new_crossings <= crossings) {
                     if (new_crossings < crossings) {
@@ -291,13 +769,18 @@ void VertexOrdering::transpose() {
                     }
 
                     // Swap the node orders
-                    orders_.set(*v, i + 1);
-                    orders_.set(*w, i);
+                    slot_orders_[v] = i + 1;
+                    slot_orders_[w] = i;
 
                     // Swap the nodes to ensure the array remains sorted
-                    std::swap(nodes[i], nodes[i + 1]);
+                    std::swap(slots[i], slots[i + 1]);
                 }
             }
         }
+
+        // The layers stay sorted after each sweep
+        if (improved && should_stop()) {
+            break;
+        }
     }
-}
\ No newline at end of file
+}
@@ -0,0 +1,176 @@
+#include "triskel/layout/waypoint_buffer.hpp"
+
+#include <algorithm>
+#include <cassert>
+#include <cstddef>
+#include <limits>
+#include <span>
+#include <utility>
+#include <vector>
+
+#include "triskel/graph/igraph.hpp"
+#include "triskel/utils/point.hpp"
+#include "triskel/utils/waypoints.hpp"
+
+// NOLINTNEXTLINE(google-build-using-namespace)
+using namespace triskel;
+
+namespace {
+// The kernels work on plain float arrays so that the compiler can vectorize
+// them
+
+void add(std::span<float> values, float v) {
+    for (auto& value : values) {
+        value += v;
+    }
+}
+
+void multiply(std::span<float> values, float v) {
+    for (auto& value : values) {
+        value *= v;
+    }
+}
+
+auto min_max(std::span<const float> values) -> std::pair<float, float> {
+    auto lo = std::numeric_limits<float>::max();
+    auto hi = std::numeric_limits<float>::lowest();
+
+    for (auto value : values) {
+        lo = value < lo ? value : lo;
+        hi = value > hi ? value : hi;
+    }
+
+    return {lo, hi};
+}
+
+// Is `b` in the middle of a straight line from `a` to `c`
+auto is_between(Point a, Point b, Point c) -> bool {
+    if (a.x == b.x && b.x == c.x) {
+        return std::min(a.y, c.y) <= b.y && b.y <= std::max(a.y, c.y);
+    }
+
+    if (a.y == b.y && b.y == c.y) {
+        return std::min(a.x, c.x) <= b.x && b.x <= std::max(a.x, c.x);
+    }
+
+    return false;
+}
+}  // namespace
+
+void WaypointBuffer::assign(EdgeId edge, std::span<const Point> points) {
+    auto id = static_cast<size_t>(edge);
+    if (id >= ranges_.size()) {
+        ranges_.resize(id + 1);
+    }
+
+    ranges_[id] = {.offset = xs_.size(), .length = points.size()};
+
+    for (const auto& point : points) {
+        xs_.push_back(point.x);
+        ys_.push_back(point.y);
+    }
+}
+
+auto WaypointBuffer::range(EdgeId edge) const -> Range {
+    auto id = static_cast<size_t>(edge);
+    if (id >= ranges_.size()) {
+        return {};
+    }
+
+    return ranges_[id];
+}
+
+auto WaypointBuffer::get(EdgeId edge) const -> WaypointsView {
+    auto r = range(edge);
+    return {xs_.data() + r.offset, ys_.data() + r.offset, r.length};
+}
+
+auto WaypointBuffer::mark() const -> size_t {
+    return xs_.size();
+}
+
+auto WaypointBuffer::size() const -> size_t {
+    return xs_.size();
+}
+
+void WaypointBuffer::translate(size_t begin, size_t end, Point v) {
+    assert(begin <= end && end <= xs_.size());
+
+    add(std::span(xs_).subspan(begin, end - begin), v.x);
+    add(std::span(ys_).subspan(begin, end - begin), v.y);
+}
+
+void WaypointBuffer::translate(Point v) {
+    translate(0, xs_.size(), v);
+}
+
+void WaypointBuffer::scale(float s) {
+    multiply(xs_, s);
+    multiply(ys_, s);
+}
+
+auto WaypointBuffer::bounding_box() const -> BoundingBox {
+    auto [min_x, max_x] = min_max(xs_);
+    auto [min_y, max_y] = min_max(ys_);
+
+    return {.min = {.x = min_x, .y = min_y}, .max = {.x = max_x, .y = max_y}};
+}
+
+void WaypointBuffer::pack(const IGraph& g) {
+    auto xs     = std::vector<float>{};
+    auto ys     = std::vector<float>{};
+    auto ranges = std::vector<Range>(g.max_edge_id());
+
+    auto size = size_t{0};
+    for (const auto& edge : g.edges()) {
+        size += range(edge).length;
+    }
+
+    xs.reserve(size);
+    ys.reserve(size);
+
+    for (const auto& edge : g.edges()) {
+        const auto waypoints = get(edge);
+        const auto offset    = xs.size();
+
+        for (size_t i = 0; i < waypoints.size(); ++i) {
+            const auto point = waypoints[i];
+
+            // Skips duplicates and points in the middle of a straight line
+            if (xs.size() > offset) {
+                const auto previous = Point{.x = xs.back(), .y = ys.back()};
+
+                if (previous == point) {
+                    continue;
+                }
+
+                if (xs.size() > offset + 1) {
+                    const auto before =
+                        Point{.x = xs[xs.size() - 2], .y = ys[ys.size() - 2]};
+
+                    if (is_between(before, previous, point)) {
+                        xs.back() = point.x;
+                        ys.back() = point.y;
+                        continue;
+                    }
+                }
+            }
+
+            xs.push_back(point.x);
+            ys.push_back(point.y);
+        }
+
+        // Edges keep both of their ends
+        if (xs.size() == offset + 1 && waypoints.size() > 1) {
+            xs.push_back(waypoints.back().x);
+            ys.push_back(waypoints.back().y);
+        }
+
+        ranges[static_cast<size_t>(edge.id())] = {
+            .offset = offset, .length = xs.size() - offset};
+    }
+
+    xs_     = std::move(xs);
+    ys_     = std::move(ys);
+    ranges_ = std::move(ranges);
+}
@@ -13,11 +13,12 @@
 
 #include "triskel/llvm/llvm.hpp"
 
-auto triskel::make_layout(llvm::Function* function,
-                          Renderer* render,
-                          llvm::ModuleSlotTracker* MST)
-    -> std::unique_ptr<CFGLayout> {
-    auto builder = make_layout_builder();
+auto triskel::make_layout_builder(llvm::Function* function,
+                                  Renderer* render,
+                                  llvm::ModuleSlotTracker* MST,
+                                  const LayoutOptions& options)
+    -> std::unique_ptr<LayoutBuilder> {
+    auto builder = make_layout_builder(options);
 
     // Important, otherwise the CFGs are not necessarily well defined
     llvm::EliminateUnreachableBlocks(*function);
@@ -70,5 +71,13 @@ auto triskel::make_layout(llvm::Function* function,
         builder->measure_nodes(*render);
     }
 
-    return builder->build();
+    return builder;
+}
+
+auto triskel::make_layout(llvm::Function* function,
+                          Renderer* render,
+                          llvm::ModuleSlotTracker* MST,
+                          const LayoutOptions& options)
+    -> std::unique_ptr<CFGLayout> {
+    return make_layout_builder(function, render, MST, options)->build();
 }
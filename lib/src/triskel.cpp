@@ -2,12 +2,24 @@
 #include "triskel/internal.hpp"
 
 #include <algorithm>
+#include <atomic>
+#include <bit>
+#include <chrono>
+#include <cmath>
 #include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <exception>
 #include <filesystem>
+#include <future>
 #include <memory>
+#include <numeric>
+#include <optional>
 #include <ranges>
+#include <span>
 #include <stdexcept>
 #include <string>
+#include <string_view>
 #include <utility>
 #include <vector>
 
@@ -30,6 +42,15 @@ auto get_node_id(const IGraph& g, size_t node) -> NodeId {
     return NodeId{node};
 }
 
+/// @brief Checks that all the `nodes` belong to the graph
+void check_node_ids(const IGraph& g, std::span<const size_t> nodes) {
+    const auto count   = g.max_node_id();
+    const auto invalid = [&](size_t node) { return node >= count; };
+    if (std::ranges::any_of(nodes, invalid)) {
+        throw std::invalid_argument("ID does not belong to the graph");
+    }
+}
+
 auto get_edge_id(const IGraph& g, size_t edge) -> EdgeId {
     if (edge >= g.max_edge_id()) {
         throw std::invalid_argument("ID does not belong to the graph");
@@ -38,6 +59,55 @@ auto get_edge_id(const IGraph& g, size_t edge) -> EdgeId {
     return EdgeId{edge};
 }
 
+/// @brief Hashes words into 128 bits, each half mixed with the splitmix64
+/// finalizer from a different seed
+struct KeyHasher {
+    void add(uint64_t word) {
+        lo_ = mix(lo_ ^ word);
+        hi_ = mix(std::rotl(hi_, 23) + word);
+    }
+
+    /// @brief Adds the size of `str` then its bytes, eight at a time
+    void add(std::string_view str) {
+        add(str.size());
+        for (size_t i = 0; i < str.size(); i += sizeof(uint64_t)) {
+            auto word = uint64_t{0};
+            std::memcpy(&word, str.data() + i,
+                        std::min(sizeof(word), str.size() - i));
+            add(word);
+        }
+    }
+
+    [[nodiscard]] auto key() const -> DiskCache::Key { return {lo_, hi_}; }
+
+   private:
+    static auto mix(uint64_t hash) -> uint64_t {
+        hash += 0x9e3779b97f4a7c15ULL;
+        hash  = (hash ^ (hash >> 30U)) * 0xbf58476d1ce4e5b9ULL;
+        hash  = (hash ^ (hash >> 27U)) * 0x94d049bb133111ebULL;
+        return hash ^ (hash >> 31U);
+    }
+
+    uint64_t lo_ = 0x736b656c65746f6eULL;
+    uint64_t hi_ = 0x6c61796f75747321ULL;
+};
+
+/// @brief Adds the labels of the nodes of `g` to a layout
+auto with_labels(FrozenLayout::Data data,
+                 const IGraph& g,
+                 const NodeAttribute<std::string>& labels) -> FrozenLayout {
+    const auto nodes = g.max_node_id();
+
+    data.label_offsets.reserve(nodes + 1);
+    for (size_t node = 0; node < nodes; ++node) {
+        data.label_offsets.push_back(data.labels.size());
+        data.labels += labels.get(NodeId{node});
+    }
+    data.label_offsets.push_back(data.labels.size());
+
+    return FrozenLayout{std::move(data)};
+}
+
 auto truncate_str(const std::string& str,
                   const std::string& ellipsis = "(...)",
                   size_t max_length           = 80) -> std::string {
@@ -55,98 +125,184 @@ struct CFGLayoutImpl : CFGLayout {
                   const NodeAttribute<std::string>& labels,
                   const NodeAttribute<float>& widths,
                   const NodeAttribute<float>& heights,
-                  const EdgeAttribute<LayoutBuilder::EdgeType>& edge_types)
+                  const EdgeAttribute<LayoutBuilder::EdgeType>& edge_types,
+                  const LayoutOptions& options,
+                  const WarmStart& warm_start = {},
+                  LayoutContext* context      = nullptr)
+        : graph_{std::move(graph)},
+          labels_{labels},
+          widths_{widths},
+          heights_{heights},
+          edge_types_(edge_types),
+          options_{options},
+          layout_{std::make_unique<Layout>(*graph_, heights_, widths_,
+                                           options, warm_start, context)},
+          result_{read_result()} {}
+
+    /// @brief A layout read from the disk cache. The steps of the layout run
+    /// on the first edit
+    CFGLayoutImpl(std::unique_ptr<Graph> graph,
+                  const NodeAttribute<std::string>& labels,
+                  const NodeAttribute<float>& widths,
+                  const NodeAttribute<float>& heights,
+                  const EdgeAttribute<LayoutBuilder::EdgeType>& edge_types,
+                  const LayoutOptions& options,
+                  FrozenLayout result)
         : graph_{std::move(graph)},
           labels_{labels},
           widths_{widths},
           heights_{heights},
           edge_types_(edge_types),
-          layout_{*graph_, heights_, widths_} {}
+          options_{options},
+          result_{std::move(result)} {}
 
     [[nodiscard]] auto get_coords(size_t node) const -> Point override {
-        auto id = get_node_id(*graph_, node);
-        return layout_.get_xy(id);
+        return result_.get_coords(node);
     }
 
     [[nodiscard]] auto get_waypoints(size_t edge) const
-        -> const std::vector<Point>& override {
-        auto id = get_edge_id(*graph_, edge);
-        return layout_.get_waypoints(id);
+        -> WaypointsView override {
+        return result_.get_waypoints(edge);
     }
 
     [[nodiscard]] auto get_height() const -> float override {
-        return layout_.get_graph_height(*graph_);
+        return result_.get_height();
     }
 
     [[nodiscard]] auto get_width() const -> float override {
-        return layout_.get_graph_width(*graph_);
+        return result_.get_width();
     }
 
     [[nodiscard]] auto node_count() const -> size_t override {
-        return graph_->node_count();
+        return graph_->max_node_id();
     }
 
     [[nodiscard]] auto edge_count() const -> size_t override {
-        return graph_->edge_count();
+        return graph_->max_edge_id();
+    }
+
+    [[nodiscard]] auto get_stats() const -> const LayoutStats& override {
+        return result_.get_stats();
     }
 
-    void render(Renderer& render) const override {
-        auto width  = get_width();
-        auto height = get_height();
+    [[nodiscard]] auto node_rects() const -> std::span<const Rect> override {
+        return result_.node_rects();
+    }
 
-        render.begin(width, height);
+    [[nodiscard]] auto waypoint_offsets() const
+        -> std::span<const size_t> override {
+        return result_.waypoint_offsets();
+    }
 
-        // Draws the nodes
-        for (const auto& node : graph_->nodes()) {
-            auto tl     = layout_.get_xy(node);
-            auto width  = widths_.get(node);
-            auto height = heights_.get(node);
+    [[nodiscard]] auto waypoints() const -> std::span<const Point> override {
+        return result_.waypoints();
+    }
 
-            render.draw_rectangle_border(tl, width, height,
-                                         render.STYLE_BASICBLOCK_BORDER);
+    [[nodiscard]] auto edge_types() const
+        -> std::span<const LayoutBuilder::EdgeType> override {
+        return result_.edge_types();
+    }
 
-            render.draw_text(tl, labels_.get(node), render.STYLE_TEXT);
+    void update_node_size(size_t node, float width, float height) override {
+        auto id = get_node_id(*graph_, node);
+
+        widths_.set(id, width);
+        heights_.set(id, height);
+
+        if (layout_ == nullptr) {
+            relayout();
+            return;
         }
 
-        // Draws the edges
-        for (const auto& edge : graph_->edges()) {
-            const auto& waypoints = layout_.get_waypoints(edge);
+        layout_->update_node_size(id, width, height);
 
-            if (waypoints.empty()) {
-                continue;
-                // FIXME:
-                throw std::invalid_argument("ERROR during layout");
-            }
+        result_ = read_result();
+    }
 
-            // Gets the style for this edge
-            auto style = render.STYLE_EDGE;
+    void measure_nodes(const Renderer& renderer) override {
+        for (const auto& node : graph_->nodes()) {
+            const auto& label = labels_.get(node);
+            const auto bbox = renderer.measure_text(label, renderer.STYLE_TEXT);
+            widths_.set(node, bbox.x);
+            heights_.set(node, bbox.y);
+        }
 
-            auto t = edge_types_.get(edge);
-            if (t == LayoutBuilder::EdgeType::True) {
-                style = render.STYLE_EDGE_T;
-            } else if (t == LayoutBuilder::EdgeType::False) {
-                style = render.STYLE_EDGE_F;
-            }
+        if (layout_ == nullptr) {
+            relayout();
+            return;
+        }
 
-            auto last = waypoints.front();
+        layout_->update_node_sizes(heights_, widths_);
 
-            for (size_t i = 1; i < waypoints.size(); ++i) {
-                auto waypoint = waypoints[i];
+        result_ = read_result();
+    }
 
-                render.draw_line(last, waypoint, style);
+    auto add_edge(size_t from, size_t to) -> size_t override {
+        return add_edge(from, to, LayoutBuilder::EdgeType::Default);
+    }
 
-                last = waypoint;
-            }
+    auto add_edge(size_t from,
+                  size_t to,
+                  LayoutBuilder::EdgeType type) -> size_t override {
+        auto from_id = get_node_id(*graph_, from);
+        auto to_id   = get_node_id(*graph_, to);
+
+        auto& editor = graph_->editor();
+        editor.push();
+        auto edge = editor.make_edge(from_id, to_id);
+        editor.commit();
 
-            render.draw_triangle(last,
-                                 last + Point{.x = -render.TRIANGLE_SIZE / 2,
-                                              .y = -render.TRIANGLE_SIZE},
-                                 last + Point{.x = +render.TRIANGLE_SIZE / 2,
-                                              .y = -render.TRIANGLE_SIZE},
-                                 style.color);
+        edge_types_.set(edge, type);
+
+        relayout();
+        return static_cast<size_t>(edge.id());
+    }
+
+    void remove_edge(size_t edge) override {
+        auto id = get_edge_id(*graph_, edge);
+
+        // Removed edges keep their id
+        if (std::ranges::none_of(
+                graph_->get_edge(id).from().edges(),
+                [id](const Edge& edge) { return edge.id() == id; })) {
+            throw std::invalid_argument("The edge was removed");
         }
 
-        render.end();
+        auto& editor = graph_->editor();
+        editor.push();
+        editor.remove_edge(id);
+        editor.commit();
+
+        relayout();
+    }
+
+    auto split_node(size_t node) -> size_t override {
+        auto id = get_node_id(*graph_, node);
+
+        auto& editor   = graph_->editor();
+        const auto old = graph_->get_node(id);
+
+        editor.push();
+        auto split = editor.make_node();
+        for (const auto& edge : old.child_edges()) {
+            editor.edit_edge(edge, split, edge.to());
+        }
+        editor.make_edge(id, split);
+        editor.commit();
+
+        widths_.set(split, widths_.get(id));
+        heights_.set(split, heights_.get(id));
+
+        relayout();
+        return static_cast<size_t>(split.id());
+    }
+
+    [[nodiscard]] auto freeze() const -> FrozenLayout override {
+        return result_;
+    }
+
+    void render(Renderer& renderer) const override {
+        result_.render(renderer);
     }
 
     void render_and_save(ExportingRenderer& renderer,
@@ -160,17 +316,79 @@ struct CFGLayoutImpl : CFGLayout {
     NodeAttribute<float> widths_;
     NodeAttribute<float> heights_;
     EdgeAttribute<LayoutBuilder::EdgeType> edge_types_;
+    LayoutOptions options_;
+
+    /// @brief `nullptr` until the first edit of a layout read from the disk
+    /// cache
+    std::unique_ptr<Layout> layout_;
+
+    /// @brief What the accessors read, updated with the layout
+    FrozenLayout result_;
+
+   private:
+    /// @brief Copies the result of the layout into flat arrays
+    [[nodiscard]] auto read_result() const -> FrozenLayout {
+        auto data = FrozenLayout::Data{};
+
+        const auto nodes = graph_->max_node_id();
+        data.rects.reserve(nodes);
+        for (size_t node = 0; node < nodes; ++node) {
+            const auto id = NodeId{node};
+            const auto tl = layout_->get_xy(id);
+
+            data.rects.push_back({.x      = tl.x,
+                                  .y      = tl.y,
+                                  .width  = widths_.get(id),
+                                  .height = heights_.get(id)});
+        }
+
+        const auto edges = graph_->max_edge_id();
+        data.edge_types.reserve(edges);
+        data.waypoint_offsets.reserve(edges + 1);
+        for (size_t edge = 0; edge < edges; ++edge) {
+            const auto id = EdgeId{edge};
+
+            data.waypoint_offsets.push_back(data.waypoints.size());
+            for (const auto waypoint : layout_->get_waypoints(id)) {
+                data.waypoints.push_back(waypoint);
+            }
+
+            data.edge_types.push_back(edge_types_.get(id));
+        }
+        data.waypoint_offsets.push_back(data.waypoints.size());
+
+        data.width  = layout_->get_graph_width(*graph_);
+        data.height = layout_->get_graph_height(*graph_);
+        data.stats  = layout_->stats();
+
+        return with_labels(std::move(data), *graph_, labels_);
+    }
 
-    Layout layout_;
+    /// @brief Lays the edited graph out again. The program structure tree
+    /// and the regions are rebuilt, only the layouts of the regions found
+    /// unchanged in the previous layout are reused. The previous layout is
+    /// kept if this one throws
+    void relayout() {
+        auto previous =
+            layout_ != nullptr ? layout_->saved_regions() : nullptr;
+
+        auto layout = std::make_unique<Layout>(
+            *graph_, heights_, widths_, options_,
+            WarmStart{.regions = previous.get()});
+
+        layout_ = std::move(layout);
+        result_ = read_result();
+    }
 };
 
 struct LayoutBuilderImpl : LayoutBuilder {
-    LayoutBuilderImpl()
+    explicit LayoutBuilderImpl(const LayoutOptions& options)
         : graph_{std::make_unique<Graph>()},
           widths_(0, 1.0F),
           heights_(0, 1.0F),
           labels_(0, ""),
-          edge_types_(0, EdgeType::Default) {
+          edge_types_(0, EdgeType::Default),
+          options_{options} {
         // Allow edits to this graph
         graph_->editor().push();
     }
@@ -240,16 +458,138 @@ struct LayoutBuilderImpl : LayoutBuilder {
         return static_cast<size_t>(edge.id());
     }
 
+    void reserve(size_t nodes, size_t edges) override {
+        widths_.reserve(nodes);
+        heights_.reserve(nodes);
+        labels_.reserve(nodes);
+        edge_types_.reserve(edges);
+    }
+
+    auto make_nodes(size_t count) -> size_t override {
+        return static_cast<size_t>(graph_->editor().make_nodes(count));
+    }
+
+    auto make_nodes(size_t count,
+                    std::span<const float> widths,
+                    std::span<const float> heights) -> size_t override {
+        if (widths.size() != count || heights.size() != count) {
+            throw std::invalid_argument("Expected a size for each node");
+        }
+
+        auto first = graph_->editor().make_nodes(count);
+
+        widths_.set(first, widths);
+        heights_.set(first, heights);
+
+        return static_cast<size_t>(first);
+    }
+
+    auto make_edges(std::span<const size_t> from,
+                    std::span<const size_t> to) -> size_t override {
+        return make_edges(from, to, {});
+    }
+
+    auto make_edges(std::span<const size_t> from,
+                    std::span<const size_t> to,
+                    std::span<const EdgeType> types) -> size_t override {
+        if (from.size() != to.size() ||
+            (!types.empty() && types.size() != from.size())) {
+            throw std::invalid_argument("Expected two ends for each edge");
+        }
+
+        check_node_ids(*graph_, from);
+        check_node_ids(*graph_, to);
+
+        auto first = graph_->editor().make_edges(from, to);
+        if (!types.empty()) {
+            edge_types_.set(first, types);
+        }
+
+        return static_cast<size_t>(first);
+    }
+
+    /// @brief Adds the edges of the nodes in compressed sparse row form, see
+    /// `make_layout_builder`. The offsets are expected to be valid
+    auto make_csr_edges(std::span<const size_t> offsets,
+                        std::span<const size_t> targets,
+                        std::span<const EdgeType> types) -> size_t {
+        if (!types.empty() && types.size() != targets.size()) {
+            throw std::invalid_argument("Expected a type for each edge");
+        }
+
+        check_node_ids(*graph_, targets);
+
+        auto first = graph_->editor().make_csr_edges(offsets, targets);
+        if (!types.empty()) {
+            edge_types_.set(first, types);
+        }
+
+        return static_cast<size_t>(first);
+    }
+
     auto build() -> std::unique_ptr<CFGLayout> override {
-        // End edits
-        graph_->editor().commit();
+        return build_in(nullptr);
+    }
 
-        auto layout = std::make_unique<CFGLayoutImpl>(
-            std::move(graph_), labels_, widths_, heights_, edge_types_);
+    auto build(LayoutContext& context) -> std::unique_ptr<CFGLayout> override {
+        return build_in(&context);
+    }
 
-        return layout;
+    auto build_async(Executor& executor,
+                     CancellationToken cancellation,
+                     ProgressCallback progress)
+        -> std::future<std::unique_ptr<CFGLayout>> override {
+        options_.cancellation = std::move(cancellation);
+        options_.progress     = std::move(progress);
+
+        // The task takes the graph, the builder is left empty as after `build`
+        auto builder = std::make_shared<LayoutBuilderImpl>(std::move(*this));
+        auto promise =
+            std::make_shared<std::promise<std::unique_ptr<CFGLayout>>>();
+        auto future = promise->get_future();
+
+        executor.submit([builder, promise] {
+            try {
+                promise->set_value(builder->build());
+            } catch (...) {
+                promise->set_exception(std::current_exception());
+            }
+        });
+
+        return future;
+    }
+
+    void warm_start(const CFGLayout& previous,
+                    const std::vector<size_t>& node_map) override {
+        const auto* impl = dynamic_cast<const CFGLayoutImpl*>(&previous);
+        if (impl == nullptr) {
+            throw std::invalid_argument("The layout was not built by triskel");
+        }
+
+        // Everything is checked before the builder changes, so that a failed
+        // call leaves it as it was
+        auto xs = std::optional<NodeAttribute<float>>{};
+        if (!node_map.empty()) {
+            xs.emplace(0, NAN);
+            for (size_t node = 0; node < node_map.size(); ++node) {
+                if (node_map[node] != NO_MATCH) {
+                    xs->set(NodeId{node},
+                            previous.get_coords(node_map[node]).x);
+                }
+            }
+        }
+
+        // A layout read from the disk cache has no regions to start from
+        warm_regions_ = impl->layout_ != nullptr
+                            ? impl->layout_->saved_regions()
+                            : nullptr;
+        warm_xs_      = std::move(xs);
     }
 
+    auto node_count() const -> size_t override { return graph_->node_count(); }
+
+    auto edge_count() const -> size_t override { return graph_->edge_count(); }
+
     auto graphviz() const -> std::string override { return format_as(*graph_); }
 
     std::unique_ptr<Graph> graph_;
@@ -261,6 +601,89 @@ struct LayoutBuilderImpl : LayoutBuilder {
 
     EdgeAttribute<LayoutBuilder::EdgeType> edge_types_;
 
+    LayoutOptions options_;
+
+    /// @brief The regions of the layout this one starts from
+    std::unique_ptr<LayoutCache> warm_regions_;
+
+    /// @brief The x coordinates of the nodes in the layout this one starts
+    /// from
+    std::optional<NodeAttribute<float>> warm_xs_;
+
+    /// @brief Lays out the CFG, drawing the transient buffers from `context`
+    /// if it is set
+    auto build_in(LayoutContext* context) -> std::unique_ptr<CFGLayout> {
+        // End edits
+        graph_->editor().commit();
+
+        auto* disk_cache = options_.disk_cache;
+        if (warm_regions_ != nullptr || warm_xs_.has_value()) {
+            disk_cache = nullptr;
+        }
+
+        auto key = DiskCache::Key{};
+        if (disk_cache != nullptr) {
+            key = disk_cache_key();
+
+            auto result = disk_cache->find(key, graph_->max_node_id(),
+                                           graph_->max_edge_id());
+            if (result.has_value()) {
+                return std::make_unique<CFGLayoutImpl>(
+                    std::move(graph_), labels_, widths_, heights_,
+                    edge_types_, options_, std::move(*result));
+            }
+        }
+
+        auto layout = std::make_unique<CFGLayoutImpl>(
+            std::move(graph_), labels_, widths_, heights_, edge_types_,
+            options_,
+            WarmStart{.regions = warm_regions_.get(),
+                      .xs = warm_xs_.has_value() ? &*warm_xs_ : nullptr},
+            context);
+
+        // A truncated layout would be served to the builds with more time
+        if (disk_cache != nullptr && !layout->get_stats().truncated) {
+            disk_cache->insert(key, layout->result_);
+        }
+
+        return layout;
+    }
+
+    /// @brief Hashes what the layout depends on: the version of the layout
+    /// and of the files, the graph, the sizes and labels of the nodes, the
+    /// types of the edges and the options changing the layout
+    [[nodiscard]] auto disk_cache_key() const -> DiskCache::Key {
+        auto hasher = KeyHasher{};
+
+        hasher.add(DiskCache::LAYOUT_VERSION);
+        hasher.add(FrozenLayout::FORMAT_VERSION);
+        hasher.add(static_cast<uint64_t>(options_.ordering));
+        hasher.add(static_cast<uint64_t>(options_.coordinates));
+        hasher.add(options_.concentration_threshold);
+
+        const auto nodes = graph_->max_node_id();
+        const auto edges = graph_->max_edge_id();
+        hasher.add(nodes);
+        hasher.add(edges);
+
+        for (size_t node = 0; node < nodes; ++node) {
+            const auto id = NodeId{node};
+            hasher.add(std::bit_cast<uint32_t>(widths_.get(id)));
+            hasher.add(std::bit_cast<uint32_t>(heights_.get(id)));
+            hasher.add(labels_.get(id));
+        }
+
+        for (size_t edge = 0; edge < edges; ++edge) {
+            const auto id = EdgeId{edge};
+            const auto e  = graph_->get_edge(id);
+            hasher.add(static_cast<uint64_t>(e.from().id()));
+            hasher.add(static_cast<uint64_t>(e.to().id()));
+            hasher.add(static_cast<uint64_t>(edge_types_.get(id)));
+        }
+
+        return hasher.key();
+    }
+
     /// @brief Gets the bounding box of a string
     [[nodiscard]] static auto get_string_size(const std::string& str) -> Point {
         auto lines = 0.0F;
@@ -292,7 +715,100 @@ Renderer::Renderer()
 {}
 
 auto triskel::make_layout_builder() -> std::unique_ptr<LayoutBuilder> {
-    return std::make_unique<LayoutBuilderImpl>();
+    return make_layout_builder(LayoutOptions{});
+}
+
+auto triskel::make_layout_builder(const LayoutOptions& options)
+    -> std::unique_ptr<LayoutBuilder> {
+    return std::make_unique<LayoutBuilderImpl>(options);
+}
+
+auto triskel::make_layout_builder(
+    std::span<const size_t> offsets,
+    std::span<const size_t> targets,
+    std::span<const LayoutBuilder::EdgeType> types,
+    const LayoutOptions& options)
+    -> std::unique_ptr<LayoutBuilder> {
+    const auto nodes = offsets.empty() ? 0 : offsets.size() - 1;
+    if ((offsets.empty() && !targets.empty()) ||
+        (!offsets.empty() &&
+         (offsets.front() != 0 || offsets.back() != targets.size() ||
+          !std::ranges::is_sorted(offsets)))) {
+        throw std::invalid_argument("Invalid edge offsets");
+    }
+
+    auto builder = std::make_unique<LayoutBuilderImpl>(options);
+    builder->reserve(nodes, targets.size());
+    builder->make_nodes(nodes);
+    builder->make_csr_edges(offsets, targets, types);
+    return builder;
+}
+
+auto triskel::layout_batch(std::span<std::unique_ptr<LayoutBuilder>> builders,
+                           const BatchOptions& options)
+    -> std::vector<BatchResult> {
+    auto results = std::vector<BatchResult>(builders.size());
+
+    // The largest graphs go first so that no thread is left with a large
+    // graph once the others are done
+    auto sizes = std::vector<size_t>(builders.size(), 0);
+    for (size_t i = 0; i < builders.size(); ++i) {
+        if (builders[i] != nullptr) {
+            sizes[i] = builders[i]->node_count() + builders[i]->edge_count();
+        }
+    }
+
+    auto order = std::vector<size_t>(builders.size());
+    std::iota(order.begin(), order.end(), 0);
+    std::ranges::stable_sort(
+        order, [&sizes](size_t a, size_t b) { return sizes[a] > sizes[b]; });
+
+    // Holds the default executor until the batch is done
+    auto fallback  = std::shared_ptr<Executor>{};
+    auto* executor = options.executor;
+    if (executor == nullptr) {
+        fallback = default_executor();
+        executor = fallback.get();
+    }
+
+    const auto threads = std::min(
+        builders.size(),
+        options.threads == 0 ? executor->concurrency() : options.threads);
+
+    // Each worker takes the next largest graph until none is left
+    auto next  = std::atomic<size_t>{0};
+    auto group = TaskGroup{*executor, threads};
+    for (size_t worker = 0; worker < threads; ++worker) {
+        group.run([&] {
+            // The graphs of the worker reuse the same memory
+            auto context = LayoutContext{};
+
+            while (true) {
+                const auto i = next.fetch_add(1);
+                if (i >= order.size()) {
+                    return;
+                }
+
+                auto& builder = builders[order[i]];
+                auto& result  = results[order[i]];
+
+                const auto start = std::chrono::steady_clock::now();
+                try {
+                    if (builder == nullptr) {
+                        throw std::invalid_argument("The builder is null");
+                    }
+
+                    result.layout = builder->build(context);
+                } catch (...) {
+                    result.error = std::current_exception();
+                }
+                result.time = std::chrono::steady_clock::now() - start;
+            }
+        });
+    }
+
+    group.wait();
+    return results;
 }
 
 auto triskel::make_layout(std::unique_ptr<Graph> g,
@@ -300,7 +816,9 @@ auto triskel::make_layout(std::unique_ptr<Graph> g,
                           const NodeAttribute<float>& height,
                           const NodeAttribute<std::string>& label,
                           const EdgeAttribute<LayoutBuilder::EdgeType>&
-                              edge_types) -> std::unique_ptr<CFGLayout> {
+                              edge_types,
+                          const LayoutOptions& options)
+    -> std::unique_ptr<CFGLayout> {
     return std::make_unique<CFGLayoutImpl>(std::move(g), label, width, height,
-                                           edge_types);
+                                           edge_types, options);
 }
@@ -0,0 +1,169 @@
+#include "triskel/utils/executor.hpp"
+
+#include <algorithm>
+#include <cstddef>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <utility>
+
+#include "triskel/utils/thread_pool.hpp"
+
+// NOLINTNEXTLINE(google-build-using-namespace)
+using namespace triskel;
+
+namespace {
+// The number of chunks given to each thread by `parallel_for`, so that the
+// threads finishing early can take more
+constexpr size_t CHUNKS_PER_THREAD = 4;
+
+std::mutex default_mutex;
+std::shared_ptr<Executor> default_override;
+}  // namespace
+
+// =============================================================================
+// Executor
+// =============================================================================
+void Executor::parallel_for(size_t count,
+                            const std::function<void(size_t)>& body) {
+    if (count == 0) {
+        return;
+    }
+
+    const auto threads = std::max<size_t>(concurrency(), 1);
+    const auto chunks  = std::min(count, threads * CHUNKS_PER_THREAD);
+
+    // The calling thread is one of the threads
+    auto group = TaskGroup{*this, threads + 1};
+    for (size_t chunk = 0; chunk < chunks; ++chunk) {
+        group.run([&body, count, chunks, chunk] {
+            const auto begin = count * chunk / chunks;
+            const auto end   = count * (chunk + 1) / chunks;
+            for (size_t i = begin; i < end; ++i) {
+                body(i);
+            }
+        });
+    }
+
+    group.wait();
+}
+
+// =============================================================================
+// InlineExecutor
+// =============================================================================
+void InlineExecutor::submit(Task task) {
+    try {
+        task();
+    } catch (...) {
+        if (!error_) {
+            error_ = std::current_exception();
+        }
+    }
+}
+
+void InlineExecutor::wait() {
+    if (error_) {
+        std::rethrow_exception(std::exchange(error_, nullptr));
+    }
+}
+
+// =============================================================================
+// TaskGroup
+// =============================================================================
+TaskGroup::TaskGroup(Executor& executor, size_t width)
+    : executor_{executor},
+      width_{std::max<size_t>(width, 1)},
+      state_{std::make_shared<State>()} {}
+
+TaskGroup::~TaskGroup() {
+    auto lock = std::unique_lock{state_->mutex};
+    state_->tasks.clear();
+    state_->changed.wait(lock, [this] { return state_->running == 0; });
+}
+
+void TaskGroup::run(Executor::Task task) {
+    {
+        auto lock = std::lock_guard{state_->mutex};
+        state_->tasks.push_back(std::move(task));
+
+        // The waiting thread is one of the `width_` threads
+        if (state_->drainers + 1 >= width_) {
+            state_->changed.notify_all();
+            return;
+        }
+
+        state_->drainers++;
+    }
+
+    executor_.submit([state = state_] { state->drain(); });
+}
+
+void TaskGroup::wait() {
+    auto& state = *state_;
+    auto lock   = std::unique_lock{state.mutex};
+
+    // The drainers that did not start are not waited for, they may be queued
+    // behind this thread
+    while (!state.tasks.empty() || state.running > 0) {
+        if (!state.tasks.empty()) {
+            state.run_one(lock);
+        } else {
+            state.changed.wait(lock);
+        }
+    }
+
+    if (state.error) {
+        std::rethrow_exception(std::exchange(state.error, nullptr));
+    }
+}
+
+void TaskGroup::State::drain() {
+    auto lock = std::unique_lock{mutex};
+    while (!tasks.empty()) {
+        run_one(lock);
+    }
+
+    drainers--;
+}
+
+void TaskGroup::State::run_one(std::unique_lock<std::mutex>& lock) {
+    auto task = std::move(tasks.front());
+    tasks.pop_front();
+    running++;
+
+    lock.unlock();
+    try {
+        task();
+    } catch (...) {
+        lock.lock();
+        if (!error) {
+            error = std::current_exception();
+        }
+        lock.unlock();
+    }
+    lock.lock();
+
+    running--;
+    changed.notify_all();
+}
+
+// =============================================================================
+// Default executor
+// =============================================================================
+auto triskel::default_executor() -> std::shared_ptr<Executor> {
+    auto lock = std::lock_guard{default_mutex};
+    if (default_override != nullptr) {
+        return default_override;
+    }
+
+    static auto pool = std::make_shared<ThreadPool>(
+        std::max<size_t>(std::thread::hardware_concurrency(), 1));
+    return pool;
+}
+
+void triskel::set_default_executor(std::shared_ptr<Executor> executor) {
+    auto lock        = std::lock_guard{default_mutex};
+    default_override = std::move(executor);
+}
@@ -0,0 +1,148 @@
+#include "triskel/utils/thread_pool.hpp"
+
+#include <algorithm>
+#include <cstddef>
+#include <exception>
+#include <mutex>
+#include <optional>
+#include <thread>
+#include <utility>
+
+// NOLINTNEXTLINE(google-build-using-namespace)
+using namespace triskel;
+
+namespace {
+// The pool and index of the worker running on this thread
+thread_local const ThreadPool* current_pool = nullptr;
+thread_local size_t current_worker          = 0;
+}  // namespace
+
+ThreadPool::ThreadPool(size_t thread_count) {
+    thread_count = std::max<size_t>(thread_count, 1);
+
+    queues_.reserve(thread_count);
+    for (size_t i = 0; i < thread_count; ++i) {
+        queues_.push_back(std::make_unique<Queue>());
+    }
+
+    threads_.reserve(thread_count);
+    for (size_t i = 0; i < thread_count; ++i) {
+        threads_.emplace_back([this, i] { run(i); });
+    }
+}
+
+ThreadPool::~ThreadPool() {
+    {
+        auto lock = std::lock_guard{mutex_};
+        stop_     = true;
+    }
+
+    wake_.notify_all();
+
+    for (auto& thread : threads_) {
+        thread.join();
+    }
+}
+
+void ThreadPool::submit(Task task) {
+    auto worker = current_pool == this
+                      ? current_worker
+                      : next_queue_.fetch_add(1) % queues_.size();
+
+    // Counted before being queued so that `pending_` never underflows
+    {
+        auto lock = std::lock_guard{mutex_};
+        pending_++;
+    }
+
+    // `queued_` only counts the tasks in the queues, a worker woken by it
+    // finds a task unless another worker took it first
+    {
+        auto& queue = *queues_[worker];
+        auto lock   = std::lock_guard{queue.mutex};
+        queue.tasks.push_back(std::move(task));
+        queued_++;
+    }
+
+    // Taking the lock orders the notification after the check of a worker
+    // about to wait
+    {
+        auto lock = std::lock_guard{mutex_};
+    }
+    wake_.notify_one();
+}
+
+void ThreadPool::wait() {
+    auto lock = std::unique_lock{mutex_};
+    done_.wait(lock, [this] { return pending_ == 0; });
+
+    if (error_) {
+        std::rethrow_exception(std::exchange(error_, nullptr));
+    }
+}
+
+auto ThreadPool::take(size_t worker) -> std::optional<Task> {
+    // Newest task of our own queue
+    {
+        auto& queue = *queues_[worker];
+        auto lock   = std::lock_guard{queue.mutex};
+        if (!queue.tasks.empty()) {
+            auto task = std::move(queue.tasks.back());
+            queue.tasks.pop_back();
+            queued_--;
+            return task;
+        }
+    }
+
+    // Oldest task of another queue
+    for (size_t i = 1; i < queues_.size(); ++i) {
+        auto& queue = *queues_[(worker + i) % queues_.size()];
+        auto lock   = std::lock_guard{queue.mutex};
+        if (!queue.tasks.empty()) {
+            auto task = std::move(queue.tasks.front());
+            queue.tasks.pop_front();
+            queued_--;
+            return task;
+        }
+    }
+
+    return std::nullopt;
+}
+
+void ThreadPool::run(size_t worker) {
+    current_pool   = this;
+    current_worker = worker;
+
+    while (true) {
+        {
+            auto lock = std::unique_lock{mutex_};
+            wake_.wait(lock, [this] { return stop_ || queued_ > 0; });
+
+            if (stop_) {
+                return;
+            }
+        }
+
+        auto task = take(worker);
+        if (!task) {
+            // Another worker took it first
+            std::this_thread::yield();
+            continue;
+        }
+
+        try {
+            (*task)();
+        } catch (...) {
+            auto lock = std::lock_guard{mutex_};
+            if (!error_) {
+                error_ = std::current_exception();
+            }
+        }
+
+        auto lock = std::lock_guard{mutex_};
+        pending_--;
+        if (pending_ == 0) {
+            done_.notify_all();
+        }
+    }
+}
@@ -0,0 +1,93 @@
+#include <triskel/utils/tree.hpp>
+
+#include <vector>
+
+#include <gtest/gtest.h>
+
+// NOLINTNEXTLINE(google-build-using-namespace)
+using namespace triskel;
+
+namespace {
+auto child_ids(const Tree<char>::Node& node) -> std::vector<size_t> {
+    auto ids = std::vector<size_t>{};
+    for (const auto* child : node.children()) {
+        ids.push_back(child->id);
+    }
+    return ids;
+}
+}  // namespace
+
+TEST(Tree, Compact) {
+    auto tree = Tree<char>{};
+
+    // r -> a -> c
+    //   -> b -> d
+    //        -> e
+    tree.make_node().label = 'r';
+    for (auto label : {'a', 'b', 'c', 'd', 'e'}) {
+        tree.make_node().label = label;
+    }
+
+    tree.nodes[0].add_child(&tree.nodes[1]);
+    tree.nodes[0].add_child(&tree.nodes[2]);
+    tree.nodes[1].add_child(&tree.nodes[3]);
+    tree.nodes[2].add_child(&tree.nodes[4]);
+    tree.nodes[2].add_child(&tree.nodes[5]);
+
+    ASSERT_FALSE(tree.is_compact());
+    tree.compact();
+
+    ASSERT_EQ(child_ids(tree.root()), (std::vector<size_t>{1, 2}));
+    ASSERT_EQ(child_ids(tree.nodes[2]), (std::vector<size_t>{4, 5}));
+    ASSERT_EQ(tree.nodes[5].depth, 2);
+
+    tree.remove_node(&tree.nodes[3]);
+    tree.remove_node(&tree.nodes[4]);
+
+    // Removed nodes stay until the tree is compacted
+    ASSERT_EQ(tree.nodes.size(), 6);
+
+    const auto new_ids = tree.compact();
+    ASSERT_EQ(new_ids, (std::vector<size_t>{0, 1, 2, Tree<char>::InvalidID,
+                                            Tree<char>::InvalidID, 3}));
+
+    ASSERT_EQ(tree.nodes.size(), 4);
+    ASSERT_TRUE(child_ids(tree.nodes[1]).empty());
+    ASSERT_EQ(child_ids(tree.nodes[2]), (std::vector<size_t>{3}));
+    ASSERT_EQ(tree.nodes[3].label, 'e');
+    ASSERT_EQ(tree.nodes[3].parent().label, 'b');
+    ASSERT_EQ(tree.nodes[3].root().label, 'r');
+}
+
+TEST(Tree, LowestCommonAncestor) {
+    auto tree = Tree<char>{};
+
+    // A chain of 20 nodes with a second branch on node 5
+    (void)tree.make_node();
+    for (size_t i = 1; i < 20; ++i) {
+        (void)tree.make_node();
+        tree.nodes[i - 1].add_child(&tree.nodes[i]);
+    }
+
+    (void)tree.make_node();
+    tree.nodes[5].add_child(&tree.nodes[20]);
+    (void)tree.make_node();
+    tree.nodes[20].add_child(&tree.nodes[21]);
+
+    tree.compact();
+
+    ASSERT_TRUE(tree.root().is_ancestor_of(tree.nodes[21]));
+    ASSERT_TRUE(tree.nodes[5].is_ancestor_of(tree.nodes[19]));
+    ASSERT_TRUE(tree.nodes[7].is_ancestor_of(tree.nodes[7]));
+    ASSERT_FALSE(tree.nodes[6].is_ancestor_of(tree.nodes[21]));
+    ASSERT_FALSE(tree.nodes[19].is_ancestor_of(tree.nodes[5]));
+
+    ASSERT_EQ(tree.lowest_common_ancestor(tree.nodes[19], tree.nodes[21]).id,
+              5);
+    ASSERT_EQ(tree.lowest_common_ancestor(tree.nodes[21], tree.nodes[6]).id,
+              5);
+    ASSERT_EQ(tree.lowest_common_ancestor(tree.nodes[12], tree.nodes[17]).id,
+              12);
+    ASSERT_EQ(tree.lowest_common_ancestor(tree.nodes[3], tree.nodes[3]).id, 3);
+    ASSERT_EQ(tree.nodes[21].depth, 7);
+}
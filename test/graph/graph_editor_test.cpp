@@ -1,6 +1,8 @@
 #include <triskel/graph/graph.hpp>
 
 #include <algorithm>
+#include <cstddef>
+#include <vector>
 
 #include <fmt/base.h>
 #include <gtest/gtest.h>
@@ -111,6 +113,42 @@ TEST(Attribute, addEdge) {
     }
 }
 
+TEST(Attribute, addEdges) {
+    GRAPH1
+
+    ge.push();
+
+    size_t og_size  = g.edge_count();
+    size_t n1_edges = n1.edges().size();
+
+    const auto from = std::vector<size_t>{static_cast<size_t>(n1.id()),
+                                          static_cast<size_t>(n7.id())};
+    const auto to   = std::vector<size_t>{static_cast<size_t>(n7.id()),
+                                          static_cast<size_t>(n2.id())};
+    auto first      = ge.make_edges(from, to);
+
+    // n1 -> n3, n3 -> n4 and n3 -> n5
+    const auto offsets = std::vector<size_t>{0, 1, 1, 3};
+    const auto targets = std::vector<size_t>{static_cast<size_t>(n3.id()),
+                                             static_cast<size_t>(n4.id()),
+                                             static_cast<size_t>(n5.id())};
+    auto csr_first     = ge.make_csr_edges(offsets, targets);
+
+    ASSERT_EQ(g.edge_count(), og_size + 5);
+    ASSERT_EQ(static_cast<size_t>(csr_first), static_cast<size_t>(first) + 2);
+    ASSERT_EQ(g.get_edge(first).to(), n7);
+    ASSERT_EQ(g.get_edge(csr_first).from(), n1);
+    ASSERT_EQ(g.get_edge(csr_first).to(), n3);
+    ASSERT_EQ(n1.edges().size(), n1_edges + 2);
+
+    ge.pop();
+
+    ASSERT_EQ(g.edge_count(), og_size);
+    ASSERT_EQ(g.max_edge_id(), og_size);
+    ASSERT_EQ(n1.edges().size(), n1_edges);
+    ASSERT_EQ(n7.edges().size(), 1);
+}
+
 TEST(Attribute, rmEdge) {
     GRAPH1
 
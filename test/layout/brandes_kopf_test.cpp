@@ -0,0 +1,121 @@
+#include <triskel/layout/sugiyama/brandes_kopf.hpp>
+
+#include <algorithm>
+
+#include <gtest/gtest.h>
+
+// NOLINTNEXTLINE(google-build-using-namespace)
+using namespace triskel;
+
+namespace {
+auto make_node(float width, bool is_dummy = false) -> BKGraph::Node {
+    return {.width        = width,
+            .left_gutter  = 10.0F,
+            .right_gutter = 10.0F,
+            .is_dummy     = is_dummy};
+}
+
+auto make_segment(size_t upper,
+                  size_t lower,
+                  float upper_port,
+                  float lower_port) -> BKGraph::Segment {
+    return {.upper        = upper,
+            .lower        = lower,
+            .upper_port   = upper_port,
+            .lower_port   = lower_port,
+            .is_alignable = true};
+}
+}  // namespace
+
+TEST(BrandesKopf, StraightEdge) {
+    // a -> b
+    auto graph = BKGraph{};
+    graph.nodes.push_back(make_node(100.0F));
+    graph.nodes.push_back(make_node(40.0F));
+    graph.segments.push_back(make_segment(0, 1, 50.0F, 20.0F));
+    graph.layers = {{0}, {1}};
+
+    const auto xs = brandes_kopf(graph);
+
+    ASSERT_EQ(xs.size(), 2);
+    ASSERT_FLOAT_EQ(xs[0] + 50.0F, xs[1] + 20.0F);
+    ASSERT_FLOAT_EQ(std::min(xs[0], xs[1]), 10.0F);
+}
+
+TEST(BrandesKopf, Separation) {
+    // a -> b, a -> c, b -> d, c -> d
+    auto graph = BKGraph{};
+    graph.nodes.push_back(make_node(100.0F));
+    graph.nodes.push_back(make_node(100.0F));
+    graph.nodes.push_back(make_node(100.0F));
+    graph.nodes.push_back(make_node(100.0F));
+    graph.segments.push_back(make_segment(0, 1, 25.0F, 50.0F));
+    graph.segments.push_back(make_segment(0, 2, 75.0F, 50.0F));
+    graph.segments.push_back(make_segment(1, 3, 50.0F, 25.0F));
+    graph.segments.push_back(make_segment(2, 3, 50.0F, 75.0F));
+    graph.layers = {{0}, {1, 2}, {3}};
+
+    const auto xs = brandes_kopf(graph);
+
+    // b and c do not overlap
+    ASSERT_GE(xs[2] - xs[1], 120.0F);
+
+    // The graph is symmetrical
+    ASSERT_FLOAT_EQ(xs[0], xs[3]);
+    ASSERT_FLOAT_EQ(xs[0] - xs[1], xs[2] - xs[0]);
+}
+
+TEST(BrandesKopf, InnerSegments) {
+    // The long edge a -> d1 -> d2 stays straight next to c -> b -> e
+    auto graph = BKGraph{};
+    graph.nodes.push_back(make_node(100.0F));      // a
+    graph.nodes.push_back(make_node(100.0F));      // c
+    graph.nodes.push_back(make_node(0.0F, true));  // d1
+    graph.nodes.push_back(make_node(100.0F));      // b
+    graph.nodes.push_back(make_node(0.0F, true));  // d2
+    graph.nodes.push_back(make_node(100.0F));      // e
+    graph.segments.push_back(make_segment(0, 2, 50.0F, 0.0F));
+    graph.segments.push_back(make_segment(1, 3, 50.0F, 50.0F));
+    graph.segments.push_back(make_segment(2, 4, 0.0F, 0.0F));
+    graph.segments.push_back(make_segment(3, 5, 50.0F, 50.0F));
+    graph.layers = {{0, 1}, {2, 3}, {4, 5}};
+
+    const auto xs = brandes_kopf(graph);
+
+    ASSERT_FLOAT_EQ(xs[2], xs[4]);
+    ASSERT_FLOAT_EQ(xs[0] + 50.0F, xs[2]);
+}
+
+TEST(BrandesKopf, InnerSegmentConflicts) {
+    // c -> b and b -> e cross the long edge a -> d1 -> d2 -> f, which stays
+    // straight
+    auto graph = BKGraph{};
+    graph.nodes.push_back(make_node(100.0F));      // a
+    graph.nodes.push_back(make_node(100.0F));      // c
+    graph.nodes.push_back(make_node(100.0F));      // b
+    graph.nodes.push_back(make_node(0.0F, true));  // d1
+    graph.nodes.push_back(make_node(0.0F, true));  // d2
+    graph.nodes.push_back(make_node(100.0F));      // e
+    graph.nodes.push_back(make_node(100.0F));      // f
+    graph.segments.push_back(make_segment(0, 3, 50.0F, 0.0F));
+    graph.segments.push_back(make_segment(1, 2, 50.0F, 50.0F));
+    graph.segments.push_back(make_segment(3, 4, 0.0F, 0.0F));
+    graph.segments.push_back(make_segment(2, 5, 50.0F, 50.0F));
+    graph.segments.push_back(make_segment(4, 6, 0.0F, 25.0F));
+    graph.segments.push_back(make_segment(5, 6, 50.0F, 75.0F));
+    graph.layers = {{0, 1}, {2, 3}, {4, 5}, {6}};
+
+    const auto xs = brandes_kopf(graph);
+
+    ASSERT_FLOAT_EQ(xs[3], xs[4]);
+
+    // The nodes of each layer keep their order and their gutters
+    for (const auto& layer : graph.layers) {
+        for (size_t i = 1; i < layer.size(); ++i) {
+            const auto& left  = graph.nodes[layer[i - 1]];
+            const auto& right = graph.nodes[layer[i]];
+            ASSERT_GE(xs[layer[i]], xs[layer[i - 1]] + left.width +
+                                        left.right_gutter + right.left_gutter);
+        }
+    }
+}
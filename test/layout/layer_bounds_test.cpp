@@ -0,0 +1,133 @@
+#include <triskel/layout/sugiyama/layer_bounds.hpp>
+
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <random>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+// NOLINTNEXTLINE(google-build-using-namespace)
+using namespace triskel;
+
+namespace {
+using Item  = LayerBounds::Item;
+using Bound = LayerBounds::Bound;
+
+/// @brief The left bound found by walking the layer
+auto walk_left(const std::vector<Item>& items, size_t id) -> Bound {
+    auto w = 0.0F;
+
+    for (size_t i = id - 1; i < id; --i) {
+        w += items[i].width + (items[i].left_gutter + items[i].right_gutter);
+
+        if (items[i].priority >= items[id].priority) {
+            return {.blocker = i, .offset = w};
+        }
+    }
+    w += items[id].left_gutter;
+
+    return {.blocker = LayerBounds::NO_BLOCKER, .offset = w};
+}
+
+/// @brief The right bound found by walking the layer
+auto walk_right(const std::vector<Item>& items, size_t id) -> Bound {
+    auto w = items[id].width + items[id].right_gutter;
+
+    for (size_t i = id + 1; i < items.size(); ++i) {
+        if (items[i].priority > items[id].priority) {
+            return {.blocker = i, .offset = w};
+        }
+
+        w += items[i].width + (items[i].left_gutter + items[i].right_gutter);
+    }
+
+    return {.blocker = LayerBounds::NO_BLOCKER, .offset = w};
+}
+
+void expect_same_bound(const Bound& actual, const Bound& expected) {
+    EXPECT_EQ(actual.blocker, expected.blocker);
+    EXPECT_EQ(std::bit_cast<uint32_t>(actual.offset),
+              std::bit_cast<uint32_t>(expected.offset));
+}
+
+auto make_layer(std::mt19937& rng,
+                size_t size,
+                const std::function<float()>& make_width) -> std::vector<Item> {
+    auto priorities = std::uniform_int_distribution<int>{0, 3};
+    auto priority   = [&] { return static_cast<uint8_t>(priorities(rng)); };
+
+    auto items = std::vector<Item>{};
+    for (size_t i = 0; i < size; ++i) {
+        items.push_back({.width        = make_width(),
+                         .left_gutter  = make_width(),
+                         .right_gutter = make_width(),
+                         .priority     = priority()});
+    }
+
+    return items;
+}
+
+/// @brief Checks the bounds of random layers against the walk, returns the
+/// number of layers that used the prefix sums
+auto check_random_layers(const std::function<float()>& make_width) -> size_t {
+    auto rng  = std::mt19937{42};
+    auto size = std::uniform_int_distribution<size_t>{1, 64};
+
+    auto exact = size_t{0};
+    for (size_t n = 0; n < 200; ++n) {
+        const auto items  = make_layer(rng, size(rng), make_width);
+        const auto bounds = LayerBounds{items};
+
+        if (bounds.is_exact()) {
+            exact++;
+        }
+
+        for (size_t id = 0; id < items.size(); ++id) {
+            expect_same_bound(bounds.left(id), walk_left(items, id));
+            expect_same_bound(bounds.right(id), walk_right(items, id));
+        }
+    }
+
+    return exact;
+}
+}  // namespace
+
+TEST(LayerBounds, IntegerWidths) {
+    auto rng   = std::mt19937{1};
+    auto width = std::uniform_int_distribution<int>{0, 400};
+
+    ASSERT_EQ(check_random_layers(
+                  [&] { return static_cast<float>(width(rng)); }),
+              200);
+}
+
+TEST(LayerBounds, DyadicWidths) {
+    // Multiples of 1/16
+    auto rng   = std::mt19937{2};
+    auto width = std::uniform_int_distribution<int>{0, 400 * 16};
+
+    ASSERT_EQ(check_random_layers(
+                  [&] { return static_cast<float>(width(rng)) / 16.0F; }),
+              200);
+}
+
+TEST(LayerBounds, FractionalWidths) {
+    // Sums of such widths depend on the order of the additions, the bounds
+    // fall back to the walk
+    auto rng   = std::mt19937{3};
+    auto width = std::uniform_real_distribution<float>{0.0F, 400.0F};
+
+    ASSERT_EQ(check_random_layers([&] { return width(rng); }), 0);
+}
+
+TEST(LayerBounds, LargeWidths) {
+    // Too large for the prefix sums to stay exact with a fractional bit
+    auto rng   = std::mt19937{4};
+    auto width = std::uniform_int_distribution<int>{0, 1 << 20};
+
+    check_random_layers(
+        [&] { return static_cast<float>(width(rng)) + 0.5F; });
+}
@@ -0,0 +1,102 @@
+#include <triskel/layout/sugiyama/vertex_ordering.hpp>
+
+#include <gtest/gtest.h>
+
+#include <triskel/graph/graph.hpp>
+#include <triskel/layout/options.hpp>
+#include <triskel/utils/attribute.hpp>
+
+// NOLINTNEXTLINE(google-build-using-namespace)
+using namespace triskel;
+
+namespace {
+// a -> d and b -> c cross unless one of the two layers is flipped
+void check_no_crossing(LayoutOptions::Ordering strategy) {
+    auto g   = Graph{};
+    auto& ge = g.editor();
+    ge.push();
+
+    auto a = ge.make_node();
+    auto b = ge.make_node();
+    auto c = ge.make_node();
+    auto d = ge.make_node();
+    auto e = ge.make_node();
+
+    ge.make_edge(a, d);
+    ge.make_edge(b, c);
+    ge.make_edge(a, e);
+    ge.make_edge(c, e);
+    ge.commit();
+
+    auto layers = NodeAttribute<size_t>{g, 0};
+    layers.set(c, 1);
+    layers.set(d, 1);
+    layers.set(e, 2);
+
+    const auto ordering = VertexOrdering(g, layers, 3, strategy);
+    const auto& orders  = ordering.orders_;
+
+    // Each layer is a permutation
+    ASSERT_NE(orders.get(a), orders.get(b));
+    ASSERT_NE(orders.get(c), orders.get(d));
+    ASSERT_EQ(orders.get(e), 0);
+
+    // a -> d and b -> c must not cross
+    ASSERT_EQ(orders.get(a) < orders.get(b), orders.get(d) < orders.get(c));
+}
+}  // namespace
+
+TEST(VertexOrdering, MedianTranspose) {
+    check_no_crossing(LayoutOptions::Ordering::MedianTranspose);
+}
+
+TEST(VertexOrdering, Sifting) {
+    check_no_crossing(LayoutOptions::Ordering::Sifting);
+}
+
+// Long edges get a slot on every layer they cross and never cross each other
+TEST(VertexOrdering, Segments) {
+    auto g   = Graph{};
+    auto& ge = g.editor();
+    ge.push();
+
+    auto a = ge.make_node();
+    auto b = ge.make_node();
+    auto c = ge.make_node();
+    auto d = ge.make_node();
+    auto e = ge.make_node();
+
+    auto ad = ge.make_edge(a, d);
+    auto be = ge.make_edge(b, e);
+    ge.make_edge(a, c);
+    ge.commit();
+
+    auto layers = NodeAttribute<size_t>{g, 0};
+    layers.set(c, 1);
+    layers.set(d, 3);
+    layers.set(e, 3);
+
+    const auto ordering = VertexOrdering(g, layers, 4);
+
+    auto position = [&](size_t layer, EdgeId edge) {
+        const auto& slots = ordering.layer_slots_[layer];
+        for (size_t i = 0; i < slots.size(); ++i) {
+            if (slots[i].edge == edge) {
+                return i;
+            }
+        }
+        return slots.size();
+    };
+
+    ASSERT_EQ(ordering.layer_slots_[1].size(), 3);
+    ASSERT_EQ(ordering.layer_slots_[2].size(), 2);
+
+    for (size_t layer = 1; layer < 3; ++layer) {
+        ASSERT_LT(position(layer, ad), ordering.layer_slots_[layer].size());
+        ASSERT_LT(position(layer, be), ordering.layer_slots_[layer].size());
+    }
+
+    // The segments keep the same relative order on every layer
+    ASSERT_EQ(position(1, ad) < position(1, be),
+              position(2, ad) < position(2, be));
+}
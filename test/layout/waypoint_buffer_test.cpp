@@ -0,0 +1,72 @@
+#include <triskel/layout/waypoint_buffer.hpp>
+
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include <triskel/graph/graph.hpp>
+#include <triskel/utils/point.hpp>
+
+// NOLINTNEXTLINE(google-build-using-namespace)
+using namespace triskel;
+
+TEST(WaypointBuffer, AssignAndTranslate) {
+    auto buffer = WaypointBuffer{};
+    const auto a = EdgeId{0};
+    const auto b = EdgeId{1};
+
+    buffer.assign(a, std::vector<Point>{{0, 0}, {0, 10}});
+
+    const auto mark = buffer.mark();
+    buffer.assign(b, std::vector<Point>{{5, 0}, {5, 10}, {8, 10}});
+
+    // Only the waypoints of `b` move
+    buffer.translate(mark, buffer.mark(), {.x = 1, .y = 2});
+
+    ASSERT_EQ(buffer.get(a).size(), 2);
+    ASSERT_EQ(buffer.get(a)[1].y, 10);
+
+    ASSERT_EQ(buffer.get(b).size(), 3);
+    ASSERT_EQ(buffer.get(b).front().x, 6);
+    ASSERT_EQ(buffer.get(b).back().y, 12);
+
+    buffer.scale(2.0F);
+    const auto box = buffer.bounding_box();
+    ASSERT_EQ(box.min.x, 0);
+    ASSERT_EQ(box.max.x, 18);
+    ASSERT_EQ(box.max.y, 24);
+}
+
+TEST(WaypointBuffer, Pack) {
+    auto g   = Graph{};
+    auto& ge = g.editor();
+    ge.push();
+
+    auto n1 = ge.make_node();
+    auto n2 = ge.make_node();
+    auto e1 = ge.make_edge(n1, n2);
+    auto e2 = ge.make_edge(n1, n2);
+
+    auto buffer = WaypointBuffer{};
+    buffer.assign(e1, std::vector<Point>{{0, 0}, {0, 10}});
+    buffer.assign(e2, std::vector<Point>{{0, 0}, {0, 5}, {0, 5}, {0, 10},
+                                         {10, 10}, {10, 0}, {10, 20}});
+
+    // Replaces the waypoints of e1
+    buffer.assign(e1, std::vector<Point>{{1, 0}, {1, 10}});
+
+    buffer.pack(g);
+
+    // The old waypoints of e1 are dropped
+    ASSERT_EQ(buffer.size(), 2 + 5);
+    ASSERT_EQ(buffer.get(e1).front().x, 1);
+
+    // Straight lines are merged, but not when they turn back
+    const auto waypoints = buffer.get(e2).to_vector();
+    ASSERT_EQ(waypoints.size(), 5);
+    ASSERT_EQ(waypoints[1].y, 10);
+    ASSERT_EQ(waypoints[3].y, 0);
+    ASSERT_EQ(waypoints[4].y, 20);
+
+    ge.pop();
+}
@@ -1,11 +1,163 @@
 
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cmath>
+#include <cstddef>
+#include <exception>
+#include <filesystem>
+#include <fstream>
+#include <functional>
+#include <memory>
+#include <ranges>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
 #include <triskel/triskel.hpp>
+#include <triskel/utils/thread_pool.hpp>
 
 #include <gtest/gtest.h>
 
 // NOLINTNEXTLINE(google-build-using-namespace)
 using namespace triskel;
 
+namespace {
+/// @brief Adds a chain of `count` diamonds to `builder`, between a first and
+/// a last node. Each diamond is a SESE region, diamond `i` is made of the
+/// nodes `4i + 1` to `4i + 4`, its head first
+/// @param loops whether each diamond also loops back to its head
+/// @param width the width of each node by id, 100 if empty
+void make_diamond_chain(LayoutBuilder& builder,
+                        size_t count,
+                        bool loops                                = false,
+                        const std::function<float(size_t)>& width = {}) {
+    auto make_node = [&] {
+        const auto node = builder.node_count();
+        return builder.make_node(100, width ? width(node) : 100);
+    };
+
+    auto previous = make_node();
+    for (size_t i = 0; i < count; ++i) {
+        const auto a = make_node();
+        const auto b = make_node();
+        const auto c = make_node();
+        const auto d = make_node();
+
+        builder.make_edge(previous, a);
+        builder.make_edge(a, b);
+        builder.make_edge(a, c);
+        builder.make_edge(b, d);
+        builder.make_edge(c, d);
+
+        if (loops) {
+            builder.make_edge(d, a);
+        }
+
+        previous = d;
+    }
+
+    builder.make_edge(previous, make_node());
+}
+
+/// @brief Checks that `actual` places the nodes and the edges of `expected`
+/// as it does
+void expect_same_layout(const CFGLayout& expected, const CFGLayout& actual) {
+    ASSERT_EQ(expected.node_count(), actual.node_count());
+    for (size_t node = 0; node < expected.node_count(); ++node) {
+        ASSERT_EQ(expected.get_coords(node), actual.get_coords(node));
+    }
+
+    for (size_t edge = 0; edge < expected.edge_count(); ++edge) {
+        ASSERT_EQ(expected.get_waypoints(edge).to_vector(),
+                  actual.get_waypoints(edge).to_vector());
+    }
+}
+
+using Edges = std::vector<std::pair<size_t, size_t>>;
+
+/// @brief Adds a loop around two layers of `count` nodes each, connected by
+/// `links`
+/// @param links the edges from the first layer to the second one, as indexes
+/// in each layer
+/// @return The edges from the first layer to the second one
+auto make_two_layers(LayoutBuilder& builder, size_t count, const Edges& links)
+    -> Edges {
+    const auto entry = builder.make_node(100, 100);
+    const auto exit  = builder.make_node(100, 100);
+
+    const auto sources = builder.node_count();
+    for (size_t i = 0; i < 2 * count; ++i) {
+        builder.make_node(100, 100);
+    }
+    const auto targets = sources + count;
+
+    auto edges = Edges{};
+    for (auto [from, to] : links) {
+        edges.emplace_back(sources + from, targets + to);
+    }
+
+    for (size_t i = 0; i < count; ++i) {
+        builder.make_edge(entry, sources + i);
+        builder.make_edge(targets + i, exit);
+    }
+
+    for (auto [from, to] : edges) {
+        builder.make_edge(from, to);
+    }
+
+    builder.make_edge(exit, entry);
+    return edges;
+}
+
+/// @brief Adds a loop around two layers of `count` nodes each, the nodes of
+/// the first layer jump to the second one out of order
+/// @return The edges from the first layer to the second one
+auto make_tangle(LayoutBuilder& builder, size_t count) -> Edges {
+    auto links = Edges{};
+    for (size_t i = 0; i < count; ++i) {
+        links.emplace_back(i, (2 * i) % count);
+        links.emplace_back(i, (i + (count / 2)) % count);
+    }
+
+    return make_two_layers(builder, count, links);
+}
+
+/// @brief The number of pairs of `edges` whose ends are in opposite orders
+/// on their layers
+auto count_crossings(const CFGLayout& layout, const Edges& edges) -> size_t {
+    auto crossings = size_t{0};
+    for (size_t i = 0; i < edges.size(); ++i) {
+        for (size_t j = i + 1; j < edges.size(); ++j) {
+            const auto from = layout.get_coords(edges[i].first).x -
+                              layout.get_coords(edges[j].first).x;
+            const auto to = layout.get_coords(edges[i].second).x -
+                            layout.get_coords(edges[j].second).x;
+            if ((from < 0 && to > 0) || (from > 0 && to < 0)) {
+                crossings++;
+            }
+        }
+    }
+
+    return crossings;
+}
+
+/// @brief Checks that every edge is made of horizontal and vertical lines
+void expect_orthogonal_waypoints(const CFGLayout& layout) {
+    for (size_t edge = 0; edge < layout.edge_count(); ++edge) {
+        const auto& waypoints = layout.get_waypoints(edge);
+        ASSERT_GE(waypoints.size(), 2);
+
+        for (size_t i = 1; i < waypoints.size(); ++i) {
+            ASSERT_TRUE(waypoints[i - 1].x == waypoints[i].x ||
+                        waypoints[i - 1].y == waypoints[i].y);
+        }
+    }
+}
+}  // namespace
+
 TEST(Triskel, Smoke1) {
     auto builder = make_layout_builder();
 
@@ -30,3 +182,1002 @@ TEST(Triskel, Smoke1) {
 
     ASSERT_NO_THROW(const auto layout = builder->build());
 }
+
+TEST(Triskel, Sifting) {
+    // Moving a single node far across its layer removes crossings that the
+    // median and transpose passes leave
+    const auto links = Edges{
+        {0, 6}, {1, 5}, {2, 2}, {3, 3}, {4, 7}, {5, 9}, {6, 4}, {7, 0},
+        {8, 8}, {9, 1}, {7, 9}, {5, 8}, {5, 7}, {6, 0}, {1, 9}, {0, 7},
+        {9, 5}, {7, 2}, {3, 8}, {8, 1}, {0, 1}, {9, 4}, {0, 2},
+    };
+
+    auto edges       = Edges{};
+    auto make_layout = [&](LayoutOptions::Ordering ordering) {
+        auto builder = make_layout_builder(LayoutOptions{.ordering = ordering});
+        edges        = make_two_layers(*builder, 10, links);
+        return builder->build();
+    };
+
+    const auto median  = make_layout(LayoutOptions::Ordering::MedianTranspose);
+    const auto sifting = make_layout(LayoutOptions::Ordering::Sifting);
+
+    const auto crossings = count_crossings(*median, edges);
+    ASSERT_GT(crossings, 0);
+    ASSERT_LT(count_crossings(*sifting, edges), crossings);
+}
+
+TEST(Triskel, BrandesKopf) {
+    auto builder = make_layout_builder(
+        LayoutOptions{.coordinates = LayoutOptions::Coordinates::BrandesKopf});
+
+    // A tangle followed by a chain of loops
+    make_tangle(*builder, 7);
+    const auto chain = builder->node_count();
+    make_diamond_chain(*builder, 4, true);
+    builder->make_edge(1, chain);
+
+    // A long edge next to a path of 5 nodes
+    const auto last = builder->node_count() - 1;
+    auto path       = std::vector<size_t>{};
+    for (size_t i = 0; i < 5; ++i) {
+        path.push_back(builder->make_node(100, 100));
+    }
+    builder->make_edge(last, path.front());
+    for (size_t i = 1; i < path.size(); ++i) {
+        builder->make_edge(path[i - 1], path[i]);
+    }
+    const auto long_edge = builder->make_edge(path.front(), path.back());
+
+    const auto layout = builder->build();
+    const auto rects  = layout->node_rects();
+
+    expect_orthogonal_waypoints(*layout);
+
+    // The long edge crosses the layers of the inner nodes of the path in a
+    // single vertical line
+    const auto top    = rects[path[1]].y;
+    const auto bottom = rects[path[3]].y + rects[path[3]].height;
+
+    const auto& waypoints = layout->get_waypoints(long_edge);
+    auto is_vertical      = false;
+    for (size_t i = 1; i < waypoints.size(); ++i) {
+        const auto from = waypoints[i - 1];
+        const auto to   = waypoints[i];
+
+        is_vertical = is_vertical ||
+                      (from.x == to.x && std::min(from.y, to.y) <= top &&
+                       bottom <= std::max(from.y, to.y));
+    }
+    ASSERT_TRUE(is_vertical);
+
+    // The nodes sharing a layer don't overlap
+    for (size_t i = 0; i < rects.size(); ++i) {
+        for (size_t j = i + 1; j < rects.size(); ++j) {
+            if (rects[i].y != rects[j].y) {
+                continue;
+            }
+
+            ASSERT_TRUE(rects[i].x + rects[i].width <= rects[j].x ||
+                        rects[j].x + rects[j].width <= rects[i].x);
+        }
+    }
+}
+
+TEST(Triskel, EdgeConcentration) {
+    auto builder =
+        make_layout_builder(LayoutOptions{.concentration_threshold = 3});
+
+    const auto a = builder->make_node(100, 100);
+    const auto z = builder->make_node(100, 100);
+
+    // A switch whose cases all jump to `z`
+    for (size_t i = 0; i < 6; ++i) {
+        const auto b = builder->make_node(100, 100);
+        builder->make_edge(a, b);
+        builder->make_edge(b, z);
+    }
+
+    // Parallel edges
+    builder->make_edge(a, z);
+    builder->make_edge(a, z);
+
+    const auto layout = builder->build();
+
+    const auto& stats = layout->get_stats();
+    ASSERT_GT(stats.phantom_count, 0);
+    ASSERT_EQ(stats.concentrated_edges, 8);
+
+    const auto target = layout->get_coords(z);
+
+    expect_orthogonal_waypoints(*layout);
+
+    // The edges to `z` end on `z`
+    for (size_t edge = 0; edge < layout->edge_count(); ++edge) {
+        if (edge % 2 == 0 && edge < 12) {
+            continue;
+        }
+
+        ASSERT_EQ(layout->get_waypoints(edge).back().y, target.y);
+    }
+}
+
+namespace {
+/// @brief Counts the tasks it runs
+struct CountingExecutor : InlineExecutor {
+    void submit(Task task) override {
+        tasks++;
+        InlineExecutor::submit(std::move(task));
+    }
+
+    size_t tasks = 0;
+};
+}  // namespace
+
+TEST(Triskel, ParallelRegions) {
+    auto make_layout = [](size_t threads, Executor* executor = nullptr) {
+        auto builder = make_layout_builder(
+            LayoutOptions{.threads = threads, .executor = executor});
+        make_diamond_chain(*builder, 8, true);
+        return builder->build();
+    };
+
+    auto executor = CountingExecutor{};
+    auto pool     = ThreadPool{1};
+
+    const auto serial = make_layout(0);
+    for (const auto& parallel :
+         {make_layout(4), make_layout(4, &executor), make_layout(4, &pool)}) {
+        expect_same_layout(*serial, *parallel);
+    }
+
+    // The regions were laid out by the given executor
+    ASSERT_GT(executor.tasks, 0);
+}
+
+TEST(Triskel, LayoutCache) {
+    auto make_layout = [](bool cache_regions) {
+        auto builder = make_layout_builder(
+            LayoutOptions{.cache_regions = cache_regions});
+
+        // Identical diamonds, whose sides have different widths
+        make_diamond_chain(*builder, 6, false, [](size_t node) {
+            return node % 4 == 2 ? 50.0F : 100.0F;
+        });
+
+        return builder->build();
+    };
+
+    LayoutCache::global().clear();
+
+    const auto reference = make_layout(false);
+    const auto cached    = make_layout(true);
+
+    ASSERT_GT(cached->get_stats().cache_hits, 0);
+
+    // Laying the same graph out again only hits the cache
+    const auto again = make_layout(true);
+    ASSERT_EQ(again->get_stats().cache_misses, 0);
+
+    expect_same_layout(*reference, *cached);
+    expect_same_layout(*reference, *again);
+}
+
+TEST(Triskel, LayoutCacheIdOrder) {
+    // Two identical diamonds between a first and a last node, the nodes of the
+    // second one are created in the reverse order
+    auto builder =
+        make_layout_builder(LayoutOptions{.cache_regions = true});
+
+    const auto first = builder->make_node(100, 100);
+
+    auto diamonds = std::array<std::array<size_t, 4>, 2>{};
+    for (auto& diamond : diamonds) {
+        const auto reversed = &diamond == &diamonds.back();
+        for (size_t i = 0; i < diamond.size(); ++i) {
+            const auto side = reversed ? diamond.size() - 1 - i : i;
+            diamond[side]   = builder->make_node(100, side == 1 ? 50 : 100);
+        }
+    }
+
+    auto previous = first;
+    for (const auto& [a, b, c, d] : diamonds) {
+        builder->make_edge(previous, a);
+        builder->make_edge(a, b);
+        builder->make_edge(a, c);
+        builder->make_edge(b, d);
+        builder->make_edge(c, d);
+        previous = d;
+    }
+    builder->make_edge(previous, builder->make_node(100, 100));
+
+    LayoutCache::global().clear();
+    const auto layout = builder->build();
+
+    // The second diamond reuses the layout of the first one
+    ASSERT_GT(layout->get_stats().cache_hits, 0);
+
+    // The nodes of both diamonds are placed the same way around their head
+    auto relative = [&layout](const std::array<size_t, 4>& diamond, size_t i) {
+        const auto node = layout->get_coords(diamond[i]);
+        const auto head = layout->get_coords(diamond[0]);
+        return std::pair{node.x - head.x, node.y - head.y};
+    };
+
+    for (size_t i = 1; i < 4; ++i) {
+        const auto [x, y]                   = relative(diamonds.front(), i);
+        const auto [reversed_x, reversed_y] = relative(diamonds.back(), i);
+        ASSERT_FLOAT_EQ(x, reversed_x);
+        ASSERT_FLOAT_EQ(y, reversed_y);
+    }
+}
+
+TEST(Triskel, UpdateNodeSize) {
+    constexpr size_t resized = 10;
+
+    auto make_layout = [](float width) {
+        auto builder = make_layout_builder();
+        make_diamond_chain(*builder, 6, false, [width](size_t node) {
+            return node == resized ? width : 100.0F;
+        });
+        return builder->build();
+    };
+
+    auto updated      = make_layout(100);
+    const auto fresh  = make_layout(300);
+    const auto before = updated->get_stats().region_layouts;
+
+    updated->update_node_size(resized, 300, 100);
+
+    // Only the regions around the node were laid out again
+    ASSERT_LT(updated->get_stats().region_layouts, before);
+    ASSERT_EQ(fresh->get_stats().region_layouts, before);
+
+    expect_same_layout(*fresh, *updated);
+
+    ASSERT_THROW(updated->update_node_size(fresh->node_count(), 1, 1),
+                 std::invalid_argument);
+}
+
+TEST(Triskel, EditGraph) {
+    auto make_layout = [](size_t node_count, const Edges& edges) {
+        auto builder = make_layout_builder();
+
+        for (size_t i = 0; i < node_count; ++i) {
+            builder->make_node(100, 100);
+        }
+
+        for (auto [from, to] : edges) {
+            builder->make_edge(from, to);
+        }
+
+        return builder->build();
+    };
+
+    // The chain of `make_diamond_chain`, as edges
+    auto edges = Edges{};
+    for (size_t i = 0; i < 6; ++i) {
+        const auto a = 1 + (4 * i);
+
+        edges.emplace_back(a - 1, a);
+        edges.emplace_back(a, a + 1);
+        edges.emplace_back(a, a + 2);
+        edges.emplace_back(a + 1, a + 3);
+        edges.emplace_back(a + 2, a + 3);
+    }
+    edges.emplace_back(24, 25);
+
+    const auto original = make_layout(26, edges);
+    auto edited         = make_layout(26, edges);
+    const auto total    = edited->get_stats().region_layouts;
+
+    // An edge inside the third diamond
+    const auto edge = edited->add_edge(10, 11);
+    ASSERT_EQ(edge, edges.size());
+    ASSERT_LT(edited->get_stats().region_layouts, total);
+
+    auto added = edges;
+    added.emplace_back(10, 11);
+    expect_same_layout(*make_layout(26, added), *edited);
+
+    edited->remove_edge(edge);
+    expect_same_layout(*original, *edited);
+    ASSERT_THROW(edited->remove_edge(edge), std::invalid_argument);
+
+    // The head of the third diamond is split
+    auto split_layout = make_layout(26, edges);
+    ASSERT_EQ(split_layout->split_node(9), 26);
+
+    auto split_edges      = edges;
+    split_edges[11].first = 26;
+    split_edges[12].first = 26;
+    split_edges.emplace_back(9, 26);
+    expect_same_layout(*make_layout(27, split_edges), *split_layout);
+}
+
+namespace {
+/// @brief Measures the text with a fixed size per character
+struct FixedWidthRenderer : Renderer {
+    explicit FixedWidthRenderer(float char_width) : char_width{char_width} {}
+
+    void draw_line(Point /*start*/,
+                   Point /*end*/,
+                   const StrokeStyle& /*style*/) override {}
+
+    void draw_triangle(Point /*v1*/,
+                       Point /*v2*/,
+                       Point /*v3*/,
+                       Color /*fill*/) override {}
+
+    void draw_rectangle(Point /*tl*/,
+                        float /*width*/,
+                        float /*height*/,
+                        Color /*fill*/) override {}
+
+    void draw_rectangle_border(Point /*tl*/,
+                               float /*width*/,
+                               float /*height*/,
+                               const StrokeStyle& /*style*/) override {}
+
+    void draw_text(Point /*tl*/,
+                   const std::string& /*text*/,
+                   const TextStyle& /*style*/) override {}
+
+    [[nodiscard]] auto measure_text(const std::string& text,
+                                    const TextStyle& /*style*/) const
+        -> Point override {
+        return {.x = char_width * static_cast<float>(text.size()),
+                .y = 2 * char_width};
+    }
+
+    float char_width;
+};
+}  // namespace
+
+TEST(Triskel, MeasureNodes) {
+    auto make_layout = [](const Renderer& renderer) {
+        auto builder = make_layout_builder();
+
+        // Nested loops and diamonds with labels of different lengths
+        const auto labels = std::vector<std::string>{
+            "entry", "loop", "a", "long label", "bb", "exit", "end"};
+        for (const auto& label : labels) {
+            builder->make_node(renderer, label);
+        }
+
+        builder->make_edge(0, 1);
+        builder->make_edge(1, 2);
+        builder->make_edge(1, 3);
+        builder->make_edge(2, 4);
+        builder->make_edge(3, 4);
+        builder->make_edge(4, 1);
+        builder->make_edge(4, 5);
+        builder->make_edge(5, 6);
+        builder->make_edge(0, 6);
+
+        return builder->build();
+    };
+
+    const auto small = FixedWidthRenderer{5};
+    const auto large = FixedWidthRenderer{40};
+
+    auto layout      = make_layout(small);
+    const auto fresh = make_layout(large);
+
+    layout->measure_nodes(large);
+    expect_same_layout(*fresh, *layout);
+
+    ASSERT_EQ(fresh->get_width(), layout->get_width());
+    ASSERT_EQ(fresh->get_height(), layout->get_height());
+}
+
+TEST(Triskel, WarmStart) {
+    auto make_builder = [](bool bypass) {
+        auto builder =
+            make_layout_builder(LayoutOptions{.warm_start_max_shift = 0});
+        make_diamond_chain(*builder, 6);
+
+        // A long edge across the third diamond
+        if (bypass) {
+            builder->make_edge(9, 12);
+        }
+
+        return builder;
+    };
+
+    const auto previous = make_builder(false)->build();
+
+    auto node_map = std::vector<size_t>(previous->node_count());
+    for (size_t node = 0; node < node_map.size(); ++node) {
+        node_map[node] = node;
+    }
+
+    auto builder = make_builder(true);
+    builder->warm_start(*previous, node_map);
+    const auto layout = builder->build();
+
+    // Only the third diamond and the root are laid out again
+    ASSERT_EQ(layout->get_stats().region_layouts, 2);
+
+    // The nodes of the third diamond kept their order
+    ASSERT_EQ(previous->get_coords(10).x < previous->get_coords(11).x,
+              layout->get_coords(10).x < layout->get_coords(11).x);
+
+    // The node map refers to a missing node, the builder is left as it was
+    const auto cold = make_builder(true)->build();
+
+    node_map.back() = previous->node_count();
+    builder         = make_builder(true);
+    ASSERT_THROW(builder->warm_start(*previous, node_map),
+                 std::invalid_argument);
+    ASSERT_EQ(builder->build()->get_stats().region_layouts,
+              cold->get_stats().region_layouts);
+}
+
+TEST(Triskel, WarmStartCache) {
+    auto make_layout = [](bool bypass, const CFGLayout* previous,
+                          bool cache_regions) {
+        auto builder = make_layout_builder(LayoutOptions{
+            .cache_regions = cache_regions, .warm_start_max_shift = 0});
+        make_diamond_chain(*builder, 6);
+
+        // A long edge across the third diamond
+        if (bypass) {
+            builder->make_edge(9, 12);
+        }
+
+        if (previous != nullptr) {
+            auto node_map = std::vector<size_t>(previous->node_count());
+            for (size_t node = 0; node < node_map.size(); ++node) {
+                node_map[node] = node;
+            }
+
+            builder->warm_start(*previous, node_map);
+        }
+
+        return builder->build();
+    };
+
+    const auto previous = make_layout(false, nullptr, false);
+    const auto cold     = make_layout(true, nullptr, false);
+    const auto warm     = make_layout(true, previous.get(), false);
+
+    // A warm layout doesn't fill the cache for the cold ones
+    LayoutCache::global().clear();
+    expect_same_layout(*warm, *make_layout(true, previous.get(), true));
+    expect_same_layout(*cold, *make_layout(true, nullptr, true));
+
+    // And doesn't read what the cold ones left in it
+    LayoutCache::global().clear();
+    expect_same_layout(*cold, *make_layout(true, nullptr, true));
+    expect_same_layout(*warm, *make_layout(true, previous.get(), true));
+}
+
+TEST(Triskel, Deadline) {
+    auto make_layout = [](const LayoutOptions& options) {
+        auto builder = make_layout_builder(options);
+        make_diamond_chain(*builder, 4);
+        return builder->build();
+    };
+
+    const auto layout = make_layout({});
+    ASSERT_FALSE(layout->get_stats().truncated);
+
+    // The deadline has already passed, the layout still completes
+    const auto truncated = make_layout(
+        LayoutOptions{.deadline = LayoutOptions::Clock::now()});
+    ASSERT_TRUE(truncated->get_stats().truncated);
+    ASSERT_EQ(truncated->node_count(), layout->node_count());
+
+    for (size_t node = 0; node < truncated->node_count(); ++node) {
+        ASSERT_TRUE(std::isfinite(truncated->get_coords(node).x));
+        ASSERT_TRUE(std::isfinite(truncated->get_coords(node).y));
+    }
+
+    for (size_t edge = 0; edge < truncated->edge_count(); ++edge) {
+        ASSERT_GE(truncated->get_waypoints(edge).size(), 2);
+    }
+
+    // A large budget doesn't stop the layout
+    const auto budget = make_layout(
+        LayoutOptions{.budget = std::chrono::hours{1}});
+    ASSERT_FALSE(budget->get_stats().truncated);
+    ASSERT_EQ(budget->get_coords(5).x, layout->get_coords(5).x);
+
+    // An update after the budget of the build has run out gets its own
+    auto updated = make_layout(
+        LayoutOptions{.budget = std::chrono::milliseconds{200}});
+    std::this_thread::sleep_for(std::chrono::milliseconds{250});
+    updated->update_node_size(0, 2.0F, 2.0F);
+    ASSERT_FALSE(updated->get_stats().truncated);
+}
+
+namespace {
+/// @brief Runs the tasks on another thread once waited for
+struct DeferredExecutor : Executor {
+    void submit(Task task) override { tasks.push_back(std::move(task)); }
+
+    void wait() override {
+        auto thread = std::thread{[this] {
+            for (const auto& task : tasks) {
+                task();
+            }
+        }};
+        thread.join();
+        tasks.clear();
+    }
+
+    [[nodiscard]] auto concurrency() const -> size_t override { return 1; }
+
+    std::vector<Task> tasks;
+};
+}  // namespace
+
+TEST(Triskel, BuildAsync) {
+    auto make_builder = [] {
+        auto builder = make_layout_builder();
+        make_diamond_chain(*builder, 4);
+        return builder;
+    };
+
+    // Runs the tasks later, on another thread
+    auto executor  = DeferredExecutor{};
+    auto run_tasks = [&executor] { executor.wait(); };
+
+    auto phases = std::vector<std::pair<LayoutPhase, float>>{};
+    auto future = make_builder()->build_async(
+        executor, {}, [&phases](LayoutPhase phase, float fraction) {
+            phases.emplace_back(phase, fraction);
+        });
+    run_tasks();
+
+    const auto layout = future.get();
+    const auto sync   = make_builder()->build();
+    ASSERT_EQ(layout->get_coords(5).x, sync->get_coords(5).x);
+
+    // The phases come in order and end with the edges
+    ASSERT_FALSE(phases.empty());
+    ASSERT_TRUE(std::ranges::is_sorted(phases));
+    ASSERT_EQ(phases.back(), std::pair(LayoutPhase::Edges, 1.0F));
+
+    // Cancelled before it starts
+    auto token = CancellationToken{};
+    future     = make_builder()->build_async(executor, token, {});
+    token.cancel();
+    run_tasks();
+    ASSERT_THROW(future.get(), LayoutCancelled);
+
+    // Cancelled once the first region is laid out
+    token  = CancellationToken{};
+    future = make_builder()->build_async(
+        executor, token, [&token](LayoutPhase phase, float fraction) {
+            if (phase == LayoutPhase::Nodes && fraction > 0.0F) {
+                token.cancel();
+            }
+        });
+    run_tasks();
+    ASSERT_THROW(future.get(), LayoutCancelled);
+}
+
+TEST(Triskel, LayoutBatch) {
+    auto make_builder = [](size_t size) {
+        auto builder = make_layout_builder();
+        make_diamond_chain(*builder, size);
+        return builder;
+    };
+
+    const auto sizes = std::vector<size_t>{1, 6, 3, 0, 8, 2};
+
+    auto builders = std::vector<std::unique_ptr<LayoutBuilder>>{};
+    for (auto size : sizes) {
+        builders.push_back(make_builder(size));
+    }
+    builders.push_back(nullptr);
+
+    auto pool          = ThreadPool{3};
+    const auto results = layout_batch(builders, {.executor = &pool});
+    ASSERT_EQ(results.size(), sizes.size() + 1);
+
+    for (size_t i = 0; i < sizes.size(); ++i) {
+        ASSERT_TRUE(results[i].ok());
+
+        expect_same_layout(*make_builder(sizes[i])->build(),
+                           *results[i].layout);
+    }
+
+    // The missing builder fails alone
+    ASSERT_FALSE(results.back().ok());
+    ASSERT_THROW(std::rethrow_exception(results.back().error),
+                 std::invalid_argument);
+}
+
+TEST(Triskel, LayoutContext) {
+    auto make_builder = [](const LayoutOptions& options) {
+        auto builder = make_layout_builder(options);
+        make_diamond_chain(*builder, 6, true);
+        return builder;
+    };
+
+    const auto heap = make_builder({})->build();
+    ASSERT_GT(heap->get_stats().scratch_allocations, 0);
+    ASSERT_EQ(heap->get_stats().scratch_heap_allocations,
+              heap->get_stats().scratch_allocations);
+
+    auto context = LayoutContext{};
+
+    const auto first = make_builder({})->build(context);
+    ASSERT_FALSE(context.in_use());
+    ASSERT_GT(context.capacity(), 0);
+    ASSERT_EQ(first->get_stats().scratch_allocations,
+              heap->get_stats().scratch_allocations);
+    ASSERT_LT(first->get_stats().scratch_heap_allocations,
+              first->get_stats().scratch_allocations);
+
+    // The memory of the first layout is reused
+    const auto second = make_builder({})->build(context);
+    ASSERT_EQ(second->get_stats().scratch_allocations,
+              heap->get_stats().scratch_allocations);
+    ASSERT_EQ(second->get_stats().scratch_heap_allocations, 0);
+
+    // The region tasks of other threads don't use the context
+    const auto parallel = make_builder({.threads = 4})->build(context);
+
+    for (const auto* layout : {first.get(), second.get(), parallel.get()}) {
+        expect_same_layout(*heap, *layout);
+    }
+
+    // A context serves one layout at a time
+    [[maybe_unused]] auto* resource = context.begin();
+    ASSERT_THROW(auto layout = make_builder({})->build(context),
+                 std::invalid_argument);
+    context.end();
+
+    context.release();
+    ASSERT_EQ(context.capacity(), 0);
+}
+
+TEST(Triskel, FreezeLayout) {
+    auto builder = make_layout_builder();
+
+    const auto a = builder->make_node("a");
+    const auto b = builder->make_node("bb\nbb");
+    const auto c = builder->make_node("c");
+    const auto d = builder->make_node("");
+
+    builder->make_edge(a, b, LayoutBuilder::EdgeType::True);
+    builder->make_edge(a, c, LayoutBuilder::EdgeType::False);
+    builder->make_edge(b, d);
+    const auto removed = builder->make_edge(c, d);
+    builder->make_edge(c, b);
+
+    auto layout = builder->build();
+    layout->remove_edge(removed);
+
+    const auto frozen = layout->freeze();
+    ASSERT_EQ(frozen.node_count(), layout->node_count());
+    ASSERT_EQ(frozen.edge_count(), 5);
+    ASSERT_EQ(layout->edge_count(), frozen.edge_count());
+    ASSERT_EQ(frozen.get_width(), layout->get_width());
+    ASSERT_EQ(frozen.get_height(), layout->get_height());
+
+    ASSERT_EQ(frozen.get_label(b), "bb\nbb");
+    ASSERT_EQ(frozen.get_label(d), "");
+    ASSERT_EQ(frozen.get_rect(b).width, 2);
+    ASSERT_EQ(frozen.get_edge_type(0), LayoutBuilder::EdgeType::True);
+    ASSERT_EQ(frozen.get_edge_type(1), LayoutBuilder::EdgeType::False);
+    ASSERT_TRUE(frozen.get_waypoints(removed).empty());
+    ASSERT_THROW((void)frozen.get_rect(4), std::invalid_argument);
+    ASSERT_THROW((void)frozen.get_waypoints(5), std::invalid_argument);
+
+    const auto points = frozen.node_count() * sizeof(Rect);
+    ASSERT_GT(frozen.footprint(), points);
+
+    auto coords    = std::vector<Point>{};
+    auto waypoints = std::vector<std::vector<Point>>{};
+    for (size_t node = 0; node < layout->node_count(); ++node) {
+        coords.push_back(layout->get_coords(node));
+    }
+    for (size_t edge = 0; edge < frozen.edge_count(); ++edge) {
+        waypoints.push_back(layout->get_waypoints(edge).to_vector());
+    }
+
+    // The layout can be read from several threads
+    auto matches = std::vector<char>(4, 0);
+    {
+        auto threads = std::vector<std::jthread>{};
+        for (size_t t = 0; t < matches.size(); ++t) {
+            threads.emplace_back([&, t, copy = frozen] {
+                auto match = true;
+                for (size_t node = 0; node < copy.node_count(); ++node) {
+                    match = match && copy.get_coords(node) == coords[node];
+                }
+
+                for (size_t edge = 0; edge < copy.edge_count(); ++edge) {
+                    match = match && copy.get_waypoints(edge).to_vector() ==
+                                         waypoints[edge];
+                }
+
+                matches[t] = static_cast<char>(match);
+            });
+        }
+    }
+
+    ASSERT_TRUE(std::ranges::all_of(matches, [](char m) { return m != 0; }));
+}
+
+TEST(Triskel, BulkAccessors) {
+    auto builder = make_layout_builder();
+
+    const auto a = builder->make_node(10, 20);
+    const auto b = builder->make_node(30, 40);
+    const auto c = builder->make_node(10, 10);
+
+    builder->make_edge(a, b, LayoutBuilder::EdgeType::True);
+    builder->make_edge(a, c, LayoutBuilder::EdgeType::False);
+    builder->make_edge(b, c);
+
+    auto layout = builder->build();
+
+    const auto check = [&] {
+        const auto rects   = layout->node_rects();
+        const auto offsets = layout->waypoint_offsets();
+        const auto points  = layout->waypoints();
+
+        ASSERT_EQ(rects.size(), layout->node_count());
+        ASSERT_EQ(offsets.size(), layout->edge_types().size() + 1);
+        ASSERT_EQ(offsets.back(), points.size());
+
+        for (size_t node = 0; node < rects.size(); ++node) {
+            const auto coords = layout->get_coords(node);
+            ASSERT_EQ(rects[node].x, coords.x);
+            ASSERT_EQ(rects[node].y, coords.y);
+        }
+
+        for (size_t edge = 0; edge + 1 < offsets.size(); ++edge) {
+            const auto size        = offsets[edge + 1] - offsets[edge];
+            const auto edge_points = points.subspan(offsets[edge], size);
+            ASSERT_TRUE(std::ranges::equal(
+                edge_points, layout->get_waypoints(edge).to_vector()));
+        }
+    };
+
+    check();
+    ASSERT_EQ(layout->node_rects()[b].height, 30);
+    ASSERT_EQ(layout->edge_types()[0], LayoutBuilder::EdgeType::True);
+    ASSERT_EQ(layout->edge_types()[2], LayoutBuilder::EdgeType::Default);
+
+    // Edits refresh the views
+    layout->update_node_size(b, 50, 60);
+    ASSERT_EQ(layout->node_rects()[b].width, 50);
+    check();
+
+    layout->add_edge(b, a);
+    ASSERT_EQ(layout->edge_types().size(), 4);
+    check();
+}
+
+TEST(Triskel, BulkIngestion) {
+    const auto widths  = std::vector<float>{10, 20, 30, 40, 50};
+    const auto heights = std::vector<float>{15, 25, 35, 45, 55};
+    const auto from    = std::vector<size_t>{0, 0, 1, 2, 3, 3};
+    const auto to      = std::vector<size_t>{1, 2, 3, 3, 4, 0};
+    const auto types   = std::vector<LayoutBuilder::EdgeType>{
+        LayoutBuilder::EdgeType::True,    LayoutBuilder::EdgeType::False,
+        LayoutBuilder::EdgeType::Default, LayoutBuilder::EdgeType::Default,
+        LayoutBuilder::EdgeType::True,    LayoutBuilder::EdgeType::False};
+
+    auto one_by_one = make_layout_builder();
+    for (size_t node = 0; node < widths.size(); ++node) {
+        one_by_one->make_node(heights[node], widths[node]);
+    }
+    for (size_t edge = 0; edge < from.size(); ++edge) {
+        one_by_one->make_edge(from[edge], to[edge], types[edge]);
+    }
+
+    auto bulk = make_layout_builder();
+    bulk->reserve(widths.size(), from.size());
+    ASSERT_EQ(bulk->make_nodes(widths.size(), widths, heights), 0);
+    ASSERT_EQ(bulk->make_edges(from, to, types), 0);
+    ASSERT_EQ(bulk->node_count(), 5);
+    ASSERT_EQ(bulk->edge_count(), 6);
+
+    ASSERT_THROW(bulk->make_nodes(2, widths, heights), std::invalid_argument);
+    ASSERT_THROW(bulk->make_edges(from, std::vector<size_t>{1}),
+                 std::invalid_argument);
+    ASSERT_THROW(bulk->make_edges(std::vector<size_t>{0},
+                                  std::vector<size_t>{5}),
+                 std::invalid_argument);
+    ASSERT_EQ(bulk->edge_count(), 6);
+
+    const auto expected = one_by_one->build();
+    const auto layout   = bulk->build();
+    ASSERT_EQ(layout->get_width(), expected->get_width());
+    ASSERT_EQ(layout->get_height(), expected->get_height());
+    for (size_t edge = 0; edge < from.size(); ++edge) {
+        ASSERT_EQ(layout->get_waypoints(edge).to_vector(),
+                  expected->get_waypoints(edge).to_vector());
+    }
+    ASSERT_TRUE(std::ranges::equal(layout->edge_types(), types));
+
+    // The same graph in CSR form, with the default sizes
+    const auto offsets = std::vector<size_t>{0, 2, 3, 4, 6, 6};
+    auto csr           = make_layout_builder(offsets, to, types);
+    ASSERT_EQ(csr->node_count(), 5);
+    ASSERT_EQ(csr->edge_count(), 6);
+    ASSERT_NO_THROW(const auto csr_layout = csr->build());
+
+    ASSERT_THROW(auto b = make_layout_builder(std::vector<size_t>{0, 3}, to),
+                 std::invalid_argument);
+}
+
+TEST(Triskel, DiskCache) {
+    const auto directory =
+        std::filesystem::temp_directory_path() /
+        ("triskel_test_cache_" + std::to_string(std::hash<std::thread::id>{}(
+                                     std::this_thread::get_id())));
+    std::filesystem::remove_all(directory);
+
+    auto cache   = DiskCache{directory};
+    auto options = LayoutOptions{.disk_cache = &cache};
+
+    const auto make_builder = [&](float width, const std::string& label = "a") {
+        auto builder = make_layout_builder(options);
+
+        const auto a = builder->make_node(label);
+        const auto b = builder->make_node(20, width);
+        const auto c = builder->make_node("c");
+
+        builder->make_edge(a, b, LayoutBuilder::EdgeType::True);
+        builder->make_edge(a, c, LayoutBuilder::EdgeType::False);
+        builder->make_edge(b, c);
+        builder->make_edge(c, a);
+        return builder;
+    };
+
+    const auto expected = make_builder(10)->build();
+    ASSERT_FALSE(expected->get_stats().from_disk_cache);
+    ASSERT_EQ(cache.misses(), 1);
+    ASSERT_GT(cache.size(), 0);
+
+    auto cached = make_builder(10)->build();
+    ASSERT_TRUE(cached->get_stats().from_disk_cache);
+    ASSERT_EQ(cache.hits(), 1);
+
+    ASSERT_EQ(cached->get_width(), expected->get_width());
+    ASSERT_EQ(cached->get_height(), expected->get_height());
+    ASSERT_EQ(cached->get_stats().dummy_count,
+              expected->get_stats().dummy_count);
+    ASSERT_EQ(cached->freeze().get_label(0), "a");
+    for (size_t node = 0; node < 3; ++node) {
+        ASSERT_EQ(cached->get_coords(node), expected->get_coords(node));
+    }
+    for (size_t edge = 0; edge < 4; ++edge) {
+        ASSERT_EQ(cached->get_waypoints(edge).to_vector(),
+                  expected->get_waypoints(edge).to_vector());
+    }
+
+    // Other sizes are another layout
+    ASSERT_FALSE(make_builder(30)->build()->get_stats().from_disk_cache);
+    ASSERT_EQ(cache.misses(), 2);
+
+    // The labels are stored with the layout, other labels are another layout
+    const auto relabeled = make_builder(10, "b")->build();
+    ASSERT_FALSE(relabeled->get_stats().from_disk_cache);
+    ASSERT_EQ(make_builder(10, "b")->build()->freeze().get_label(0), "b");
+    ASSERT_EQ(cache.hits(), 2);
+
+    // A layout read from the cache can be edited
+    cached->update_node_size(1, 30, 20);
+    ASSERT_FALSE(cached->get_stats().from_disk_cache);
+    ASSERT_EQ(cached->node_rects()[1].width, 30);
+
+    // A file with invalid offsets is a miss, the first waypoint offset
+    // follows the 80 bytes header and the boxes of the 3 nodes
+    for (const auto& entry : std::filesystem::directory_iterator{directory}) {
+        auto file = std::fstream{entry.path(), std::ios::in | std::ios::out |
+                                                   std::ios::binary};
+        file.seekp(80 + (3 * sizeof(Rect)));
+        file.put('\xff');
+    }
+    ASSERT_FALSE(make_builder(10)->build()->get_stats().from_disk_cache);
+    ASSERT_EQ(cache.hits(), 2);
+    ASSERT_EQ(cache.misses(), 4);
+
+    // The replaced files no longer count
+    auto bytes = size_t{0};
+    for (const auto& entry : std::filesystem::directory_iterator{directory}) {
+        bytes += std::filesystem::file_size(entry.path());
+    }
+    ASSERT_EQ(cache.size(), bytes);
+
+    // A damaged file is a miss
+    for (const auto& entry : std::filesystem::directory_iterator{directory}) {
+        std::filesystem::resize_file(entry.path(), 10);
+    }
+    ASSERT_FALSE(make_builder(10)->build()->get_stats().from_disk_cache);
+    ASSERT_TRUE(make_builder(10)->build()->get_stats().from_disk_cache);
+
+    // The least recently used layouts are removed
+    auto small = DiskCache{directory, cache.size() / 2};
+    options    = LayoutOptions{.disk_cache = &small};
+    ASSERT_FALSE(make_builder(40)->build()->get_stats().from_disk_cache);
+    ASSERT_LE(small.size(), small.max_bytes());
+
+    small.clear();
+    ASSERT_TRUE(std::filesystem::is_empty(directory));
+    std::filesystem::remove_all(directory);
+}
+
+TEST(Triskel, LayoutFile) {
+    auto builder = make_layout_builder();
+
+    const auto a = builder->make_node("a");
+    const auto b = builder->make_node("bb\nbb");
+    const auto c = builder->make_node("c");
+
+    builder->make_edge(a, b, LayoutBuilder::EdgeType::True);
+    builder->make_edge(a, c, LayoutBuilder::EdgeType::False);
+    const auto removed = builder->make_edge(b, c);
+    builder->make_edge(c, a);
+
+    auto layout = builder->build();
+    layout->remove_edge(removed);
+    const auto frozen = layout->freeze();
+
+    const auto path = std::filesystem::temp_directory_path() /
+                      ("triskel_test_" +
+                       std::to_string(std::hash<std::thread::id>{}(
+                           std::this_thread::get_id())) +
+                       ".layout");
+
+    frozen.save(path);
+    {
+        const auto loaded = FrozenLayout::load(path);
+        ASSERT_EQ(loaded.node_count(), frozen.node_count());
+        ASSERT_EQ(loaded.edge_count(), frozen.edge_count());
+        ASSERT_EQ(loaded.get_width(), frozen.get_width());
+        ASSERT_EQ(loaded.get_height(), frozen.get_height());
+        ASSERT_EQ(loaded.get_stats().dummy_count,
+                  frozen.get_stats().dummy_count);
+
+        for (size_t node = 0; node < frozen.node_count(); ++node) {
+            ASSERT_EQ(loaded.get_coords(node), frozen.get_coords(node));
+            ASSERT_EQ(loaded.get_rect(node).width,
+                      frozen.get_rect(node).width);
+            ASSERT_EQ(loaded.get_label(node), frozen.get_label(node));
+        }
+
+        for (size_t edge = 0; edge < frozen.edge_count(); ++edge) {
+            ASSERT_EQ(loaded.get_waypoints(edge).to_vector(),
+                      frozen.get_waypoints(edge).to_vector());
+            ASSERT_EQ(loaded.get_edge_type(edge), frozen.get_edge_type(edge));
+        }
+        ASSERT_TRUE(loaded.get_waypoints(removed).empty());
+
+        // The copies share the mapped file
+        const auto copy = loaded;
+        ASSERT_EQ(copy.node_rects().data(), loaded.node_rects().data());
+    }
+
+    // The labels are optional
+    frozen.save(path, false);
+    {
+        const auto loaded = FrozenLayout::load(path);
+        ASSERT_EQ(loaded.get_label(b), "");
+        ASSERT_TRUE(loaded.labels().empty());
+        ASSERT_EQ(loaded.get_coords(b), frozen.get_coords(b));
+    }
+
+    std::filesystem::resize_file(path, std::filesystem::file_size(path) - 1);
+    ASSERT_THROW(auto l = FrozenLayout::load(path), std::invalid_argument);
+
+    {
+        auto out = std::ofstream{path, std::ios::binary | std::ios::trunc};
+        out << "not a layout file, but long enough to hold a header. "
+               "not a layout file, but long enough to hold a header.";
+    }
+    ASSERT_THROW(auto l = FrozenLayout::load(path), std::invalid_argument);
+
+    std::filesystem::remove(path);
+    ASSERT_THROW(auto l = FrozenLayout::load(path), std::invalid_argument);
+}
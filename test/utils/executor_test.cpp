@@ -0,0 +1,76 @@
+#include <triskel/utils/executor.hpp>
+#include <triskel/utils/thread_pool.hpp>
+
+#include <atomic>
+#include <cstddef>
+#include <memory>
+#include <stdexcept>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+// NOLINTNEXTLINE(google-build-using-namespace)
+using namespace triskel;
+
+TEST(Executor, ParallelFor) {
+    auto pool    = ThreadPool{4};
+    auto inline_ = InlineExecutor{};
+    auto counts  = std::vector<std::atomic<size_t>>(1000);
+
+    for (auto* executor : std::vector<Executor*>{&pool, &inline_}) {
+        executor->parallel_for(counts.size(),
+                               [&counts](size_t i) { counts[i]++; });
+    }
+
+    for (const auto& count : counts) {
+        ASSERT_EQ(count, 2);
+    }
+}
+
+TEST(Executor, NestedGroups) {
+    // The only worker waits for a group, it runs the group's tasks itself
+    auto pool = ThreadPool{1};
+    auto sum  = std::atomic<size_t>{0};
+
+    pool.submit([&pool, &sum] {
+        auto group = TaskGroup{pool, 4};
+        for (size_t i = 0; i < 10; ++i) {
+            group.run([&group, &sum, i] {
+                sum += i;
+                if (i == 0) {
+                    group.run([&sum] { sum += 100; });
+                }
+            });
+        }
+
+        group.wait();
+    });
+
+    pool.wait();
+    ASSERT_EQ(sum, 145);
+}
+
+TEST(Executor, Exceptions) {
+    auto pool  = ThreadPool{2};
+    auto group = TaskGroup{pool, 2};
+
+    group.run([] { throw std::runtime_error("task"); });
+    group.run([] {});
+    ASSERT_THROW(group.wait(), std::runtime_error);
+
+    auto inline_ = InlineExecutor{};
+    ASSERT_THROW(inline_.parallel_for(
+                     4, [](size_t) { throw std::runtime_error("body"); }),
+                 std::runtime_error);
+}
+
+TEST(Executor, DefaultExecutor) {
+    auto executor = std::make_shared<InlineExecutor>();
+
+    set_default_executor(executor);
+    ASSERT_EQ(default_executor(), executor);
+
+    set_default_executor(nullptr);
+    ASSERT_NE(default_executor(), executor);
+    ASSERT_GE(default_executor()->concurrency(), 1);
+}